@@ -0,0 +1,113 @@
+// Compares the structure-of-arrays batch API against calling the per-matrix
+// multiply in a loop, for 2x2, 3x3 and 4x4 operands.
+//
+// usage: bench_batch [count] [repeats]
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrix.h"
+#include "matrix_batch.h"
+#include "terasic_lib.h"
+
+#define DEFAULT_COUNT 1000000
+#define DEFAULT_REPEATS 5
+
+// Per-matrix path for order n: matrix_multiplication() itself for 2x2, an
+// n x n Matrix view through matrix_gemm() otherwise
+static void multiply_one(int n, int *c, int *a, int *b)
+{
+    Matrix A, B, C;
+
+    if (n == 2)
+    {
+        matrix_multiplication(c, a, b);
+        return;
+    }
+    matrix_view(&A, a, n, n, n);
+    matrix_view(&B, b, n, n, n);
+    matrix_view(&C, c, n, n, n);
+    matrix_gemm(&C, &A, &B);
+}
+
+static int run(int n, int count, int repeats)
+{
+    int elems = n * n;
+    int *a = (int *)malloc(sizeof(int) * elems * count);
+    int *b = (int *)malloc(sizeof(int) * elems * count);
+    int *c = (int *)malloc(sizeof(int) * elems * count);
+    int check[MATRIX_BATCH_MAX_N * MATRIX_BATCH_MAX_N];
+    MatrixBatch A, B, C;
+    long loop_us = 0, batch_us = 0, t;
+    int i, r, e, mismatches = 0;
+
+    if (a == NULL || b == NULL || c == NULL || matrix_batch_create(&A, n, count) != 0 ||
+        matrix_batch_create(&B, n, count) != 0 || matrix_batch_create(&C, n, count) != 0)
+    {
+        fprintf(stderr, "Error: could not allocate %d matrices of order %d\n", count, n);
+        return -1;
+    }
+
+    // 4-bit operands, the same range the board switches produce
+    for (i = 0; i < elems * count; i++)
+    {
+        a[i] = rand() & 0x0F;
+        b[i] = rand() & 0x0F;
+    }
+    for (i = 0; i < count; i++)
+    {
+        matrix_batch_load(&A, i, a + i * elems);
+        matrix_batch_load(&B, i, b + i * elems);
+    }
+
+    for (r = 0; r < repeats; r++)
+    {
+        t = get_tick_count();
+        for (i = 0; i < count; i++)
+            multiply_one(n, c + i * elems, a + i * elems, b + i * elems);
+        loop_us += get_tick_count() - t;
+
+        t = get_tick_count();
+        matrix_batch_multiply(&C, &A, &B);
+        batch_us += get_tick_count() - t;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        matrix_batch_store(&C, i, check);
+        for (e = 0; e < elems; e++)
+            mismatches += check[e] != c[i * elems + e];
+    }
+
+    printf("%dx%d  count %d  loop %8.2f Mmat/s  batch %8.2f Mmat/s  speedup %5.2fx%s\n",
+           n, n, count,
+           (double)count * repeats / (loop_us > 0 ? loop_us : 1),
+           (double)count * repeats / (batch_us > 0 ? batch_us : 1),
+           (double)loop_us / (batch_us > 0 ? batch_us : 1),
+           mismatches ? "  MISMATCH" : "");
+
+    matrix_batch_free(&A);
+    matrix_batch_free(&B);
+    matrix_batch_free(&C);
+    free(a);
+    free(b);
+    free(c);
+    return mismatches ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = argc > 1 ? atoi(argv[1]) : DEFAULT_COUNT;
+    int repeats = argc > 2 ? atoi(argv[2]) : DEFAULT_REPEATS;
+    int n, status = 0;
+
+    if (count <= 0 || repeats <= 0)
+    {
+        fprintf(stderr, "usage: %s [count] [repeats]\n", argv[0]);
+        return 1;
+    }
+    for (n = 2; n <= 4; n++)
+    {
+        if (run(n, count, repeats) != 0)
+            status = 1;
+    }
+    return status;
+}
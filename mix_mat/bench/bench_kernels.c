@@ -0,0 +1,550 @@
+// Sweeps every matrix kernel over a range of shapes and prints one record per
+// (kernel, instruction set, shape) as CSV or JSON for regression tracking:
+// GOPS (two ops per multiply-accumulate), cycles per multiply-accumulate and
+// cache misses per call. Cycles and misses come from perf_event_open(); where
+// the PMU is unavailable (no permission, no counters, a VM) timing falls back
+// to get_tick_count() alone, and cycles are estimated from --mhz when given.
+//
+// Counters follow the calling thread only, so the sweep runs the worker pool
+// with one thread unless --threads asks for more, in which case the PMU
+// columns are left empty and only GOPS is reported.
+//
+// usage: bench_kernels [--csv|--json] [--quick] [--threads N] [--mhz F] [--min-ms T]
+#define _GNU_SOURCE
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+#include "matrix_batch.h"
+#include "matrix_bool.h"
+#include "matrix_cache.h"
+#include "matrix_checked.h"
+#include "matrix_kernels.h"
+#include "matrix_mod.h"
+#include "matrix_pool.h"
+#include "matrix_q.h"
+#include "matrix_s8.h"
+#include "matrix_semiring.h"
+#include "matrix_sparse.h"
+#include "matrix_strassen.h"
+#include "terasic_lib.h"
+
+#define DEFAULT_MIN_MS 200
+#define QUICK_MIN_MS 20
+#define BATCH_COUNT 4096   // matrices per batched call
+#define SPARSE_PERCENT 5   // nonzeros of the sparse operand
+#define MOD_PRIME 998244353
+
+// Operands of every kernel; a kernel's setup fills the ones it uses
+typedef struct
+{
+    int m, n, k;
+    Matrix A, B, C;
+    MatrixS16 A16, B16, C16;
+    MatrixF Af, Bf, Cf;
+    MatrixS8 A8, B8;
+    MatrixQuant qa, qb;
+    MatrixBool Ab, Bb, Cb;
+    MatrixModulus mod;
+    MatrixBatch batch[3];
+    MatrixArena arena;
+} Operands;
+
+typedef struct
+{
+    const char *name;
+    const char *dtype;
+    int isa_sweep; // runs once per micro-kernel set
+    int max_dim;   // shapes with a larger dimension are skipped
+    int square;    // only square shapes
+    int (*setup)(Operands *o);
+    int (*run)(Operands *o);
+} Kernel;
+
+static void fill_i32(Matrix *m, int mask)
+{
+    int i;
+    for (i = 0; i < m->rows * m->cols; i++)
+        m->data[i] = rand() & mask;
+}
+
+static void fill_s16(MatrixS16 *m)
+{
+    int i;
+    for (i = 0; i < m->rows * m->cols; i++)
+        m->data[i] = (int16_t)((rand() & 0xFFFF) - 0x8000);
+}
+
+static int setup_i32(Operands *o)
+{
+    if (matrix_create(&o->A, o->m, o->k) != 0 || matrix_create(&o->B, o->k, o->n) != 0 ||
+        matrix_create(&o->C, o->m, o->n) != 0)
+        return -1;
+    fill_i32(&o->A, 0x0F);
+    fill_i32(&o->B, 0x0F);
+    return 0;
+}
+
+static int setup_s16(Operands *o)
+{
+    if (matrix_create_s16(&o->A16, o->m, o->k) != 0 || matrix_create_s16(&o->B16, o->k, o->n) != 0 ||
+        matrix_create(&o->C, o->m, o->n) != 0 || matrix_create_s16(&o->C16, o->m, o->n) != 0)
+        return -1;
+    fill_s16(&o->A16);
+    fill_s16(&o->B16);
+    return 0;
+}
+
+static int setup_f32(Operands *o)
+{
+    int i;
+    if (matrix_create_f32(&o->Af, o->m, o->k) != 0 || matrix_create_f32(&o->Bf, o->k, o->n) != 0 ||
+        matrix_create_f32(&o->Cf, o->m, o->n) != 0)
+        return -1;
+    for (i = 0; i < o->m * o->k; i++)
+        o->Af.data[i] = (float)rand() / RAND_MAX - 0.5f;
+    for (i = 0; i < o->k * o->n; i++)
+        o->Bf.data[i] = (float)rand() / RAND_MAX - 0.5f;
+    return 0;
+}
+
+static int setup_q31(Operands *o)
+{
+    if (setup_i32(o) != 0)
+        return -1;
+    fill_i32(&o->A, 0x7FFFFFFF);
+    fill_i32(&o->B, 0x7FFFFFFF);
+    return 0;
+}
+
+static int setup_s8(Operands *o)
+{
+    int i;
+    if (matrix_create_s8(&o->A8, o->m, o->k) != 0 || matrix_create_s8(&o->B8, o->k, o->n) != 0 ||
+        matrix_create(&o->C, o->m, o->n) != 0)
+        return -1;
+    for (i = 0; i < o->m * o->k; i++)
+        o->A8.data[i] = (int8_t)((rand() & 0xFF) - 0x80);
+    for (i = 0; i < o->k * o->n; i++)
+        o->B8.data[i] = (int8_t)((rand() & 0xFF) - 0x80);
+    o->qa.scale = o->qb.scale = 1.0f / 64;
+    o->qa.zero_point = 3;
+    o->qb.zero_point = -5;
+    return 0;
+}
+
+static int setup_mod(Operands *o)
+{
+    if (setup_i32(o) != 0 || matrix_modulus_init(&o->mod, MOD_PRIME) != 0)
+        return -1;
+    fill_i32(&o->A, 0x1FFFFFFF);
+    fill_i32(&o->B, 0x1FFFFFFF);
+    matrix_mod_canonical(&o->A, &o->mod);
+    matrix_mod_canonical(&o->B, &o->mod);
+    return 0;
+}
+
+static int setup_bool(Operands *o)
+{
+    if (setup_i32(o) != 0 || matrix_bool_create(&o->Ab, o->m, o->k) != 0 ||
+        matrix_bool_create(&o->Bb, o->k, o->n) != 0 || matrix_bool_create(&o->Cb, o->m, o->n) != 0)
+        return -1;
+    fill_i32(&o->A, 1);
+    fill_i32(&o->B, 1);
+    matrix_bool_from_dense(&o->Ab, &o->A);
+    matrix_bool_from_dense(&o->Bb, &o->B);
+    return 0;
+}
+
+static int setup_sparse(Operands *o)
+{
+    int i;
+    if (setup_i32(o) != 0)
+        return -1;
+    for (i = 0; i < o->m * o->k; i++)
+        o->A.data[i] = rand() % 100 < SPARSE_PERCENT ? (rand() & 0x0F) + 1 : 0;
+    return 0;
+}
+
+static int setup_batch(Operands *o)
+{
+    int *tmp = (int *)malloc(sizeof(int) * o->n * o->n);
+    int i, b, e;
+
+    if (tmp == NULL)
+        return -1;
+    for (b = 0; b < 3; b++)
+    {
+        if (matrix_batch_create(&o->batch[b], o->n, BATCH_COUNT) != 0)
+        {
+            free(tmp);
+            return -1;
+        }
+        for (i = 0; b < 2 && i < BATCH_COUNT; i++)
+        {
+            for (e = 0; e < o->n * o->n; e++)
+                tmp[e] = rand() & 0x0F;
+            matrix_batch_load(&o->batch[b], i, tmp);
+        }
+    }
+    free(tmp);
+    return 0;
+}
+
+static int run_demo(Operands *o)
+{
+    matrix_multiplication(o->C.data, o->A.data, o->B.data);
+    return 0;
+}
+
+// Repeats one operand pair, so every timed call is a cache hit
+static int run_cached(Operands *o)
+{
+    matrix_multiplication_cached(o->C.data, o->A.data, o->B.data);
+    return 0;
+}
+
+static int run_i32(Operands *o)
+{
+    return matrix_gemm(&o->C, &o->A, &o->B);
+}
+
+static int run_i32_t(Operands *o)
+{
+    // B read through swapped strides, as for an operand stored transposed
+    Matrix Bt;
+    matrix_view(&Bt, o->B.data, o->n, o->k, o->k);
+    return matrix_gemm_t(&o->C, &o->A, 0, &Bt, 1);
+}
+
+static int run_checked(Operands *o)
+{
+    return matrix_gemm_checked(&o->C, &o->A, &o->B, &o->arena);
+}
+
+// The first call grows the empty arena to the recursion's scratch; later
+// calls reuse it
+static int run_strassen(Operands *o)
+{
+    return matrix_strassen(&o->C, &o->A, &o->B, 0, &o->arena);
+}
+
+static int run_s16(Operands *o)
+{
+    return matrix_gemm_s16(&o->C, &o->A16, &o->B16);
+}
+
+static int run_f32(Operands *o)
+{
+    return matrix_gemm_f32(&o->Cf, &o->Af, &o->Bf);
+}
+
+static int run_q15(Operands *o)
+{
+    return matrix_gemm_q15(&o->C16, &o->A16, &o->B16, &o->arena);
+}
+
+static int run_q31(Operands *o)
+{
+    return matrix_gemm_q31(&o->C, &o->A, &o->B, &o->arena);
+}
+
+static int run_s8(Operands *o)
+{
+    return matrix_gemm_s8(&o->C, &o->A8, &o->qa, &o->B8, &o->qb, &o->arena);
+}
+
+static int run_mod(Operands *o)
+{
+    return matrix_gemm_mod(&o->C, &o->A, &o->B, &o->mod);
+}
+
+static int run_bool(Operands *o)
+{
+    return matrix_bool_multiply(&o->Cb, &o->Ab, &o->Bb, &o->arena);
+}
+
+static int run_min_plus(Operands *o)
+{
+    return matrix_gemm_min_plus(&o->C, &o->A, &o->B);
+}
+
+static int run_sparse(Operands *o)
+{
+    return matrix_multiply_auto(&o->C, &o->A, &o->B, &o->arena);
+}
+
+static int run_batch(Operands *o)
+{
+    return matrix_batch_multiply(&o->batch[2], &o->batch[0], &o->batch[1]);
+}
+
+static const Kernel kernels[] = {
+    {"matrix_multiplication", "i32", 0, 2, 1, setup_i32, run_demo},
+    {"matrix_multiplication_cached", "i32", 0, 2, 1, setup_i32, run_cached},
+    {"gemm", "i32", 1, 4096, 0, setup_i32, run_i32},
+    {"gemm_t", "i32", 1, 4096, 0, setup_i32, run_i32_t},
+    {"gemm_checked", "i32", 0, 4096, 0, setup_i32, run_checked},
+    {"strassen", "i32", 0, 4096, 1, setup_i32, run_strassen},
+    {"gemm_s16", "s16", 1, 4096, 0, setup_s16, run_s16},
+    {"gemm_f32", "f32", 1, 4096, 0, setup_f32, run_f32},
+    {"gemm_q15", "q15", 0, 4096, 0, setup_s16, run_q15},
+    {"gemm_q31", "q31", 0, 4096, 0, setup_q31, run_q31},
+    {"gemm_s8", "s8", 0, 4096, 0, setup_s8, run_s8},
+    {"gemm_mod", "mod_p", 0, 4096, 0, setup_mod, run_mod},
+    {"bool_multiply", "bit", 0, 4096, 0, setup_bool, run_bool},
+    {"gemm_min_plus", "i32", 0, 4096, 0, setup_i32, run_min_plus},
+    {"multiply_auto_sparse", "i32", 0, 4096, 0, setup_sparse, run_sparse},
+    {"batch_multiply", "i32", 0, MATRIX_BATCH_MAX_N, 1, setup_batch, run_batch},
+};
+
+// Square sizes, then shapes that stress one dimension
+static const int shapes[][3] = {
+    {2, 2, 2}, {3, 3, 3}, {4, 4, 4}, {8, 8, 8}, {16, 16, 16}, {32, 32, 32}, {64, 64, 64},
+    {128, 128, 128}, {256, 256, 256}, {512, 512, 512}, {1, 512, 512}, {512, 16, 512}, {16, 512, 512},
+};
+
+static const int quick_shapes[][3] = {
+    {2, 2, 2}, {4, 4, 4}, {8, 8, 8}, {64, 64, 64}, {256, 256, 256}, {16, 256, 256},
+};
+
+static const char *isa_names[] = {"scalar", "sse2", "avx2", "neon"};
+
+static void free_operands(Operands *o)
+{
+    int b;
+    if (o->A.data) matrix_free(&o->A);
+    if (o->B.data) matrix_free(&o->B);
+    if (o->C.data) matrix_free(&o->C);
+    if (o->A16.data) matrix_free_s16(&o->A16);
+    if (o->B16.data) matrix_free_s16(&o->B16);
+    if (o->C16.data) matrix_free_s16(&o->C16);
+    if (o->Af.data) matrix_free_f32(&o->Af);
+    if (o->Bf.data) matrix_free_f32(&o->Bf);
+    if (o->Cf.data) matrix_free_f32(&o->Cf);
+    if (o->A8.data) matrix_free_s8(&o->A8);
+    if (o->B8.data) matrix_free_s8(&o->B8);
+    if (o->Ab.data) matrix_bool_free(&o->Ab);
+    if (o->Bb.data) matrix_bool_free(&o->Bb);
+    if (o->Cb.data) matrix_bool_free(&o->Cb);
+    for (b = 0; b < 3; b++)
+        if (o->batch[b].data) matrix_batch_free(&o->batch[b]);
+}
+
+// Hardware counters of the calling thread; fd -1 where unavailable
+typedef struct
+{
+    int cycles;
+    int misses;
+} Pmu;
+
+static int perf_open(uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void pmu_start(const Pmu *p)
+{
+    if (p->cycles >= 0)
+    {
+        ioctl(p->cycles, PERF_EVENT_IOC_RESET, 0);
+        ioctl(p->cycles, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    if (p->misses >= 0)
+    {
+        ioctl(p->misses, PERF_EVENT_IOC_RESET, 0);
+        ioctl(p->misses, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static long long pmu_stop(int fd)
+{
+    uint64_t value;
+    if (fd < 0)
+        return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    return read(fd, &value, sizeof(value)) == (ssize_t)sizeof(value) ? (long long)value : -1;
+}
+
+typedef struct
+{
+    int json;
+    int threads;
+    double mhz;
+    long min_us;
+    int records;
+    Pmu pmu;
+} Config;
+
+static void emit(Config *cfg, const Kernel *kr, const char *isa, const Operands *o, long reps, long us,
+                 long long cycles, long long misses, const char *source)
+{
+    double macs = (double)o->m * o->n * o->k * reps;
+    double seconds = us / 1e6;
+    char cpm[32] = "", miss[32] = "";
+
+    if (kr->run == run_batch)
+        macs *= BATCH_COUNT;
+    if (cycles >= 0)
+        snprintf(cpm, sizeof(cpm), "%.4f", cycles / macs);
+    if (misses >= 0)
+        snprintf(miss, sizeof(miss), "%.1f", (double)misses / reps);
+
+    if (cfg->json)
+    {
+        printf("%s\n  {\"kernel\": \"%s\", \"isa\": \"%s\", \"dtype\": \"%s\", \"m\": %d, \"n\": %d, \"k\": %d, "
+               "\"threads\": %d, \"reps\": %ld, \"seconds\": %.6f, \"gops\": %.4f, \"cycles_per_mac\": %s, "
+               "\"cache_misses_per_call\": %s, \"cycles_source\": \"%s\"}",
+               cfg->records ? "," : "[", kr->name, isa, kr->dtype, o->m, o->n, o->k, cfg->threads, reps, seconds,
+               2.0 * macs / seconds / 1e9, cpm[0] ? cpm : "null", miss[0] ? miss : "null", source);
+    }
+    else
+    {
+        if (cfg->records == 0)
+            printf("kernel,isa,dtype,m,n,k,threads,reps,seconds,gops,cycles_per_mac,cache_misses_per_call,"
+                   "cycles_source\n");
+        printf("%s,%s,%s,%d,%d,%d,%d,%ld,%.6f,%.4f,%s,%s,%s\n", kr->name, isa, kr->dtype, o->m, o->n, o->k,
+               cfg->threads, reps, seconds, 2.0 * macs / seconds / 1e9, cpm, miss, source);
+    }
+    cfg->records++;
+    fflush(stdout);
+}
+
+// Times kr on the prepared operands: one warm-up call, then doubling
+// repetition counts until a run lasts at least min_us
+static int measure(Config *cfg, const Kernel *kr, const char *isa, Operands *o)
+{
+    long reps, r, us, t;
+    long long cycles, misses;
+    const char *source = "none";
+
+    if (kr->run(o) != 0)
+        return -1;
+    for (reps = 1;; reps *= 2)
+    {
+        pmu_start(&cfg->pmu);
+        t = get_tick_count();
+        for (r = 0; r < reps; r++)
+            kr->run(o);
+        us = get_tick_count() - t;
+        cycles = pmu_stop(cfg->pmu.cycles);
+        misses = pmu_stop(cfg->pmu.misses);
+        if (us >= cfg->min_us)
+            break;
+    }
+    if (cycles >= 0)
+        source = "pmu";
+    else if (cfg->mhz > 0)
+    {
+        cycles = (long long)(us * cfg->mhz);
+        source = "clock";
+    }
+    emit(cfg, kr, isa, o, reps, us > 0 ? us : 1, cycles, misses, source);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    Config cfg;
+    const int(*shape)[3] = shapes;
+    int nshapes = sizeof(shapes) / sizeof(shapes[0]);
+    char default_isa[16];
+    int i, s, v, status = 0;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.threads = 1;
+    cfg.min_us = DEFAULT_MIN_MS * 1000L;
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            cfg.json = 1;
+        else if (strcmp(argv[i], "--csv") == 0)
+            cfg.json = 0;
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            shape = quick_shapes;
+            nshapes = sizeof(quick_shapes) / sizeof(quick_shapes[0]);
+            cfg.min_us = QUICK_MIN_MS * 1000L;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            cfg.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mhz") == 0 && i + 1 < argc)
+            cfg.mhz = atof(argv[++i]);
+        else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc)
+            cfg.min_us = atol(argv[++i]) * 1000L;
+        else
+        {
+            fprintf(stderr, "usage: %s [--csv|--json] [--quick] [--threads N] [--mhz F] [--min-ms T]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (cfg.threads < 1 || cfg.min_us <= 0 || matrix_pool_init(cfg.threads) != 0)
+    {
+        fprintf(stderr, "Error: bad thread count or timing budget\n");
+        return 1;
+    }
+    cfg.pmu.cycles = cfg.pmu.misses = -1;
+    if (cfg.threads == 1)
+    {
+        cfg.pmu.cycles = perf_open(PERF_COUNT_HW_CPU_CYCLES);
+        cfg.pmu.misses = perf_open(PERF_COUNT_HW_CACHE_MISSES);
+    }
+    if (cfg.pmu.cycles < 0)
+        fprintf(stderr, "note: %s, timing with get_tick_count()%s\n",
+                cfg.threads == 1 ? "no PMU cycle counter" : "PMU counters need --threads 1",
+                cfg.mhz > 0 ? " and --mhz" : "");
+    snprintf(default_isa, sizeof(default_isa), "%s", matrix_kernels()->name);
+
+    for (i = 0; i < (int)(sizeof(kernels) / sizeof(kernels[0])); i++)
+    {
+        const Kernel *kr = &kernels[i];
+        for (s = 0; s < nshapes; s++)
+        {
+            Operands o;
+            int m = shape[s][0], n = shape[s][1], k = shape[s][2];
+
+            if (m > kr->max_dim || n > kr->max_dim || k > kr->max_dim || (kr->square && (m != n || n != k)))
+                continue;
+            memset(&o, 0, sizeof(o));
+            o.m = m;
+            o.n = n;
+            o.k = k;
+            if (matrix_arena_init(&o.arena, 0) != 0 || kr->setup(&o) != 0)
+            {
+                fprintf(stderr, "Error: cannot set up %s at %dx%dx%d\n", kr->name, m, n, k);
+                status = 1;
+            }
+            else if (!kr->isa_sweep)
+                status |= measure(&cfg, kr, default_isa, &o) != 0;
+            else
+            {
+                for (v = 0; v < (int)(sizeof(isa_names) / sizeof(isa_names[0])); v++)
+                    if (matrix_kernels_select(isa_names[v]) == 0)
+                        status |= measure(&cfg, kr, isa_names[v], &o) != 0;
+                matrix_kernels_select(default_isa);
+            }
+            free_operands(&o);
+            matrix_arena_destroy(&o.arena);
+        }
+    }
+    if (cfg.json)
+        printf("%s\n", cfg.records ? "\n]" : "[]");
+    return status;
+}
@@ -0,0 +1,135 @@
+// Out-of-core GEMM over tiled matrix files: writes random n x n operands to
+// 'dir', multiplies them with matrix_file_gemm() and reports the arithmetic
+// rate next to the file bandwidth it implies. Pick n so the three files
+// exceed RAM to measure the disk-bound case; the page cache is not dropped
+// between the write and the product, so smaller runs measure the cached case.
+//
+// usage: bench_ooc [n] [tile] [dir]
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "matrix.h"
+#include "matrix_file.h"
+#include "terasic_lib.h"
+
+#define DEFAULT_N 2048
+#define SAMPLES 64
+
+static void path_of(char *path, size_t size, const char *dir, const char *name)
+{
+    snprintf(path, size, "%s/%s", dir, name);
+}
+
+// 4-bit entries, one tile row at a time so the operand never has to fit in
+// RAM
+static int write_random(const char *path, int n, int tile)
+{
+    MatrixFile f;
+    MatrixFileSpan s;
+    Matrix t;
+    int ti, tj, i, j;
+
+    if (matrix_file_create(&f, path, n, n, tile) != 0)
+        return -1;
+    for (ti = 0; ti < f.tile_rows; ti++)
+    {
+        if (matrix_file_map(&f, &s, ti, 0, f.tile_cols) != 0)
+        {
+            matrix_file_close(&f);
+            return -1;
+        }
+        for (tj = 0; tj < f.tile_cols; tj++)
+        {
+            matrix_file_span_tile(&s, &t, tj);
+            for (i = 0; i < tile && ti * tile + i < n; i++)
+                for (j = 0; j < tile && tj * tile + j < n; j++)
+                    MAT_AT(&t, i, j) = rand() & 0x0F;
+        }
+        matrix_file_unmap(&s);
+    }
+    return matrix_file_close(&f);
+}
+
+// One entry read straight from the file
+static int entry(const MatrixFile *f, int i, int j)
+{
+    int t = f->tile;
+    int32_t v = 0;
+    off_t at = (off_t)matrix_file_tile_offset(f, i / t, j / t) + ((off_t)(i % t) * t + j % t) * sizeof(v);
+
+    if (pread(f->fd, &v, sizeof(v), at) != (ssize_t)sizeof(v))
+        return -1;
+    return v;
+}
+
+// Spot-checks C against dot products read straight from the files
+static int check(const MatrixFile *C, const MatrixFile *A, const MatrixFile *B)
+{
+    int s, k, bad = 0;
+
+    for (s = 0; s < SAMPLES; s++)
+    {
+        int i = rand() % C->rows, j = rand() % C->cols, sum = 0;
+        for (k = 0; k < A->cols; k++)
+            sum += entry(A, i, k) * entry(B, k, j);
+        bad += sum != entry(C, i, j);
+    }
+    return bad;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_N;
+    int tile = argc > 2 ? atoi(argv[2]) : MATRIX_FILE_TILE;
+    const char *dir = argc > 3 ? argv[3] : ".";
+    char pa[4096], pb[4096], pc[4096];
+    MatrixFile A, B, C;
+    double seconds, bytes;
+    long t;
+    int bad;
+
+    if (n <= 0 || tile <= 0 || tile % MATRIX_FILE_TILE_UNIT != 0)
+    {
+        fprintf(stderr, "usage: %s [n] [tile, a multiple of %d] [dir]\n", argv[0], MATRIX_FILE_TILE_UNIT);
+        return 1;
+    }
+    path_of(pa, sizeof(pa), dir, "ooc_a.mat");
+    path_of(pb, sizeof(pb), dir, "ooc_b.mat");
+    path_of(pc, sizeof(pc), dir, "ooc_c.mat");
+
+    if (write_random(pa, n, tile) != 0 || write_random(pb, n, tile) != 0 ||
+        matrix_file_open(&A, pa, 0) != 0 || matrix_file_open(&B, pb, 0) != 0 ||
+        matrix_file_create(&C, pc, n, n, tile) != 0)
+    {
+        fprintf(stderr, "Error: could not create the operand files in %s\n", dir);
+        return 1;
+    }
+
+    t = get_tick_count();
+    if (matrix_file_gemm(&C, &A, &B) != 0 || matrix_file_close(&C) != 0)
+    {
+        fprintf(stderr, "Error: out-of-core product failed\n");
+        return 1;
+    }
+    seconds = (get_tick_count() - t) / 1e6;
+
+    // A is read once, B once per tile row of C, C written once
+    bytes = (double)A.tile_bytes * ((double)A.tile_rows * A.tile_cols +
+                                    (double)B.tile_rows * B.tile_cols * A.tile_rows +
+                                    (double)A.tile_rows * B.tile_cols);
+    matrix_file_open(&C, pc, 0);
+    bad = check(&C, &A, &B);
+    printf("n %d  tile %d  %.2f s  %.2f GOPS  %.1f MB/s tile traffic%s\n", n, tile, seconds,
+           2.0 * n * n * (double)n / (seconds > 0 ? seconds : 1e-9) / 1e9,
+           bytes / (seconds > 0 ? seconds : 1e-9) / 1e6, bad ? "  MISMATCH" : "");
+
+    matrix_file_close(&A);
+    matrix_file_close(&B);
+    matrix_file_close(&C);
+    unlink(pa);
+    unlink(pb);
+    unlink(pc);
+    return bad ? 1 : 0;
+}
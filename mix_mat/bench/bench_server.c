@@ -0,0 +1,143 @@
+// Load generator for the matrix service: 'clients' threads each open a
+// connection and issue 'requests' n x n products back to back, timing every
+// round trip. Reports throughput and the p50 / p99 latency over all requests,
+// and checks a sample of the answers. Start the server first, e.g.
+//   mix_mat_headless --serve /tmp/mix_mat.sock
+//
+// usage: bench_server <socket> [clients] [requests] [n]
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "matrix_server.h"
+#include "terasic_lib.h"
+
+#define DEFAULT_CLIENTS 16
+#define DEFAULT_REQUESTS 10000
+#define DEFAULT_N 4
+#define CHECK_EVERY 97
+
+typedef struct
+{
+    const char *path;
+    int requests;
+    int n;
+    unsigned seed;
+    long *latency_us; // one per request
+    int errors;
+} Client;
+
+static int mismatches(const MatrixJob *job)
+{
+    int i, j, k, bad = 0;
+
+    for (i = 0; i < job->m; i++)
+    {
+        for (j = 0; j < job->n; j++)
+        {
+            int sum = 0;
+            for (k = 0; k < job->k; k++)
+                sum += job->a[i * job->k + k] * job->b[k * job->n + j];
+            bad += sum != job->c[i * job->n + j];
+        }
+    }
+    return bad;
+}
+
+static void *client_main(void *arg)
+{
+    Client *cl = (Client *)arg;
+    MatrixJob job;
+    int fd, r, i;
+    long t;
+
+    matrix_job_init(&job);
+    fd = matrix_client_connect(cl->path);
+    if (fd < 0 || matrix_job_reserve(&job, cl->n, cl->n, cl->n) != 0)
+    {
+        cl->errors = cl->requests;
+        return NULL;
+    }
+    for (r = 0; r < cl->requests; r++)
+    {
+        // 4-bit operands, the same range the board switches produce
+        for (i = 0; i < cl->n * cl->n; i++)
+        {
+            job.a[i] = rand_r(&cl->seed) & 0x0F;
+            job.b[i] = rand_r(&cl->seed) & 0x0F;
+        }
+        t = get_tick_count();
+        if (matrix_client_call(fd, (uint32_t)r, &job) != 0 || job.status != 0)
+        {
+            cl->errors += cl->requests - r;
+            break;
+        }
+        cl->latency_us[r] = get_tick_count() - t;
+        if (r % CHECK_EVERY == 0 && mismatches(&job) != 0)
+            cl->errors++;
+    }
+    close(fd);
+    matrix_job_free(&job);
+    return NULL;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+    int clients = argc > 2 ? atoi(argv[2]) : DEFAULT_CLIENTS;
+    int requests = argc > 3 ? atoi(argv[3]) : DEFAULT_REQUESTS;
+    int n = argc > 4 ? atoi(argv[4]) : DEFAULT_N;
+    Client *cl;
+    pthread_t *threads;
+    long *latency, total, t;
+    int i, errors = 0;
+
+    if (argc < 2 || clients <= 0 || requests <= 0 || n <= 0 || n > MATRIX_STREAM_MAX_DIM)
+    {
+        fprintf(stderr, "usage: %s <socket> [clients] [requests] [n]\n", argv[0]);
+        return 1;
+    }
+    total = (long)clients * requests;
+    cl = (Client *)calloc(clients, sizeof(Client));
+    threads = (pthread_t *)malloc(sizeof(pthread_t) * clients);
+    latency = (long *)calloc(total, sizeof(long));
+    if (cl == NULL || threads == NULL || latency == NULL)
+    {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+
+    t = get_tick_count();
+    for (i = 0; i < clients; i++)
+    {
+        cl[i].path = argv[1];
+        cl[i].requests = requests;
+        cl[i].n = n;
+        cl[i].seed = i + 1;
+        cl[i].latency_us = latency + (long)i * requests;
+        pthread_create(&threads[i], NULL, client_main, &cl[i]);
+    }
+    for (i = 0; i < clients; i++)
+    {
+        pthread_join(threads[i], NULL);
+        errors += cl[i].errors;
+    }
+    t = get_tick_count() - t;
+
+    qsort(latency, total, sizeof(long), compare_long);
+    printf("%dx%d  clients %d  requests %ld  %.0f req/s  p50 %ld us  p99 %ld us%s\n", n, n, clients, total,
+           (double)total * 1e6 / (t > 0 ? t : 1), latency[total / 2], latency[total * 99 / 100],
+           errors ? "  ERRORS" : "");
+    if (errors)
+        fprintf(stderr, "%d failed or wrong requests\n", errors);
+
+    free(cl);
+    free(threads);
+    free(latency);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// Measures the shared-memory job ring: forks a consumer process serving the
+// ring, then from the parent times (1) the client-side cost of submitting a
+// 2x2 job (acquire, fill in place, publish), (2) the full round trip to its
+// result, and (3) pipelined throughput with the ring kept full.
+//
+// usage: bench_shm [jobs] [n]
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "matrix_shm.h"
+
+#define DEFAULT_JOBS 200000
+#define SLOTS 64
+
+static long long now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static int compare_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static void fill(Matrix *A, Matrix *B, int seed)
+{
+    int i;
+    for (i = 0; i < A->rows * A->cols; i++)
+        A->data[i] = (seed + i) & 0x0F;
+    for (i = 0; i < B->rows * B->cols; i++)
+        B->data[i] = (seed * 3 + i) & 0x0F;
+}
+
+static int check(const Matrix *C, int n, int seed)
+{
+    int i, j, k, bad = 0;
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+        {
+            int sum = 0;
+            for (k = 0; k < n; k++)
+                sum += ((seed + i * n + k) & 0x0F) * ((seed * 3 + k * n + j) & 0x0F);
+            bad += sum != MAT_AT(C, i, j);
+        }
+    return bad;
+}
+
+int main(int argc, char *argv[])
+{
+    int jobs = argc > 1 ? atoi(argv[1]) : DEFAULT_JOBS;
+    int n = argc > 2 ? atoi(argv[2]) : 2;
+    char name[64];
+    long long *submit, *round, t0, t1;
+    long long pipelined;
+    MatrixShm shm;
+    Matrix A, B, C;
+    pid_t child;
+    int j, done, bad = 0;
+
+    if (jobs <= 0 || n <= 0 || n > 64)
+    {
+        fprintf(stderr, "usage: %s [jobs] [n <= 64]\n", argv[0]);
+        return 1;
+    }
+    snprintf(name, sizeof(name), "bench_shm_%d", (int)getpid());
+    if (matrix_shm_create(&shm, name, SLOTS, 3 * 64 * 64 * sizeof(int) + 192) != 0)
+    {
+        fprintf(stderr, "Error: cannot create the ring\n");
+        return 1;
+    }
+    child = fork();
+    if (child == 0)
+    {
+        matrix_shm_serve(&shm, NULL);
+        _exit(0);
+    }
+
+    submit = (long long *)malloc(sizeof(long long) * jobs);
+    round = (long long *)malloc(sizeof(long long) * jobs);
+    if (child < 0 || submit == NULL || round == NULL)
+    {
+        fprintf(stderr, "Error: cannot start the consumer\n");
+        return 1;
+    }
+
+    // One job in flight at a time
+    for (j = 0; j < jobs; j++)
+    {
+        t0 = now_ns();
+        matrix_shm_acquire(&shm, &A, &B, n, n, n);
+        fill(&A, &B, j);
+        matrix_shm_submit(&shm);
+        t1 = now_ns();
+        if (matrix_shm_wait(&shm, &C) != 0)
+            bad++;
+        round[j] = now_ns() - t0;
+        submit[j] = t1 - t0;
+        if (j % 101 == 0)
+            bad += check(&C, n, j);
+        matrix_shm_release(&shm);
+    }
+
+    // Ring kept full: submit whenever a slot is free, reap as results land
+    t0 = now_ns();
+    for (j = 0, done = 0; done < jobs;)
+    {
+        while (j < jobs && matrix_shm_acquire(&shm, &A, &B, n, n, n) == 0)
+        {
+            fill(&A, &B, j++);
+            matrix_shm_submit(&shm);
+        }
+        if (matrix_shm_wait(&shm, &C) != 0)
+            bad++;
+        matrix_shm_release(&shm);
+        done++;
+    }
+    pipelined = now_ns() - t0;
+
+    matrix_shm_stop(&shm);
+    waitpid(child, NULL, 0);
+    matrix_shm_detach(&shm);
+
+    qsort(submit, jobs, sizeof(long long), compare_ll);
+    qsort(round, jobs, sizeof(long long), compare_ll);
+    printf("%dx%d  jobs %d  submit p50 %lld ns p99 %lld ns  round trip p50 %lld ns p99 %lld ns  "
+           "pipelined %.0f ns/job%s\n",
+           n, n, jobs, submit[jobs / 2], submit[(long)jobs * 99 / 100], round[jobs / 2],
+           round[(long)jobs * 99 / 100], (double)pipelined / jobs, bad ? "  MISMATCH" : "");
+    free(submit);
+    free(round);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+// Picks the Strassen-Winograd crossover for this machine: for each order n up
+// to max_n, times matrix_gemm() and matrix_strassen() with every candidate
+// crossover below n (best of REPS runs, results checked against the GEMM),
+// then reports the crossover that was fastest at the largest order. Run it
+// on the HPS and on the host; the two differ because the A9's NEON GEMM is
+// relatively slower next to the additions than an AVX2 one.
+//
+// usage: bench_strassen [max_n]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix.h"
+#include "matrix_strassen.h"
+#include "terasic_lib.h"
+
+#define DEFAULT_MAX_N 1024
+#define REPS 3
+
+static const int orders[] = {192, 256, 384, 512, 767, 768, 1024, 1536, 2048};
+static const int crossovers[] = {32, 64, 128, 192, 256, 384, 512};
+
+// Best of REPS runs in microseconds; crossover -1 times matrix_gemm()
+static long best_us(Matrix *C, const Matrix *A, const Matrix *B, int crossover, MatrixArena *arena)
+{
+    long best = -1, t;
+    int r;
+
+    for (r = 0; r < REPS; r++)
+    {
+        t = get_tick_count();
+        if (crossover < 0)
+            matrix_gemm(C, A, B);
+        else
+            matrix_strassen(C, A, B, crossover, arena);
+        t = get_tick_count() - t;
+        if (best < 0 || t < best)
+            best = t;
+    }
+    return best > 0 ? best : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_n = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_N;
+    int o, x, i, n, best_x = -1, mismatches = 0;
+    long gemm_us, us, best;
+    Matrix A, B, C, R;
+    MatrixArena arena;
+
+    if (max_n < orders[0])
+    {
+        fprintf(stderr, "usage: %s [max_n >= %d]\n", argv[0], orders[0]);
+        return 1;
+    }
+    matrix_arena_init(&arena, 0);
+    printf("%6s %10s %10s %8s %8s\n", "n", "crossover", "ms", "GOPS", "speedup");
+    for (o = 0; o < (int)(sizeof(orders) / sizeof(orders[0])) && orders[o] <= max_n; o++)
+    {
+        n = orders[o];
+        if (matrix_create(&A, n, n) != 0 || matrix_create(&B, n, n) != 0 || matrix_create(&C, n, n) != 0 ||
+            matrix_create(&R, n, n) != 0)
+        {
+            fprintf(stderr, "Error: out of memory at n = %d\n", n);
+            return 1;
+        }
+        for (i = 0; i < n * n; i++)
+        {
+            A.data[i] = (rand() & 0xFF) - 0x80;
+            B.data[i] = (rand() & 0xFF) - 0x80;
+        }
+        // The workspace is reserved once, so the timed runs never allocate
+        matrix_arena_reset(&arena);
+        matrix_arena_reserve(&arena, matrix_strassen_scratch(n, crossovers[0]));
+
+        gemm_us = best_us(&R, &A, &B, -1, NULL);
+        printf("%6d %10s %10.2f %8.2f %8.2f\n", n, "gemm", gemm_us / 1e3, 2.0 * n * n * n / gemm_us / 1e3, 1.0);
+        best = gemm_us;
+        best_x = -1;
+        for (x = 0; x < (int)(sizeof(crossovers) / sizeof(crossovers[0])) && crossovers[x] < n; x++)
+        {
+            us = best_us(&C, &A, &B, crossovers[x], &arena);
+            if (memcmp(C.data, R.data, sizeof(int) * n * n) != 0)
+                mismatches++;
+            printf("%6d %10d %10.2f %8.2f %8.2f%s\n", n, crossovers[x], us / 1e3, 2.0 * n * n * n / us / 1e3,
+                   (double)gemm_us / us, memcmp(C.data, R.data, sizeof(int) * n * n) ? "  MISMATCH" : "");
+            if (us < best)
+            {
+                best = us;
+                best_x = crossovers[x];
+            }
+        }
+        fflush(stdout);
+        matrix_free(&A);
+        matrix_free(&B);
+        matrix_free(&C);
+        matrix_free(&R);
+    }
+    matrix_arena_destroy(&arena);
+
+    if (best_x < 0)
+        printf("matrix_gemm() was fastest at every order; no crossover helps up to n = %d\n", max_n);
+    else
+        printf("recommended crossover: %d (fastest at the largest order)\n", best_x);
+    return mismatches ? 1 : 0;
+}
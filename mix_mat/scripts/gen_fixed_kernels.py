@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# Generates src/matrix_fixed_gen.c: fully unrolled int kernels for the product
+# shapes listed in SHAPES, plus the matrix_fixed_lookup() dispatch switch
+# declared in src/matrix_fixed.h. Run by the Makefile; writes to stdout.
+#
+# usage: gen_fixed_kernels.py > src/matrix_fixed_gen.c
+
+import sys
+
+# (M, K, N): C is M x N, A is M x K, B is K x N
+SHAPES = [
+    (2, 2, 2),
+    (3, 3, 3),
+    (4, 4, 4),
+    (8, 8, 8),
+    (4, 8, 4),  # 4x8 times 8x4
+    (8, 4, 8),  # 8x4 times 4x8
+]
+
+
+def kernel_name(m, k, n):
+    return "fixed_%dx%dx%d" % (m, k, n)
+
+
+def emit_kernel(out, m, k, n):
+    out.append("static void %s(int *c, int ldc, const int *a, int lda, const int *b, int ldb)" % kernel_name(m, k, n))
+    out.append("{")
+    # All of B is loaded once; each row of A is loaded just before its row of C
+    for p in range(k):
+        out.append("    const int " + ", ".join("b%d_%d = b[%d * ldb + %d]" % (p, j, p, j) for j in range(n)) + ";")
+    for i in range(m):
+        out.append("    {")
+        out.append("        const int " + ", ".join("a%d = a[%d * lda + %d]" % (p, i, p) for p in range(k)) + ";")
+        for j in range(n):
+            terms = " + ".join("a%d * b%d_%d" % (p, p, j) for p in range(k))
+            out.append("        c[%d * ldc + %d] = %s;" % (i, j, terms))
+        out.append("    }")
+    out.append("}")
+    out.append("")
+
+
+def main():
+    out = []
+    out.append("// Generated by scripts/gen_fixed_kernels.py -- do not edit.")
+    out.append("#include \"matrix_fixed.h\"")
+    out.append("")
+    for m, k, n in SHAPES:
+        emit_kernel(out, m, k, n)
+
+    out.append("const MatrixFixedShape matrix_fixed_shapes[] = {")
+    for m, k, n in SHAPES:
+        out.append("    {%d, %d, %d, %s}," % (m, k, n, kernel_name(m, k, n)))
+    out.append("};")
+    out.append("const int matrix_fixed_shape_count = %d;" % len(SHAPES))
+    out.append("")
+
+    out.append("MatrixFixedKernel matrix_fixed_lookup(int m, int k, int n)")
+    out.append("{")
+    out.append("    if (m <= 0 || k <= 0 || n <= 0 || m > 255 || k > 255 || n > 255)")
+    out.append("        return NULL;")
+    out.append("    switch ((m << 16) | (k << 8) | n)")
+    out.append("    {")
+    for m, k, n in SHAPES:
+        out.append("    case (%d << 16) | (%d << 8) | %d:" % (m, k, n))
+        out.append("        return %s;" % kernel_name(m, k, n))
+    out.append("    default:")
+    out.append("        return NULL;")
+    out.append("    }")
+    out.append("}")
+
+    sys.stdout.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
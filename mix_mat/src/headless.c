@@ -0,0 +1,21 @@
+// Host build of the board program's headless modes: answers a stream of
+// matrix jobs from a file or stdin (matrix_stream.h), or serves them on a
+// Unix domain socket (matrix_server.h) or a shared-memory ring (matrix_shm.h),
+// without touching /dev/mem.
+//
+// usage: mix_mat_headless [file|-]
+//        mix_mat_headless --serve <socket path>
+//        mix_mat_headless --shm <name> [slots] [slot bytes]
+#include <string.h>
+#include "matrix_server.h"
+#include "matrix_shm.h"
+#include "matrix_stream.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0)
+        return matrix_server_main(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "--shm") == 0)
+        return matrix_shm_main(argc - 1, argv + 1);
+    return matrix_stream_main(argc, argv);
+}
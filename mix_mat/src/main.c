@@ -1,10 +1,15 @@
 #define _DEFAULT_SOURCE
 
+#include <string.h>
 #include "terasic_os_includes.h"
 #include "LCD_Lib.h"
 #include "lcd_graphic.h"
 #include "font.h"
 #include "gameLogic.h"
+#include "matrix.h"
+#include "matrix_server.h"
+#include "matrix_shm.h"
+#include "matrix_stream.h"
 #include "address_map_arm.h"
 
 // Define hardware register constants
@@ -33,8 +38,7 @@ void print_matrix_multiplication(LCD_CANVAS *canvas, int *result);
 void cleanup(void *virtual_base, int fd, LCD_CANVAS *canvas);
 void clearNumbers(LCD_CANVAS *canvas);
 void displayGridOnLCD(LCD_CANVAS *canvas);
-void matrix_multiplication(int *result, int *matrixA, int *matrixB);
-void storeMatrixValues(int switches_input, int table_index, int *matrixA, int *matrixB);
+void storeMatrixValues(int switches_input, int table_index, int *matrixA, int *matrixB, int *result);
 void printNumberOnLCD(LCD_CANVAS *canvas, int switches_input, int table_index);
 
 // Union representing the switches
@@ -52,14 +56,28 @@ typedef union
 } Switches;
 
 // Main function - entry point of the program
-int main()
+// usage: mix_mat                 interactive board demo
+//        mix_mat --batch [file]  answer a matrix job stream, no board I/O
+//        mix_mat --serve <path>  serve multiplies on a Unix domain socket
+//        mix_mat --shm <name>    serve a shared-memory job ring
+int main(int argc, char *argv[])
 {
     LCD_CANVAS LcdCanvas;
 
+    // Headless modes never open /dev/mem, so they also run off the board
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0)
+        return matrix_stream_main(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0)
+        return matrix_server_main(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "--shm") == 0)
+        return matrix_shm_main(argc - 1, argv + 1);
+
     // matrix_multiplication varibles
-    int matrixA[4]; // Entries for the first matrix
-    int matrixB[4]; // Entries for the second matrix
-    int result[4];
+    // result is kept equal to matrixA * matrixB as entries are stored, so all
+    // three start at zero
+    int matrixA[4] = {0}; // Entries for the first matrix
+    int matrixB[4] = {0}; // Entries for the second matrix
+    int result[4] = {0};
 
     // Initialize hardware
     if (initialize_hardware() == -1)
@@ -121,15 +139,14 @@ int main()
         {
             if (table_index < 8)
             {
-                storeMatrixValues((int)(currentSwitchState), table_index, matrixA, matrixB);
+                storeMatrixValues((int)(currentSwitchState), table_index, matrixA, matrixB, result);
                 printNumberOnLCD(&LcdCanvas, (int)(currentSwitchState), table_index);
                 table_index++;
                 usleep(DEBOUNCE_INTERVAL); // Sleep to debounce
             }
             else
             {
-                // Handle matrix multiplication
-                matrix_multiplication(result, matrixA, matrixB);
+                // The product is already current, see storeMatrixValues()
                 print_matrix_multiplication(&LcdCanvas, result);
             }
         }
@@ -246,27 +263,6 @@ void drawGrid(LCD_CANVAS *canvas)
     }
 }
 
-// Function to perform matrix multiplication for two 2x2 matrices and store the result in a provided array.
-void matrix_multiplication(int *result, int *matrixA, int *matrixB)
-{
-    // Compute the element at the first row, first column of the result matrix.
-    result[0] = matrixA[0] * matrixB[0] + matrixA[1] * matrixB[2]; // A[1,1] * B[1,1] + A[1,2] * B[2,1]
-
-    // Compute the element at the first row, second column of the result matrix.
-    result[1] = matrixA[0] * matrixB[1] + matrixA[1] * matrixB[3]; // A[1,1] * B[1,2] + A[1,2] * B[2,2]
-
-    // Compute the element at the second row, first column of the result matrix.
-    result[2] = matrixA[2] * matrixB[0] + matrixA[3] * matrixB[2]; // A[2,1] * B[1,1] + A[2,2] * B[2,1]
-
-    // Compute the element at the second row, second column of the result matrix.
-    result[3] = matrixA[2] * matrixB[1] + matrixA[3] * matrixB[3]; // A[2,1] * B[1,2] + A[2,2] * B[2,2]
-
-    // The resulting 2x2 matrix is stored in 'result' in row-major order:
-    // [ result[0] result[1] ]
-    // [ result[2] result[3] ]
-}
-
-
 // Function to display the result of a 2x2 matrix multiplication on the LCD
 void print_matrix_multiplication(LCD_CANVAS *canvas, int *result)
 {
@@ -302,8 +298,10 @@ void print_matrix_multiplication(LCD_CANVAS *canvas, int *result)
     DRAW_Refresh(canvas);
 }
 
-void storeMatrixValues(int switches_input, int table_index, int *matrixA, int *matrixB)
+void storeMatrixValues(int switches_input, int table_index, int *matrixA, int *matrixB, int *result)
 {
+    Matrix A, B, C;
+
     // Custom mapping array to order indices as per your specification
     int custom_order[] = {0, 1, 4, 5, 2, 3, 6, 7};
 
@@ -317,14 +315,19 @@ void storeMatrixValues(int switches_input, int table_index, int *matrixA, int *m
     // Determine the correct position in the matrix arrays based on the custom mapping
     int mapped_index = custom_order[table_index];
 
-    // Store the input in the appropriate matrix array
+    // Store the input in the appropriate matrix array and apply the change to
+    // the live product, so result never needs a full recompute
+    matrix_view(&A, matrixA, 2, 2, 2);
+    matrix_view(&B, matrixB, 2, 2, 2);
+    matrix_view(&C, result, 2, 2, 2);
     if (mapped_index < 4)
     {
-        matrixA[mapped_index] = switches_input; // Store in matrixA for indices 0-3
+        matrix_update_a(&C, &A, &B, mapped_index / 2, mapped_index % 2, switches_input); // Store in matrixA for indices 0-3
     }
     else
     {
-        matrixB[mapped_index - 4] = switches_input; // Store in matrixB for indices 4-7, adjusting index by subtracting 4
+        mapped_index -= 4; // Store in matrixB for indices 4-7, adjusting index by subtracting 4
+        matrix_update_b(&C, &A, &B, mapped_index / 2, mapped_index % 2, switches_input);
     }
 }
 
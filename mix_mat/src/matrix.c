@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+#include "matrix_kernels.h"
+#include "matrix_pool.h"
+#include "matrix_fixed.h"
+
+// Allocates a rows x cols matrix with 64-byte aligned, zeroed storage
+int matrix_create(Matrix *m, int rows, int cols)
+{
+    void *data = NULL;
+    size_t bytes = (size_t)rows * (size_t)cols * sizeof(int);
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        return -1;
+    memset(data, 0, bytes);
+
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = (int *)data;
+    return 0;
+}
+
+// Releases storage obtained from matrix_create
+void matrix_free(Matrix *m)
+{
+    free(m->data);
+    m->data = NULL;
+    m->rows = 0;
+    m->cols = 0;
+    m->stride = 0;
+}
+
+// Wraps caller-owned storage (for example the int[4] arrays in main.c) as a Matrix
+void matrix_view(Matrix *m, int *data, int rows, int cols, int stride)
+{
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = stride;
+    m->data = data;
+}
+
+// Describes the rows x cols block of 'm' whose top-left element is (row, col)
+void matrix_submatrix(Matrix *sub, const Matrix *m, int row, int col, int rows, int cols)
+{
+    sub->rows = rows;
+    sub->cols = cols;
+    sub->stride = m->stride;
+    sub->data = m->data + row * m->stride + col;
+}
+
+void matrix_zero(Matrix *m)
+{
+    int i;
+    for (i = 0; i < m->rows; i++)
+    {
+        memset(m->data + i * m->stride, 0, (size_t)m->cols * sizeof(int));
+    }
+}
+
+int matrix_copy(Matrix *dst, const Matrix *src)
+{
+    int i;
+    if (dst->rows != src->rows || dst->cols != src->cols)
+        return -1;
+    for (i = 0; i < src->rows; i++)
+    {
+        memmove(dst->data + i * dst->stride, src->data + i * src->stride, (size_t)src->cols * sizeof(int));
+    }
+    return 0;
+}
+
+int matrix_create_s16(MatrixS16 *m, int rows, int cols)
+{
+    void *data = NULL;
+    size_t bytes = (size_t)rows * (size_t)cols * sizeof(int16_t);
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        return -1;
+    memset(data, 0, bytes);
+
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = (int16_t *)data;
+    return 0;
+}
+
+void matrix_free_s16(MatrixS16 *m)
+{
+    free(m->data);
+    m->data = NULL;
+    m->rows = m->cols = m->stride = 0;
+}
+
+int matrix_create_f32(MatrixF *m, int rows, int cols)
+{
+    void *data = NULL;
+    size_t bytes = (size_t)rows * (size_t)cols * sizeof(float);
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        return -1;
+    memset(data, 0, bytes);
+
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = (float *)data;
+    return 0;
+}
+
+void matrix_free_f32(MatrixF *m)
+{
+    free(m->data);
+    m->data = NULL;
+    m->rows = m->cols = m->stride = 0;
+}
+
+static __thread void *pack_buffer;
+
+// The calling thread's packing buffer, see MATRIX_PACK_BYTES
+static void *matrix_pack_buffer(void)
+{
+    if (pack_buffer == NULL && posix_memalign(&pack_buffer, 64, MATRIX_PACK_BYTES) != 0)
+        pack_buffer = NULL;
+    return pack_buffer;
+}
+
+void matrix_release_thread_buffers(void)
+{
+    free(pack_buffer);
+    pack_buffer = NULL;
+    matrix_arena_destroy(matrix_thread_arena());
+}
+
+// int32 x int32 -> int32
+#define GEMM_NAME(x) x##_i32
+#define GEMM_IN int
+#define GEMM_OUT int
+#define GEMM_A_TYPE Matrix
+#define GEMM_C_TYPE Matrix
+#define GEMM_KERNEL i32
+#include "matrix_gemm_impl.h"
+#undef GEMM_NAME
+#undef GEMM_IN
+#undef GEMM_OUT
+#undef GEMM_A_TYPE
+#undef GEMM_C_TYPE
+#undef GEMM_KERNEL
+
+// int16 x int16 -> int32
+#define GEMM_NAME(x) x##_s16
+#define GEMM_IN int16_t
+#define GEMM_OUT int
+#define GEMM_A_TYPE MatrixS16
+#define GEMM_C_TYPE Matrix
+#define GEMM_KERNEL s16
+#include "matrix_gemm_impl.h"
+#undef GEMM_NAME
+#undef GEMM_IN
+#undef GEMM_OUT
+#undef GEMM_A_TYPE
+#undef GEMM_C_TYPE
+#undef GEMM_KERNEL
+
+// float32 x float32 -> float32
+#define GEMM_NAME(x) x##_f32
+#define GEMM_IN float
+#define GEMM_OUT float
+#define GEMM_A_TYPE MatrixF
+#define GEMM_C_TYPE MatrixF
+#define GEMM_KERNEL f32
+#include "matrix_gemm_impl.h"
+#undef GEMM_NAME
+#undef GEMM_IN
+#undef GEMM_OUT
+#undef GEMM_A_TYPE
+#undef GEMM_C_TYPE
+#undef GEMM_KERNEL
+
+// Shapes with a generated unrolled kernel skip the blocked driver entirely
+int matrix_gemm(Matrix *C, const Matrix *A, const Matrix *B)
+{
+    MatrixFixedKernel fixed = matrix_fixed_lookup(A->rows, A->cols, B->cols);
+
+    if (fixed != NULL && B->rows == A->cols && C->rows == A->rows && C->cols == B->cols)
+    {
+        fixed(C->data, C->stride, A->data, A->stride, B->data, B->stride);
+        return 0;
+    }
+    return gemm_parallel_i32(C, A, 0, B, 0, 1, 0);
+}
+
+int matrix_gemm_t(Matrix *C, const Matrix *A, int trans_a, const Matrix *B, int trans_b)
+{
+    if (!trans_a && !trans_b)
+        return matrix_gemm(C, A, B);
+    return gemm_parallel_i32(C, A, trans_a, B, trans_b, 1, 0);
+}
+
+int matrix_gemm_ex(Matrix *C, int alpha, const Matrix *A, int trans_a, const Matrix *B, int trans_b, int accumulate)
+{
+    return gemm_parallel_i32(C, A, trans_a, B, trans_b, alpha, accumulate);
+}
+
+int matrix_gemm_s16(Matrix *C, const MatrixS16 *A, const MatrixS16 *B)
+{
+    return gemm_parallel_s16(C, A, 0, B, 0, 1, 0);
+}
+
+int matrix_gemm_f32(MatrixF *C, const MatrixF *A, const MatrixF *B)
+{
+    return gemm_parallel_f32(C, A, 0, B, 0, 1.0f, 0);
+}
+
+void matrix_update_a(Matrix *C, Matrix *A, const Matrix *B, int i, int j, int value)
+{
+    int delta = value - MAT_AT(A, i, j);
+    const int *b = B->data + j * B->stride;
+    int *c = C->data + i * C->stride;
+    int col;
+
+    MAT_AT(A, i, j) = value;
+    if (delta == 0)
+        return;
+    for (col = 0; col < C->cols; col++)
+        c[col] += delta * b[col];
+}
+
+void matrix_update_b(Matrix *C, const Matrix *A, Matrix *B, int i, int j, int value)
+{
+    int delta = value - MAT_AT(B, i, j);
+    int row;
+
+    MAT_AT(B, i, j) = value;
+    if (delta == 0)
+        return;
+    for (row = 0; row < C->rows; row++)
+        MAT_AT(C, row, j) += MAT_AT(A, row, i) * delta;
+}
+
+// Function to perform matrix multiplication for two 2x2 matrices and store the result in a provided array.
+// The int[4] arrays are wrapped as 2x2 Matrix views and handed to the general matrix_gemm engine.
+void matrix_multiplication(int *result, int *matrixA, int *matrixB)
+{
+    Matrix A, B, C;
+
+    matrix_view(&A, matrixA, 2, 2, 2);
+    matrix_view(&B, matrixB, 2, 2, 2);
+    matrix_view(&C, result, 2, 2, 2);
+    matrix_gemm(&C, &A, &B);
+
+    // The resulting 2x2 matrix is stored in 'result' in row-major order:
+    // [ result[0] result[1] ]
+    // [ result[2] result[3] ]
+}
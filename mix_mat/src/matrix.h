@@ -0,0 +1,111 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <stdint.h>
+
+// Cache blocking parameters for the packed GEMM, tuned for the Cortex-A9 in the
+// Cyclone V HPS (32 KB L1 data cache, 512 KB shared L2).
+//   - an MR x KC sliver of A plus a KC x NR sliver of B (12 KB) stay in L1
+//   - the packed MC x KC block of A (64 KB) and KC x NC panel of B (256 KB)
+//     fit in L2 together with room to spare for C
+// MR x NR is the register tile of the micro-kernels in matrix_kernels.c: four
+// rows of two 4-lane NEON/SSE vectors or one 8-lane AVX2 vector.
+#define MATRIX_MR 4   // rows of C computed by one micro-kernel call
+#define MATRIX_NR 8   // columns of C computed by one micro-kernel call
+#define MATRIX_MC 64  // rows of A packed per block
+#define MATRIX_KC 256 // shared dimension packed per block
+#define MATRIX_NC 256 // columns of B packed per panel
+
+// Products with M*N*K at or below this many multiply-accumulates skip packing
+// and use a plain loop; the 2x2 demo product always lands here.
+#define MATRIX_SMALL_WORK (32 * 32 * 32)
+
+// Bytes of the per-thread packing buffer: an MC x KC block of A and a KC x NC
+// panel of B of the widest (4-byte) element type
+#define MATRIX_PACK_BYTES (4 * (MATRIX_MC * MATRIX_KC + MATRIX_KC * MATRIX_NC))
+
+// Dense row-major matrix of int entries. 'stride' is the distance in elements
+// between the starts of consecutive rows, so a Matrix can also describe a
+// sub-block of a larger matrix without copying it.
+typedef struct
+{
+    int rows;
+    int cols;
+    int stride;
+    int *data;
+} Matrix;
+
+// int16 operands (results accumulate into an int32 Matrix)
+typedef struct
+{
+    int rows;
+    int cols;
+    int stride;
+    int16_t *data;
+} MatrixS16;
+
+// float32 operands and results
+typedef struct
+{
+    int rows;
+    int cols;
+    int stride;
+    float *data;
+} MatrixF;
+
+// Element (i, j) of a Matrix, MatrixS16 or MatrixF pointer
+#define MAT_AT(m, i, j) ((m)->data[(i) * (m)->stride + (j)])
+
+int matrix_create(Matrix *m, int rows, int cols);
+void matrix_free(Matrix *m);
+void matrix_view(Matrix *m, int *data, int rows, int cols, int stride);
+void matrix_submatrix(Matrix *sub, const Matrix *m, int row, int col, int rows, int cols);
+void matrix_zero(Matrix *m);
+int matrix_copy(Matrix *dst, const Matrix *src);
+
+int matrix_create_s16(MatrixS16 *m, int rows, int cols);
+void matrix_free_s16(MatrixS16 *m);
+int matrix_create_f32(MatrixF *m, int rows, int cols);
+void matrix_free_f32(MatrixF *m);
+
+// C = A * B. C must already have A->rows x B->cols storage and must not overlap
+// A or B. Returns 0 on success, -1 on a shape mismatch or allocation failure.
+// Shapes listed in matrix_fixed.h use a generated unrolled kernel; otherwise the
+// micro-kernels are chosen at run time, see matrix_kernels.h, and large products
+// are split across the worker pool in matrix_pool.h.
+int matrix_gemm(Matrix *C, const Matrix *A, const Matrix *B);
+
+// C = op(A) * op(B) where op(X) is X^T if its trans flag is set. A transposed
+// operand is read through swapped strides while it is packed, so no
+// transposed copy is made.
+int matrix_gemm_t(Matrix *C, const Matrix *A, int trans_a, const Matrix *B, int trans_b);
+
+// C = alpha * op(A) * op(B), added to the existing C when 'accumulate' is set.
+// alpha is folded into the packed copy of A and the sum into the
+// micro-kernels' store, so neither costs an extra pass over C.
+int matrix_gemm_ex(Matrix *C, int alpha, const Matrix *A, int trans_a, const Matrix *B, int trans_b, int accumulate);
+
+// C = A * B for int16 operands with int32 accumulation
+int matrix_gemm_s16(Matrix *C, const MatrixS16 *A, const MatrixS16 *B);
+
+// C = A * B in single precision
+int matrix_gemm_f32(MatrixF *C, const MatrixF *A, const MatrixF *B);
+
+// Keep an existing product C = A * B current when one operand entry changes.
+// Setting A(i, j) only moves row i of C, by delta * row j of B; setting B(i, j)
+// only moves column j of C, by column i of A * delta. Each edit is O(N) instead
+// of the O(N^3) of a new product.
+void matrix_update_a(Matrix *C, Matrix *A, const Matrix *B, int i, int j, int value);
+void matrix_update_b(Matrix *C, const Matrix *A, Matrix *B, int i, int j, int value);
+
+// Blocked products pack into a buffer owned by the calling thread, allocated
+// on its first product and reused after that, so a steady stream of products
+// never touches the heap. This frees it along with the thread's default
+// arena (matrix_thread_arena()). Pool workers release theirs when they exit;
+// other threads may call this before exiting.
+void matrix_release_thread_buffers(void);
+
+// The 2x2 product used by the board demo: int[4] operands in row-major order
+void matrix_multiplication(int *result, int *matrixA, int *matrixB);
+
+#endif // MATRIX_H
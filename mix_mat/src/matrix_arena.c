@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_arena.h"
+
+static void clear_pools(MatrixArena *arena)
+{
+    memset(arena->free_list, 0, sizeof(arena->free_list));
+}
+
+int matrix_arena_init(MatrixArena *arena, size_t capacity)
+{
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+    clear_pools(arena);
+    if (capacity == 0)
+        return 0;
+    return matrix_arena_reserve(arena, capacity);
+}
+
+void matrix_arena_destroy(MatrixArena *arena)
+{
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+    clear_pools(arena);
+}
+
+int matrix_arena_reserve(MatrixArena *arena, size_t capacity)
+{
+    void *base = NULL;
+
+    if (capacity <= arena->capacity)
+        return 0;
+    if (arena->used != 0)
+        return -1;
+    capacity = matrix_arena_footprint(capacity);
+    if (posix_memalign(&base, MATRIX_ARENA_ALIGN, capacity) != 0)
+        return -1;
+    free(arena->base);
+    arena->base = (unsigned char *)base;
+    arena->capacity = capacity;
+    clear_pools(arena);
+    return 0;
+}
+
+size_t matrix_arena_footprint(size_t bytes)
+{
+    return (bytes + MATRIX_ARENA_ALIGN - 1) & ~(size_t)(MATRIX_ARENA_ALIGN - 1);
+}
+
+void *matrix_arena_alloc(MatrixArena *arena, size_t bytes)
+{
+    size_t size = matrix_arena_footprint(bytes);
+    void *p;
+
+    if (size > arena->capacity - arena->used)
+        return NULL;
+    p = arena->base + arena->used;
+    arena->used += size;
+    return p;
+}
+
+size_t matrix_arena_mark(const MatrixArena *arena)
+{
+    return arena->used;
+}
+
+// Pool blocks at or past 'mark' are about to be handed out by the bump
+// pointer again, so they leave their free lists
+void matrix_arena_release(MatrixArena *arena, size_t mark)
+{
+    int c;
+
+    if (mark > arena->used)
+        return;
+    arena->used = mark;
+    for (c = 0; c < MATRIX_ARENA_CLASSES; c++)
+    {
+        void **link = &arena->free_list[c];
+        while (*link != NULL)
+        {
+            if ((unsigned char *)*link >= arena->base + mark)
+                *link = *(void **)*link;
+            else
+                link = (void **)*link;
+        }
+    }
+}
+
+void matrix_arena_reset(MatrixArena *arena)
+{
+    arena->used = 0;
+    clear_pools(arena);
+}
+
+int matrix_arena_matrix(MatrixArena *arena, Matrix *m, int rows, int cols)
+{
+    int *data;
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    data = (int *)matrix_arena_alloc(arena, (size_t)rows * cols * sizeof(int));
+    if (data == NULL)
+        return -1;
+    matrix_view(m, data, rows, cols, cols);
+    return 0;
+}
+
+int matrix_arena_matrix_f32(MatrixArena *arena, MatrixF *m, int rows, int cols)
+{
+    float *data;
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    data = (float *)matrix_arena_alloc(arena, (size_t)rows * cols * sizeof(float));
+    if (data == NULL)
+        return -1;
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = data;
+    return 0;
+}
+
+// Smallest class whose blocks hold 'bytes', or -1 if none does
+static int size_class(size_t bytes)
+{
+    int c = 0;
+
+    while (c < MATRIX_ARENA_CLASSES && ((size_t)MATRIX_ARENA_ALIGN << c) < bytes)
+        c++;
+    return c < MATRIX_ARENA_CLASSES ? c : -1;
+}
+
+void *matrix_arena_get(MatrixArena *arena, size_t bytes)
+{
+    int c = size_class(bytes);
+    void *p;
+
+    if (c < 0)
+        return NULL;
+    p = arena->free_list[c];
+    if (p != NULL)
+    {
+        arena->free_list[c] = *(void **)p;
+        return p;
+    }
+    return matrix_arena_alloc(arena, (size_t)MATRIX_ARENA_ALIGN << c);
+}
+
+void matrix_arena_put(MatrixArena *arena, void *p, size_t bytes)
+{
+    int c = size_class(bytes);
+
+    if (p == NULL || c < 0)
+        return;
+    *(void **)p = arena->free_list[c];
+    arena->free_list[c] = p;
+}
+
+int matrix_arena_get_matrix(MatrixArena *arena, Matrix *m, int rows, int cols)
+{
+    int *data;
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    data = (int *)matrix_arena_get(arena, (size_t)rows * cols * sizeof(int));
+    if (data == NULL)
+        return -1;
+    matrix_view(m, data, rows, cols, cols);
+    return 0;
+}
+
+void matrix_arena_put_matrix(MatrixArena *arena, Matrix *m)
+{
+    matrix_arena_put(arena, m->data, (size_t)m->rows * m->cols * sizeof(int));
+    m->data = NULL;
+}
+
+// Zero-initialized, which is an empty arena
+static __thread MatrixArena thread_arena;
+
+MatrixArena *matrix_thread_arena(void)
+{
+    return &thread_arena;
+}
+
+void *matrix_scratch_begin(MatrixScratch *scratch, MatrixArena *arena, size_t bytes)
+{
+    if (arena == NULL)
+    {
+        scratch->arena = &scratch->local;
+        scratch->mark = 0;
+        if (matrix_arena_init(&scratch->local, bytes) != 0)
+            return NULL;
+    }
+    else
+    {
+        scratch->arena = arena;
+        scratch->mark = matrix_arena_mark(arena);
+        if (arena->capacity - arena->used < matrix_arena_footprint(bytes))
+            matrix_arena_reserve(arena, bytes);
+    }
+    return matrix_arena_alloc(scratch->arena, bytes);
+}
+
+void matrix_scratch_end(MatrixScratch *scratch)
+{
+    if (scratch->arena == &scratch->local)
+        matrix_arena_destroy(&scratch->local);
+    else
+        matrix_arena_release(scratch->arena, scratch->mark);
+}
@@ -0,0 +1,79 @@
+#ifndef MATRIX_ARENA_H
+#define MATRIX_ARENA_H
+
+#include <stddef.h>
+#include "matrix.h"
+
+// Every arena allocation starts on a cache line
+#define MATRIX_ARENA_ALIGN 64
+
+// Pool size classes: class c holds blocks of MATRIX_ARENA_ALIGN << c bytes
+#define MATRIX_ARENA_CLASSES 24
+
+// Bump allocator for matrix temporaries. Allocation is a pointer increment,
+// and everything allocated after a mark is released at once by rolling back to
+// it, so nested computations reuse the same memory without malloc/free. A
+// compute loop reserves once and calls matrix_arena_reset() at the end of
+// every frame, so the steady state never touches the heap.
+typedef struct
+{
+    unsigned char *base;
+    size_t capacity;
+    size_t used;
+    void *free_list[MATRIX_ARENA_CLASSES]; // returned pool blocks per class
+} MatrixArena;
+
+// Arenas start empty; init with capacity 0 allocates nothing until reserve
+int matrix_arena_init(MatrixArena *arena, size_t capacity);
+void matrix_arena_destroy(MatrixArena *arena);
+
+// Grows an arena that has nothing allocated to at least 'capacity' bytes.
+// Returns -1 if allocations are live or memory runs out.
+int matrix_arena_reserve(MatrixArena *arena, size_t capacity);
+
+// Returns 'bytes' of aligned storage, or NULL if the arena is full
+void *matrix_arena_alloc(MatrixArena *arena, size_t bytes);
+
+// Bytes an allocation of 'bytes' consumes including alignment padding
+size_t matrix_arena_footprint(size_t bytes);
+
+size_t matrix_arena_mark(const MatrixArena *arena);
+void matrix_arena_release(MatrixArena *arena, size_t mark);
+void matrix_arena_reset(MatrixArena *arena);
+
+// Allocates an uninitialized rows x cols Matrix from the arena
+int matrix_arena_matrix(MatrixArena *arena, Matrix *m, int rows, int cols);
+int matrix_arena_matrix_f32(MatrixArena *arena, MatrixF *m, int rows, int cols);
+
+// Size-class pools for buffers of recurring shapes that are freed out of
+// mark/release order. Requests round up to a power-of-two class; a block put
+// back is reused by the next get of its class instead of bumping the arena
+// again. Blocks are carved from the bump region, so release and reset
+// reclaim them too. get returns NULL if the class is empty and the arena full.
+void *matrix_arena_get(MatrixArena *arena, size_t bytes);
+void matrix_arena_put(MatrixArena *arena, void *p, size_t bytes);
+int matrix_arena_get_matrix(MatrixArena *arena, Matrix *m, int rows, int cols);
+void matrix_arena_put_matrix(MatrixArena *arena, Matrix *m);
+
+// Scratch for one call: 'bytes' from 'arena' (grown first if it is empty and
+// too small), or from a temporary heap arena when 'arena' is NULL. This is
+// how routines that take an optional arena get their workspace; end the
+// scope with matrix_scratch_end() (also after a NULL return), which rolls
+// 'arena' back.
+typedef struct
+{
+    MatrixArena *arena;
+    MatrixArena local;
+    size_t mark;
+} MatrixScratch;
+
+void *matrix_scratch_begin(MatrixScratch *scratch, MatrixArena *arena, size_t bytes);
+void matrix_scratch_end(MatrixScratch *scratch);
+
+// The calling thread's default arena, empty until its first use. The int[4]
+// drop-in wrappers take their scratch from it instead of a temporary arena,
+// so after the first call they never touch the heap. It is freed with the
+// thread's packing buffer by matrix_release_thread_buffers().
+MatrixArena *matrix_thread_arena(void);
+
+#endif // MATRIX_ARENA_H
@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_batch.h"
+
+// Four int32 lanes: one NEON q register on the A9, one SSE register on x86.
+// GCC lowers arithmetic on this type to the target's vector instructions.
+typedef int v4si __attribute__((vector_size(16)));
+#define BATCH_LANES 4
+
+int matrix_batch_create(MatrixBatch *batch, int n, int count)
+{
+    void *data = NULL;
+    int stride = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    size_t bytes = (size_t)n * n * stride * sizeof(int);
+
+    if (n < 1 || n > MATRIX_BATCH_MAX_N || count <= 0)
+        return -1;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        return -1;
+    memset(data, 0, bytes);
+
+    batch->n = n;
+    batch->count = count;
+    batch->stride = stride;
+    batch->capacity = count;
+    batch->data = (int *)data;
+    return 0;
+}
+
+void matrix_batch_free(MatrixBatch *batch)
+{
+    free(batch->data);
+    batch->data = NULL;
+    batch->count = 0;
+    batch->stride = 0;
+    batch->capacity = 0;
+}
+
+int matrix_batch_resize(MatrixBatch *batch, int count)
+{
+    if (count <= 0 || count > batch->capacity)
+        return -1;
+    batch->count = count;
+    batch->stride = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    return 0;
+}
+
+void matrix_batch_load(MatrixBatch *batch, int index, const int *m)
+{
+    int e;
+    for (e = 0; e < batch->n * batch->n; e++)
+        batch->data[e * batch->stride + index] = m[e];
+}
+
+void matrix_batch_store(const MatrixBatch *batch, int index, int *m)
+{
+    int e;
+    for (e = 0; e < batch->n * batch->n; e++)
+        m[e] = batch->data[e * batch->stride + index];
+}
+
+// Multiplies the vectors [first, last) of every plane. Inlined into callers
+// with a constant n so the i/j/k loops fully unroll for the common orders.
+static inline __attribute__((always_inline)) void batch_block(int n, int stride, int first, int last,
+                                                              int *c, const int *a, const int *b)
+{
+    int i, j, k, v;
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            v4si *cij = (v4si *)(c + (i * n + j) * stride);
+            for (v = first; v < last; v++)
+            {
+                v4si acc = ((const v4si *)(a + i * n * stride))[v] * ((const v4si *)(b + j * stride))[v];
+                for (k = 1; k < n; k++)
+                    acc += ((const v4si *)(a + (i * n + k) * stride))[v] * ((const v4si *)(b + (k * n + j) * stride))[v];
+                cij[v] = acc;
+            }
+        }
+    }
+}
+
+static void batch_multiply_2(int stride, int first, int last, int *c, const int *a, const int *b)
+{
+    batch_block(2, stride, first, last, c, a, b);
+}
+
+static void batch_multiply_3(int stride, int first, int last, int *c, const int *a, const int *b)
+{
+    batch_block(3, stride, first, last, c, a, b);
+}
+
+static void batch_multiply_4(int stride, int first, int last, int *c, const int *a, const int *b)
+{
+    batch_block(4, stride, first, last, c, a, b);
+}
+
+int matrix_batch_multiply(MatrixBatch *C, const MatrixBatch *A, const MatrixBatch *B)
+{
+    int n = A->n, stride = A->stride;
+    int vectors = stride / BATCH_LANES;
+    int block = MATRIX_BATCH_BLOCK / BATCH_LANES;
+    int first;
+
+    if (B->n != n || C->n != n || B->count != A->count || C->count != A->count)
+        return -1;
+
+    for (first = 0; first < vectors; first += block)
+    {
+        int last = first + block < vectors ? first + block : vectors;
+        switch (n)
+        {
+        case 2:
+            batch_multiply_2(stride, first, last, C->data, A->data, B->data);
+            break;
+        case 3:
+            batch_multiply_3(stride, first, last, C->data, A->data, B->data);
+            break;
+        case 4:
+            batch_multiply_4(stride, first, last, C->data, A->data, B->data);
+            break;
+        default:
+            batch_block(n, stride, first, last, C->data, A->data, B->data);
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef MATRIX_BATCH_H
+#define MATRIX_BATCH_H
+
+// Largest matrix order a batch can hold
+#define MATRIX_BATCH_MAX_N 8
+
+// Lanes processed per cache block: three 4x4 planes of 128 ints (24 KB) stay
+// resident in the A9's 32 KB L1 while every (i, j) entry of the block is formed.
+#define MATRIX_BATCH_BLOCK 128
+
+// 'count' independent n x n int matrices stored structure-of-arrays: entry
+// (i, j) of every matrix forms one contiguous plane, so element (i, j) of
+// matrix 'index' is data[(i * n + j) * stride + index]. A SIMD vector loaded
+// from a plane holds the same entry of consecutive matrices, one per lane.
+typedef struct
+{
+    int n;
+    int count;
+    int stride;   // plane length, 'count' rounded up to a whole vector
+    int capacity; // largest count the allocation holds
+    int *data;
+} MatrixBatch;
+
+int matrix_batch_create(MatrixBatch *batch, int n, int count);
+void matrix_batch_free(MatrixBatch *batch);
+
+// Changes the number of matrices to 'count' <= the count it was created with,
+// without reallocating. The planes are laid out again, so contents are lost;
+// reload every slot. Returns -1 if 'count' exceeds the capacity.
+int matrix_batch_resize(MatrixBatch *batch, int count);
+
+// Copy one row-major n x n matrix into / out of slot 'index'
+void matrix_batch_load(MatrixBatch *batch, int index, const int *m);
+void matrix_batch_store(const MatrixBatch *batch, int index, int *m);
+
+// C[b] = A[b] * B[b] for every slot b. All three batches must share n and
+// count, and C must not overlap A or B. Returns 0 on success, -1 on mismatch.
+int matrix_batch_multiply(MatrixBatch *C, const MatrixBatch *A, const MatrixBatch *B);
+
+#endif // MATRIX_BATCH_H
@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_bool.h"
+
+int matrix_bool_create(MatrixBool *m, int rows, int cols)
+{
+    void *data = NULL;
+    int words = (cols + 63) / 64;
+    size_t bytes = (size_t)rows * words * sizeof(uint64_t);
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        return -1;
+    memset(data, 0, bytes);
+
+    m->rows = rows;
+    m->cols = cols;
+    m->words = words;
+    m->data = (uint64_t *)data;
+    return 0;
+}
+
+void matrix_bool_free(MatrixBool *m)
+{
+    free(m->data);
+    m->data = NULL;
+    m->rows = 0;
+    m->cols = 0;
+    m->words = 0;
+}
+
+void matrix_bool_zero(MatrixBool *m)
+{
+    memset(m->data, 0, (size_t)m->rows * m->words * sizeof(uint64_t));
+}
+
+int matrix_bool_copy(MatrixBool *dst, const MatrixBool *src)
+{
+    if (dst->rows != src->rows || dst->cols != src->cols)
+        return -1;
+    if (dst != src)
+        memcpy(dst->data, src->data, (size_t)src->rows * src->words * sizeof(uint64_t));
+    return 0;
+}
+
+int matrix_bool_from_dense(MatrixBool *b, const Matrix *m)
+{
+    int i, j;
+
+    if (b->rows != m->rows || b->cols != m->cols)
+        return -1;
+    matrix_bool_zero(b);
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            if (MAT_AT(m, i, j) != 0)
+                matrix_bool_set(b, i, j, 1);
+    return 0;
+}
+
+int matrix_bool_to_dense(Matrix *m, const MatrixBool *b)
+{
+    int i, j;
+
+    if (b->rows != m->rows || b->cols != m->cols)
+        return -1;
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = matrix_bool_get(b, i, j);
+    return 0;
+}
+
+long matrix_bool_count(const MatrixBool *m)
+{
+    size_t n = (size_t)m->rows * m->words, w;
+    long count = 0;
+
+    for (w = 0; w < n; w++)
+        count += __builtin_popcountll(m->data[w]);
+    return count;
+}
+
+static void or_row(uint64_t *dst, const uint64_t *src, int words)
+{
+    int w;
+
+    for (w = 0; w < words; w++)
+        dst[w] |= src[w];
+}
+
+// One OR of a B row per set bit of A: cheap for sparse or short A
+static void multiply_rows(MatrixBool *C, const MatrixBool *A, const MatrixBool *B)
+{
+    int i, w;
+
+    for (i = 0; i < A->rows; i++)
+    {
+        const uint64_t *a = MATRIX_BOOL_ROW(A, i);
+        uint64_t *c = MATRIX_BOOL_ROW(C, i);
+        for (w = 0; w < A->words; w++)
+        {
+            uint64_t bits = a[w];
+            while (bits != 0)
+            {
+                or_row(c, MATRIX_BOOL_ROW(B, w * 64 + __builtin_ctzll(bits)), B->words);
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+// Method of Four Russians: for each group of MATRIX_BOOL_M4R_BITS rows of B,
+// tabulate the union of every subset once, then every row of A ORs in a
+// single table row per group instead of up to eight B rows. 'table' holds
+// m4r_bytes(B).
+static void multiply_m4r(MatrixBool *C, const MatrixBool *A, const MatrixBool *B, uint64_t *table)
+{
+    int g, i, s, words = B->words;
+
+    memset(table, 0, (size_t)words * sizeof(uint64_t));
+
+    for (g = 0; g < B->rows; g += MATRIX_BOOL_M4R_BITS)
+    {
+        int bits = B->rows - g < MATRIX_BOOL_M4R_BITS ? B->rows - g : MATRIX_BOOL_M4R_BITS;
+
+        // table[s] = table[s without its lowest bit] | B row of that bit
+        for (s = 1; s < (1 << bits); s++)
+        {
+            memcpy(table + (size_t)s * words, table + (size_t)(s & (s - 1)) * words, words * sizeof(uint64_t));
+            or_row(table + (size_t)s * words, MATRIX_BOOL_ROW(B, g + __builtin_ctz(s)), words);
+        }
+
+        for (i = 0; i < A->rows; i++)
+        {
+            s = (int)(MATRIX_BOOL_ROW(A, i)[g >> 6] >> (g & 63)) & ((1 << bits) - 1);
+            if (s != 0)
+                or_row(MATRIX_BOOL_ROW(C, i), table + (size_t)s * words, words);
+        }
+    }
+}
+
+static size_t m4r_bytes(const MatrixBool *B)
+{
+    return ((size_t)1 << MATRIX_BOOL_M4R_BITS) * B->words * sizeof(uint64_t);
+}
+
+// Shapes already checked; 'table' is only touched on the Four-Russians path
+static void multiply(MatrixBool *C, const MatrixBool *A, const MatrixBool *B, uint64_t *table)
+{
+    matrix_bool_zero(C);
+    if (A->rows < MATRIX_BOOL_M4R_ROWS)
+        multiply_rows(C, A, B);
+    else
+        multiply_m4r(C, A, B, table);
+}
+
+int matrix_bool_multiply(MatrixBool *C, const MatrixBool *A, const MatrixBool *B, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    uint64_t *table;
+
+    if (A->cols != B->rows || C->rows != A->rows || C->cols != B->cols)
+        return -1;
+    if (A->rows < MATRIX_BOOL_M4R_ROWS)
+    {
+        multiply(C, A, B, NULL);
+        return 0;
+    }
+    table = (uint64_t *)matrix_scratch_begin(&scratch, arena, m4r_bytes(B));
+    if (table != NULL)
+        multiply(C, A, B, table);
+    matrix_scratch_end(&scratch);
+    return table != NULL ? 0 : -1;
+}
+
+static void scratch_bool(MatrixBool *m, const MatrixBool *like, unsigned char *data)
+{
+    m->rows = like->rows;
+    m->cols = like->cols;
+    m->words = like->words;
+    m->data = (uint64_t *)data;
+}
+
+int matrix_bool_closure(MatrixBool *R, const MatrixBool *A, int reflexive, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    MatrixBool star, next, *cur, *spare, *tmp;
+    size_t bytes = (size_t)A->rows * A->words * sizeof(uint64_t);
+    size_t footprint = matrix_arena_footprint(bytes);
+    unsigned char *buf;
+    uint64_t *table;
+    int i;
+
+    if (A->rows != A->cols || R->rows != A->rows || R->cols != A->cols)
+        return -1;
+
+    // Both squaring buffers and the Four-Russians table in one block
+    buf = (unsigned char *)matrix_scratch_begin(&scratch, arena, 2 * footprint + m4r_bytes(A));
+    if (buf == NULL)
+    {
+        matrix_scratch_end(&scratch);
+        return -1;
+    }
+    scratch_bool(&star, A, buf);
+    scratch_bool(&next, A, buf + footprint);
+    table = (uint64_t *)(buf + 2 * footprint);
+
+    // Paths of length <= 2^t after t squarings of I | A
+    matrix_bool_copy(&star, A);
+    for (i = 0; i < A->rows; i++)
+        matrix_bool_set(&star, i, i, 1);
+    cur = &star;
+    spare = &next;
+    for (;;)
+    {
+        multiply(spare, cur, cur, table);
+        tmp = cur;
+        cur = spare;
+        spare = tmp;
+        if (memcmp(cur->data, spare->data, bytes) == 0)
+            break;
+    }
+
+    // Zero or more steps is the fixed point itself; one or more is A * (I | A)^*
+    if (!reflexive)
+    {
+        multiply(spare, A, cur, table);
+        cur = spare;
+    }
+    matrix_bool_copy(R, cur);
+    matrix_scratch_end(&scratch);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef MATRIX_BOOL_H
+#define MATRIX_BOOL_H
+
+#include <stdint.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Boolean products with at least this many rows of A use the Four-Russians
+// tables; smaller ones OR in one row of B per set bit of A
+#define MATRIX_BOOL_M4R_ROWS 64
+
+// Bits of A consumed per Four-Russians table (2^8 precomputed row unions)
+#define MATRIX_BOOL_M4R_BITS 8
+
+// 0/1 matrix with each row packed into 64-bit words, bit j of a row in word
+// j / 64 at position j % 64. Bits past 'cols' in the last word stay zero.
+typedef struct
+{
+    int rows;
+    int cols;
+    int words; // 64-bit words per row
+    uint64_t *data;
+} MatrixBool;
+
+#define MATRIX_BOOL_ROW(m, i) ((m)->data + (size_t)(i) * (m)->words)
+
+static inline int matrix_bool_get(const MatrixBool *m, int i, int j)
+{
+    return (int)((MATRIX_BOOL_ROW(m, i)[j >> 6] >> (j & 63)) & 1);
+}
+
+static inline void matrix_bool_set(MatrixBool *m, int i, int j, int value)
+{
+    uint64_t bit = (uint64_t)1 << (j & 63);
+    if (value)
+        MATRIX_BOOL_ROW(m, i)[j >> 6] |= bit;
+    else
+        MATRIX_BOOL_ROW(m, i)[j >> 6] &= ~bit;
+}
+
+// Zero-filled rows x cols matrix; 0 on success, -1 on bad shape or no memory
+int matrix_bool_create(MatrixBool *m, int rows, int cols);
+void matrix_bool_free(MatrixBool *m);
+void matrix_bool_zero(MatrixBool *m);
+int matrix_bool_copy(MatrixBool *dst, const MatrixBool *src);
+
+// Conversions to and from the int layout: nonzero entries become 1
+int matrix_bool_from_dense(MatrixBool *b, const Matrix *m);
+int matrix_bool_to_dense(Matrix *m, const MatrixBool *b);
+
+// Number of set entries (edges of the graph, reachable pairs of a closure)
+long matrix_bool_count(const MatrixBool *m);
+
+// C = A * B over (OR, AND): C(i, j) is set when some k has A(i, k) and B(k, j).
+// C must not overlap A or B. The Four-Russians table comes from 'arena' (NULL
+// uses a temporary one). Returns 0 on success, -1 on a shape mismatch or
+// allocation failure.
+int matrix_bool_multiply(MatrixBool *C, const MatrixBool *A, const MatrixBool *B, MatrixArena *arena);
+
+// Transitive closure of the square adjacency matrix A by repeated squaring of
+// I | A, stopping as soon as a squaring changes nothing (at most log2(n)
+// products). With 'reflexive' R(i, j) is set when j is reachable from i in
+// zero or more steps, otherwise in one or more. R may be A. The squaring
+// buffers come from 'arena' like matrix_bool_multiply()'s table.
+int matrix_bool_closure(MatrixBool *R, const MatrixBool *A, int reflexive, MatrixArena *arena);
+
+#endif // MATRIX_BOOL_H
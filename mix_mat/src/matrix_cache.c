@@ -0,0 +1,341 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_cache.h"
+
+// Multipliers of the 64-bit hash (the xxHash64 primes)
+#define HASH_PRIME1 0x9E3779B97F4A7C15ULL
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME3 0x165667B19E3779F9ULL
+
+// Budget bytes per hash bucket: about one bucket per 2x2 entry
+#define CACHE_BYTES_PER_BUCKET 128
+#define CACHE_MIN_BUCKETS 16
+#define CACHE_MAX_BUCKETS (1 << 20)
+
+// Header of an entry; A (m x k), B (k x n) and C (m x n) follow it packed
+struct MatrixCacheEntry
+{
+    uint64_t hash;
+    MatrixCacheEntry *next;  // bucket chain
+    MatrixCacheEntry *newer; // recency list, towards mru
+    MatrixCacheEntry *older; // recency list, towards lru
+    size_t bytes;            // whole allocation
+    int m, k, n;
+};
+
+#define ENTRY_A(e) ((int *)((e) + 1))
+#define ENTRY_B(e) (ENTRY_A(e) + (size_t)(e)->m * (e)->k)
+#define ENTRY_C(e) (ENTRY_B(e) + (size_t)(e)->k * (e)->n)
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t hash_round(uint64_t h, uint64_t v)
+{
+    h ^= rotl64(v * HASH_PRIME2, 31) * HASH_PRIME1;
+    return rotl64(h, 27) * HASH_PRIME1 + HASH_PRIME3;
+}
+
+// Folds 'bytes' bytes into the running state h. Runs of 32 bytes go through
+// four independent lanes so the multiplies overlap instead of forming one
+// dependency chain.
+static uint64_t hash_bytes(uint64_t h, const unsigned char *p, size_t bytes)
+{
+    uint64_t v, lane[4];
+    int l;
+
+    if (bytes >= 32)
+    {
+        lane[0] = h + HASH_PRIME1 + HASH_PRIME2;
+        lane[1] = h + HASH_PRIME2;
+        lane[2] = h;
+        lane[3] = h - HASH_PRIME1;
+        for (; bytes >= 32; p += 32, bytes -= 32)
+            for (l = 0; l < 4; l++)
+            {
+                memcpy(&v, p + 8 * l, 8);
+                lane[l] = rotl64(lane[l] + v * HASH_PRIME2, 31) * HASH_PRIME1;
+            }
+        h = rotl64(lane[0], 1) + rotl64(lane[1], 7) + rotl64(lane[2], 12) + rotl64(lane[3], 18);
+        for (l = 0; l < 4; l++)
+            h = hash_round(h, lane[l]);
+    }
+    for (; bytes >= 8; p += 8, bytes -= 8)
+    {
+        memcpy(&v, p, 8);
+        h = hash_round(h, v);
+    }
+    if (bytes > 0)
+    {
+        v = 0;
+        memcpy(&v, p, bytes);
+        h = hash_round(h, v);
+    }
+    return h;
+}
+
+// Final avalanche, so every input bit reaches the bucket index bits
+static uint64_t hash_final(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= HASH_PRIME2;
+    h ^= h >> 29;
+    h *= HASH_PRIME3;
+    return h ^ (h >> 32);
+}
+
+uint64_t matrix_hash64(const void *data, size_t bytes, uint64_t seed)
+{
+    return hash_final(hash_bytes(seed + HASH_PRIME3 + bytes, (const unsigned char *)data, bytes));
+}
+
+static uint64_t hash_matrix(uint64_t h, const Matrix *m)
+{
+    int i;
+    if (m->stride == m->cols)
+        return hash_bytes(h, (const unsigned char *)m->data, sizeof(int) * m->rows * m->cols);
+    for (i = 0; i < m->rows; i++)
+        h = hash_bytes(h, (const unsigned char *)(m->data + (size_t)i * m->stride), sizeof(int) * m->cols);
+    return h;
+}
+
+// The shapes seed the state, so equal entries in other shapes differ
+static uint64_t key_hash(const Matrix *A, const Matrix *B)
+{
+    uint64_t h = HASH_PRIME3;
+
+    h = hash_round(h, ((uint64_t)(uint32_t)A->rows << 32) | (uint32_t)A->cols);
+    h = hash_round(h, (uint64_t)(uint32_t)B->cols);
+    return hash_final(hash_matrix(hash_matrix(h, A), B));
+}
+
+// Nonzero if the packed rows x cols block at 'packed' equals m
+static int same_matrix(const int *packed, const Matrix *m)
+{
+    int i;
+    if (m->stride == m->cols)
+        return memcmp(packed, m->data, sizeof(int) * m->rows * m->cols) == 0;
+    for (i = 0; i < m->rows; i++, packed += m->cols)
+        if (memcmp(packed, m->data + (size_t)i * m->stride, sizeof(int) * m->cols) != 0)
+            return 0;
+    return 1;
+}
+
+static void pack_matrix(int *packed, const Matrix *m)
+{
+    int i;
+    for (i = 0; i < m->rows; i++, packed += m->cols)
+        memcpy(packed, m->data + (size_t)i * m->stride, sizeof(int) * m->cols);
+}
+
+static void unpack_matrix(Matrix *m, const int *packed)
+{
+    int i;
+    for (i = 0; i < m->rows; i++, packed += m->cols)
+        memcpy(m->data + (size_t)i * m->stride, packed, sizeof(int) * m->cols);
+}
+
+static MatrixCacheEntry *find(MatrixCache *cache, uint64_t hash, const Matrix *A, const Matrix *B)
+{
+    MatrixCacheEntry *e;
+    for (e = cache->buckets[hash & cache->bucket_mask]; e != NULL; e = e->next)
+        if (e->hash == hash && e->m == A->rows && e->k == A->cols && e->n == B->cols &&
+            same_matrix(ENTRY_A(e), A) && same_matrix(ENTRY_B(e), B))
+            return e;
+    return NULL;
+}
+
+static void list_unlink(MatrixCache *cache, MatrixCacheEntry *e)
+{
+    if (e->newer)
+        e->newer->older = e->older;
+    else
+        cache->mru = e->older;
+    if (e->older)
+        e->older->newer = e->newer;
+    else
+        cache->lru = e->newer;
+}
+
+static void list_push(MatrixCache *cache, MatrixCacheEntry *e)
+{
+    e->newer = NULL;
+    e->older = cache->mru;
+    if (cache->mru)
+        cache->mru->newer = e;
+    else
+        cache->lru = e;
+    cache->mru = e;
+}
+
+static void evict_lru(MatrixCache *cache)
+{
+    MatrixCacheEntry *e = cache->lru;
+    MatrixCacheEntry **link = &cache->buckets[e->hash & cache->bucket_mask];
+
+    while (*link != e)
+        link = &(*link)->next;
+    *link = e->next;
+    list_unlink(cache, e);
+    cache->stats.entries--;
+    cache->stats.bytes -= e->bytes;
+    cache->stats.evictions++;
+    free(e);
+}
+
+int matrix_cache_init(MatrixCache *cache, size_t budget)
+{
+    size_t buckets = CACHE_MIN_BUCKETS;
+
+    while (buckets < CACHE_MAX_BUCKETS && buckets * CACHE_BYTES_PER_BUCKET < budget)
+        buckets *= 2;
+    memset(cache, 0, sizeof(*cache));
+    cache->buckets = (MatrixCacheEntry **)calloc(buckets, sizeof(MatrixCacheEntry *));
+    if (cache->buckets == NULL)
+        return -1;
+    cache->bucket_mask = buckets - 1;
+    cache->budget = budget;
+    pthread_mutex_init(&cache->lock, NULL);
+    return 0;
+}
+
+void matrix_cache_clear(MatrixCache *cache)
+{
+    MatrixCacheEntry *e, *older;
+
+    pthread_mutex_lock(&cache->lock);
+    for (e = cache->mru; e != NULL; e = older)
+    {
+        older = e->older;
+        free(e);
+    }
+    memset(cache->buckets, 0, sizeof(MatrixCacheEntry *) * (cache->bucket_mask + 1));
+    cache->mru = cache->lru = NULL;
+    cache->stats.entries = 0;
+    cache->stats.bytes = 0;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void matrix_cache_destroy(MatrixCache *cache)
+{
+    if (cache->buckets == NULL)
+        return;
+    matrix_cache_clear(cache);
+    free(cache->buckets);
+    cache->buckets = NULL;
+    pthread_mutex_destroy(&cache->lock);
+}
+
+// Stores a computed product. The entry is built before taking the lock; if
+// another thread stored the same operands meanwhile, that entry is kept.
+static void insert(MatrixCache *cache, uint64_t hash, const Matrix *A, const Matrix *B, const Matrix *C)
+{
+    double elems = (double)A->rows * A->cols + (double)B->rows * B->cols + (double)C->rows * C->cols;
+    MatrixCacheEntry *e, **bucket;
+    size_t bytes;
+
+    if (sizeof(MatrixCacheEntry) + elems * sizeof(int) > (double)cache->budget)
+        return;
+    bytes = sizeof(MatrixCacheEntry) + (size_t)elems * sizeof(int);
+    e = (MatrixCacheEntry *)malloc(bytes);
+    if (e == NULL)
+        return;
+    e->hash = hash;
+    e->bytes = bytes;
+    e->m = A->rows;
+    e->k = A->cols;
+    e->n = B->cols;
+    pack_matrix(ENTRY_A(e), A);
+    pack_matrix(ENTRY_B(e), B);
+    pack_matrix(ENTRY_C(e), C);
+
+    pthread_mutex_lock(&cache->lock);
+    if (find(cache, hash, A, B) != NULL)
+    {
+        pthread_mutex_unlock(&cache->lock);
+        free(e);
+        return;
+    }
+    while (cache->stats.bytes + bytes > cache->budget)
+        evict_lru(cache);
+    bucket = &cache->buckets[hash & cache->bucket_mask];
+    e->next = *bucket;
+    *bucket = e;
+    list_push(cache, e);
+    cache->stats.entries++;
+    cache->stats.bytes += bytes;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+int matrix_cache_gemm(MatrixCache *cache, Matrix *C, const Matrix *A, const Matrix *B)
+{
+    MatrixCacheEntry *e;
+    uint64_t hash;
+
+    if (A->cols != B->rows || C->rows != A->rows || C->cols != B->cols)
+        return -1;
+
+    hash = key_hash(A, B);
+    pthread_mutex_lock(&cache->lock);
+    e = find(cache, hash, A, B);
+    if (e != NULL)
+    {
+        // Most recently used first
+        list_unlink(cache, e);
+        list_push(cache, e);
+        unpack_matrix(C, ENTRY_C(e));
+        cache->stats.hits++;
+        pthread_mutex_unlock(&cache->lock);
+        return 0;
+    }
+    cache->stats.misses++;
+    pthread_mutex_unlock(&cache->lock);
+
+    if (matrix_gemm(C, A, B) != 0)
+        return -1;
+    insert(cache, hash, A, B, C);
+    return 0;
+}
+
+void matrix_cache_stats(MatrixCache *cache, MatrixCacheStats *stats)
+{
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static MatrixCache default_cache;
+static int default_ready;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void default_init(void)
+{
+    const char *env = getenv("MATRIX_CACHE_BYTES");
+    size_t budget = env ? (size_t)strtoul(env, NULL, 0) : MATRIX_CACHE_DEFAULT_BYTES;
+
+    default_ready = matrix_cache_init(&default_cache, budget) == 0;
+}
+
+MatrixCache *matrix_cache_default(void)
+{
+    pthread_once(&default_once, default_init);
+    return default_ready ? &default_cache : NULL;
+}
+
+void matrix_multiplication_cached(int *result, int *matrixA, int *matrixB)
+{
+    MatrixCache *cache = matrix_cache_default();
+    Matrix A, B, C;
+
+    if (cache == NULL)
+    {
+        matrix_multiplication(result, matrixA, matrixB);
+        return;
+    }
+    matrix_view(&A, matrixA, 2, 2, 2);
+    matrix_view(&B, matrixB, 2, 2, 2);
+    matrix_view(&C, result, 2, 2, 2);
+    matrix_cache_gemm(cache, &C, &A, &B);
+}
@@ -0,0 +1,73 @@
+#ifndef MATRIX_CACHE_H
+#define MATRIX_CACHE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix.h"
+
+// Memoized products. A cache maps the contents of an (A, B) operand pair to
+// C = A * B, keyed by a 64-bit hash over the shapes and entries. An entry
+// keeps copies of both operands, so a hit is confirmed by comparing them and
+// a hash collision can never return a wrong product: a repeated query costs
+// one O(size) hash and compare instead of an O(m*k*n) product.
+//
+// Entries live in one bounded budget and are evicted least recently used
+// first. Products whose entry alone exceeds the budget are computed but not
+// stored. Calls are serialized by the cache's lock; the product on a miss is
+// computed outside it, so a shared cache does not stall other threads.
+
+// Budget of the process-wide cache when MATRIX_CACHE_BYTES is not set
+#define MATRIX_CACHE_DEFAULT_BYTES (256 << 10)
+
+typedef struct MatrixCacheEntry MatrixCacheEntry;
+
+typedef struct
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+    size_t bytes; // entry storage in use, at most the budget
+} MatrixCacheStats;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    size_t budget;
+    MatrixCacheEntry **buckets;
+    size_t bucket_mask;    // bucket count - 1, a power of two
+    MatrixCacheEntry *mru; // head of the recency list
+    MatrixCacheEntry *lru; // tail, evicted first
+    MatrixCacheStats stats;
+} MatrixCache;
+
+// A budget of 0 makes every call a miss that stores nothing.
+// Returns 0 on success, -1 on allocation failure.
+int matrix_cache_init(MatrixCache *cache, size_t budget);
+void matrix_cache_destroy(MatrixCache *cache);
+
+// Drops every entry; the counters are kept
+void matrix_cache_clear(MatrixCache *cache);
+
+// C = A * B through the cache, with matrix_gemm() on a miss. C must not
+// overlap A or B. Returns 0 on success, -1 on a shape mismatch.
+int matrix_cache_gemm(MatrixCache *cache, Matrix *C, const Matrix *A, const Matrix *B);
+
+// Snapshot of the counters
+void matrix_cache_stats(MatrixCache *cache, MatrixCacheStats *stats);
+
+// The process-wide cache, created on first use with a budget of
+// MATRIX_CACHE_BYTES (environment) or MATRIX_CACHE_DEFAULT_BYTES. NULL if it
+// could not be created.
+MatrixCache *matrix_cache_default(void);
+
+// Drop-in alternative to matrix_multiplication() for the 2x2 board demo that
+// answers repeated operand pairs from the process-wide cache (and falls back
+// to matrix_multiplication() without one)
+void matrix_multiplication_cached(int *result, int *matrixA, int *matrixB);
+
+// 64-bit hash of 'bytes' bytes at 'data', continuing from 'seed'
+uint64_t matrix_hash64(const void *data, size_t bytes, uint64_t seed);
+
+#endif // MATRIX_CACHE_H
@@ -0,0 +1,144 @@
+#include "matrix_chain.h"
+
+// Size of the intermediate holding the product of sub-chain i..j
+static size_t chain_bytes(const MatrixChainPlan *plan, int i, int j)
+{
+    return matrix_arena_footprint((size_t)plan->dims[i] * plan->dims[j + 1] * sizeof(int));
+}
+
+// Peak arena use while evaluating sub-chain i..j into an existing buffer: the
+// left intermediate stays live while the right one is built
+static size_t chain_scratch(const MatrixChainPlan *plan, int i, int j)
+{
+    size_t left = 0, right = 0, peak_left = 0, peak_right = 0, peak;
+    int k;
+
+    if (i == j)
+        return 0;
+    k = plan->split[i][j];
+    if (k > i)
+    {
+        left = chain_bytes(plan, i, k);
+        peak_left = left + chain_scratch(plan, i, k);
+    }
+    if (k + 1 < j)
+    {
+        right = chain_bytes(plan, k + 1, j);
+        peak_right = left + right + chain_scratch(plan, k + 1, j);
+    }
+    peak = peak_left > peak_right ? peak_left : peak_right;
+    return peak;
+}
+
+int matrix_chain_plan(MatrixChainPlan *plan, const Matrix *const *mats, int count)
+{
+    long long cost[MATRIX_CHAIN_MAX][MATRIX_CHAIN_MAX];
+    int i, j, k, len;
+
+    if (count < 1 || count > MATRIX_CHAIN_MAX)
+        return -1;
+    for (i = 0; i < count; i++)
+    {
+        if (i > 0 && mats[i]->rows != mats[i - 1]->cols)
+            return -1;
+        plan->dims[i] = mats[i]->rows;
+    }
+    plan->dims[count] = mats[count - 1]->cols;
+    plan->count = count;
+
+    for (i = 0; i < count; i++)
+    {
+        cost[i][i] = 0;
+        plan->split[i][i] = i;
+    }
+    for (len = 2; len <= count; len++)
+    {
+        for (i = 0; i + len - 1 < count; i++)
+        {
+            j = i + len - 1;
+            cost[i][j] = -1;
+            for (k = i; k < j; k++)
+            {
+                long long c = cost[i][k] + cost[k + 1][j] +
+                              (long long)plan->dims[i] * plan->dims[k + 1] * plan->dims[j + 1];
+                if (cost[i][j] < 0 || c < cost[i][j])
+                {
+                    cost[i][j] = c;
+                    plan->split[i][j] = k;
+                }
+            }
+        }
+    }
+    plan->cost = cost[0][count - 1];
+
+    plan->naive_cost = 0;
+    for (k = 1; k < count; k++)
+        plan->naive_cost += (long long)plan->dims[0] * plan->dims[k] * plan->dims[k + 1];
+
+    plan->scratch_bytes = chain_scratch(plan, 0, count - 1);
+    return 0;
+}
+
+// Computes sub-chain i..j into 'out'. Leaves are used in place; inner nodes
+// get arena buffers that are released once 'out' is formed.
+static int chain_eval(Matrix *out, const MatrixChainPlan *plan, const Matrix *const *mats,
+                      MatrixArena *arena, int i, int j)
+{
+    Matrix left, right;
+    size_t mark = matrix_arena_mark(arena);
+    int k, status = -1;
+
+    if (i == j)
+        return matrix_copy(out, mats[i]);
+
+    k = plan->split[i][j];
+    if (k == i)
+        left = *mats[i];
+    else if (matrix_arena_matrix(arena, &left, plan->dims[i], plan->dims[k + 1]) != 0 ||
+             chain_eval(&left, plan, mats, arena, i, k) != 0)
+        goto done;
+
+    if (k + 1 == j)
+        right = *mats[j];
+    else if (matrix_arena_matrix(arena, &right, plan->dims[k + 1], plan->dims[j + 1]) != 0 ||
+             chain_eval(&right, plan, mats, arena, k + 1, j) != 0)
+        goto done;
+
+    status = matrix_gemm(out, &left, &right);
+
+done:
+    matrix_arena_release(arena, mark);
+    return status;
+}
+
+int matrix_chain_execute(Matrix *C, const MatrixChainPlan *plan, const Matrix *const *mats, MatrixArena *arena)
+{
+    MatrixArena local;
+    int status;
+
+    if (C->rows != plan->dims[0] || C->cols != plan->dims[plan->count])
+        return -1;
+
+    if (arena == NULL)
+    {
+        if (matrix_arena_init(&local, plan->scratch_bytes) != 0)
+            return -1;
+        status = chain_eval(C, plan, mats, &local, 0, plan->count - 1);
+        matrix_arena_destroy(&local);
+        return status;
+    }
+
+    if (arena->capacity - arena->used < plan->scratch_bytes &&
+        matrix_arena_reserve(arena, plan->scratch_bytes) != 0)
+        return -1;
+    return chain_eval(C, plan, mats, arena, 0, plan->count - 1);
+}
+
+int matrix_chain_multiply(Matrix *C, const Matrix *const *mats, int count, MatrixArena *arena)
+{
+    MatrixChainPlan plan;
+
+    if (matrix_chain_plan(&plan, mats, count) != 0)
+        return -1;
+    return matrix_chain_execute(C, &plan, mats, arena);
+}
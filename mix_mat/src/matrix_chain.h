@@ -0,0 +1,35 @@
+#ifndef MATRIX_CHAIN_H
+#define MATRIX_CHAIN_H
+
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Longest chain the planner accepts
+#define MATRIX_CHAIN_MAX 32
+
+// Optimal evaluation order for M0 * M1 * ... * M(count-1), where Mi is
+// dims[i] x dims[i+1]. split[i][j] is the k at which the sub-chain i..j is
+// best cut into (i..k) * (k+1..j).
+typedef struct
+{
+    int count;
+    int dims[MATRIX_CHAIN_MAX + 1];
+    int split[MATRIX_CHAIN_MAX][MATRIX_CHAIN_MAX];
+    long long cost;       // multiply-accumulates of the optimal order
+    long long naive_cost; // multiply-accumulates of left-to-right evaluation
+    size_t scratch_bytes; // arena space needed for the intermediates
+} MatrixChainPlan;
+
+// Runs the O(count^3) parenthesization DP over the shapes of mats[0..count-1].
+// Returns -1 if the chain is empty, too long, or the shapes do not chain.
+int matrix_chain_plan(MatrixChainPlan *plan, const Matrix *const *mats, int count);
+
+// Evaluates a plan into C (dims[0] x dims[count]). Intermediates are taken
+// from 'arena' and released before returning; an empty arena is grown to
+// plan->scratch_bytes, and a NULL arena uses a temporary one.
+int matrix_chain_execute(Matrix *C, const MatrixChainPlan *plan, const Matrix *const *mats, MatrixArena *arena);
+
+// Plans and executes in one call
+int matrix_chain_multiply(Matrix *C, const Matrix *const *mats, int count, MatrixArena *arena);
+
+#endif // MATRIX_CHAIN_H
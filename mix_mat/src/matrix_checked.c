@@ -0,0 +1,272 @@
+#include <limits.h>
+#include <string.h>
+#include "matrix_checked.h"
+#include "matrix_pool.h"
+
+// Column maxima of A up to this many columns live on the stack, so small
+// products such as the 2x2 demo never touch an arena
+#define STACK_COLS 64
+
+// Operand ranges found by the pre-pass
+typedef struct
+{
+    uint64_t bound; // of every |C(i, j)|
+    uint32_t max_a; // largest |A(i, p)|
+    uint32_t max_b; // largest |B(p, j)|
+} Range;
+
+static uint32_t abs32(int x)
+{
+    return x < 0 ? (uint32_t)0 - (uint32_t)x : (uint32_t)x;
+}
+
+static void analyse(Range *r, const Matrix *A, const Matrix *B, MatrixArena *arena)
+{
+    int K = A->cols;
+    MatrixScratch scratch;
+    uint32_t local[STACK_COLS], *colmax = local, v, rowmax;
+    uint64_t term;
+    int i, j, p;
+
+    r->bound = UINT64_MAX;
+    r->max_a = r->max_b = UINT32_MAX;
+    if (K > STACK_COLS)
+    {
+        colmax = (uint32_t *)matrix_scratch_begin(&scratch, arena, sizeof(uint32_t) * K);
+        if (colmax == NULL)
+        {
+            matrix_scratch_end(&scratch);
+            return;
+        }
+    }
+
+    // Column maxima of A, one row at a time
+    memset(colmax, 0, sizeof(uint32_t) * K);
+    for (i = 0; i < A->rows; i++)
+    {
+        const int *a = A->data + (size_t)i * A->stride;
+        for (p = 0; p < K; p++)
+        {
+            v = abs32(a[p]);
+            colmax[p] = v > colmax[p] ? v : colmax[p];
+        }
+    }
+
+    r->bound = 0;
+    r->max_a = r->max_b = 0;
+    for (p = 0; p < K; p++)
+    {
+        const int *b = B->data + (size_t)p * B->stride;
+        rowmax = 0;
+        for (j = 0; j < B->cols; j++)
+        {
+            v = abs32(b[j]);
+            rowmax = v > rowmax ? v : rowmax;
+        }
+        term = (uint64_t)colmax[p] * rowmax;
+        r->bound = term > UINT64_MAX - r->bound ? UINT64_MAX : r->bound + term;
+        r->max_a = colmax[p] > r->max_a ? colmax[p] : r->max_a;
+        r->max_b = rowmax > r->max_b ? rowmax : r->max_b;
+    }
+    if (colmax != local)
+        matrix_scratch_end(&scratch);
+}
+
+// Narrowing costs a pass over both operands, which the int16 kernels only win
+// back when each operand entry is reused often enough: both M and N at least
+// this large
+#define NARROW_MIN_DIM 32
+
+static MatrixAcc choose(const Range *r, const Matrix *A, const Matrix *B)
+{
+    if (r->bound > INT_MAX)
+        return MATRIX_ACC_S64;
+    if (r->max_a <= INT16_MAX && r->max_b <= INT16_MAX && A->rows >= NARROW_MIN_DIM &&
+        B->cols >= NARROW_MIN_DIM)
+        return MATRIX_ACC_S16;
+    return MATRIX_ACC_S32;
+}
+
+uint64_t matrix_product_bound(const Matrix *A, const Matrix *B, MatrixArena *arena)
+{
+    Range r;
+    analyse(&r, A, B, arena);
+    return r.bound;
+}
+
+MatrixAcc matrix_acc_select(const Matrix *A, const Matrix *B, MatrixArena *arena)
+{
+    Range r;
+    analyse(&r, A, B, arena);
+    return choose(&r, A, B);
+}
+
+static int gemm_narrow(Matrix *C, const Matrix *A, const Matrix *B, MatrixArena *arena)
+{
+    MatrixS16 A16, B16;
+    MatrixScratch scratch;
+    int16_t *buf;
+    int i, j, status;
+
+    buf = (int16_t *)matrix_scratch_begin(&scratch, arena,
+                                          sizeof(int16_t) * ((size_t)A->rows * A->cols + (size_t)B->rows * B->cols));
+    if (buf == NULL)
+    {
+        matrix_scratch_end(&scratch);
+        return -1;
+    }
+    A16.rows = A->rows;
+    A16.cols = A16.stride = A->cols;
+    A16.data = buf;
+    B16.rows = B->rows;
+    B16.cols = B16.stride = B->cols;
+    B16.data = buf + (size_t)A->rows * A->cols;
+    for (i = 0; i < A->rows; i++)
+        for (j = 0; j < A->cols; j++)
+            MAT_AT(&A16, i, j) = (int16_t)MAT_AT(A, i, j);
+    for (i = 0; i < B->rows; i++)
+        for (j = 0; j < B->cols; j++)
+            MAT_AT(&B16, i, j) = (int16_t)MAT_AT(B, i, j);
+
+    status = matrix_gemm_s16(C, &A16, &B16);
+    matrix_scratch_end(&scratch);
+    return status;
+}
+
+// The int64 path. When the bound fits int64 so does every partial sum, and
+// one accumulator per column suffices. Beyond that each product is split
+// into its high and low 32 bits, summed separately and recombined, which is
+// exact for any k < 2^31.
+typedef struct
+{
+    Matrix *C;
+    const Matrix *A;
+    const Matrix *B;
+    int split;
+    int rows_per_task;
+    int overflow; // set by any task that finds an entry outside int
+} WideJob;
+
+static int fits_int(int64_t hi, int64_t lo)
+{
+    // value = hi * 2^32 + lo with lo carried into hi first
+    hi += lo >> 32;
+    lo &= 0xFFFFFFFF;
+    return (hi == 0 && lo <= INT_MAX) || (hi == -1 && lo >= 0x80000000LL);
+}
+
+static void wide_rows(WideJob *job, int row_begin, int row_end)
+{
+    const Matrix *A = job->A, *B = job->B;
+    Matrix *C = job->C;
+    int64_t acc[MATRIX_CHECKED_BLOCK], hi[MATRIX_CHECKED_BLOCK];
+    int64_t t;
+    int i, j, jb, p, width;
+
+    for (jb = 0; jb < C->cols; jb += MATRIX_CHECKED_BLOCK)
+    {
+        width = C->cols - jb < MATRIX_CHECKED_BLOCK ? C->cols - jb : MATRIX_CHECKED_BLOCK;
+        for (i = row_begin; i < row_end; i++)
+        {
+            int *c = C->data + (size_t)i * C->stride + jb;
+
+            memset(acc, 0, sizeof(int64_t) * width);
+            if (!job->split)
+            {
+                for (p = 0; p < A->cols; p++)
+                {
+                    const int *b = B->data + (size_t)p * B->stride + jb;
+                    int64_t a = MAT_AT(A, i, p);
+                    if (a == 0)
+                        continue;
+                    for (j = 0; j < width; j++)
+                        acc[j] += a * b[j];
+                }
+                for (j = 0; j < width; j++)
+                {
+                    if (acc[j] < INT_MIN || acc[j] > INT_MAX)
+                        job->overflow = 1;
+                    c[j] = (int)acc[j];
+                }
+                continue;
+            }
+
+            memset(hi, 0, sizeof(int64_t) * width);
+            for (p = 0; p < A->cols; p++)
+            {
+                const int *b = B->data + (size_t)p * B->stride + jb;
+                int64_t a = MAT_AT(A, i, p);
+                for (j = 0; j < width; j++)
+                {
+                    t = a * b[j];
+                    hi[j] += t >> 32;
+                    acc[j] += t & 0xFFFFFFFF;
+                }
+            }
+            for (j = 0; j < width; j++)
+            {
+                if (!fits_int(hi[j], acc[j]))
+                    job->overflow = 1;
+                c[j] = (int)(uint32_t)acc[j];
+            }
+        }
+    }
+}
+
+static void wide_task(void *arg, int index)
+{
+    WideJob *job = (WideJob *)arg;
+    int begin = index * job->rows_per_task;
+    int end = begin + job->rows_per_task < job->C->rows ? begin + job->rows_per_task : job->C->rows;
+    wide_rows(job, begin, end);
+}
+
+static int gemm_wide(Matrix *C, const Matrix *A, const Matrix *B, uint64_t bound)
+{
+    int M = C->rows, threads, tasks;
+    WideJob job;
+
+    job.C = C;
+    job.A = A;
+    job.B = B;
+    job.split = bound > (uint64_t)INT64_MAX;
+    job.overflow = 0;
+    if ((long long)M * C->cols * A->cols < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+        wide_rows(&job, 0, M);
+    else
+    {
+        tasks = threads * 4;
+        job.rows_per_task = (M + tasks - 1) / tasks;
+        tasks = (M + job.rows_per_task - 1) / job.rows_per_task;
+        matrix_pool_run(wide_task, &job, tasks);
+    }
+    return job.overflow ? -1 : 0;
+}
+
+int matrix_gemm_checked(Matrix *C, const Matrix *A, const Matrix *B, MatrixArena *arena)
+{
+    Range r;
+
+    if (A->cols != B->rows || C->rows != A->rows || C->cols != B->cols)
+        return -1;
+    analyse(&r, A, B, arena);
+    switch (choose(&r, A, B))
+    {
+    case MATRIX_ACC_S16:
+        return gemm_narrow(C, A, B, arena);
+    case MATRIX_ACC_S32:
+        return matrix_gemm(C, A, B);
+    default:
+        return gemm_wide(C, A, B, r.bound);
+    }
+}
+
+int matrix_multiplication_checked(int *result, int *matrixA, int *matrixB)
+{
+    Matrix A, B, C;
+
+    matrix_view(&A, matrixA, 2, 2, 2);
+    matrix_view(&B, matrixB, 2, 2, 2);
+    matrix_view(&C, result, 2, 2, 2);
+    return matrix_gemm_checked(&C, &A, &B, matrix_thread_arena());
+}
@@ -0,0 +1,48 @@
+#ifndef MATRIX_CHECKED_H
+#define MATRIX_CHECKED_H
+
+#include <stdint.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Overflow-safe int products. matrix_gemm() accumulates in int and wraps
+// silently once a dot product leaves the int range. A pre-pass over the
+// operands bounds every entry of C by
+//   |C(i, j)| <= sum_p max_i |A(i, p)| * max_j |B(p, j)|
+// (column maxima of A times row maxima of B), which costs O(m*k + k*n) next
+// to the O(m*k*n) product, and picks the narrowest path that is exact:
+//   MATRIX_ACC_S16  operands fit int16 and the bound fits int: the int16
+//                   micro-kernels (twice the lanes per vector) on narrowed
+//                   copies of A and B
+//   MATRIX_ACC_S32  the bound fits int: the plain int GEMM
+//   MATRIX_ACC_S64  anything else: int64 accumulation with every result
+//                   checked against the int range
+typedef enum
+{
+    MATRIX_ACC_S16,
+    MATRIX_ACC_S32,
+    MATRIX_ACC_S64
+} MatrixAcc;
+
+// Columns of C accumulated per int64 row block of the checked path (2 KB)
+#define MATRIX_CHECKED_BLOCK 256
+
+// The bound above, saturating at UINT64_MAX. The column maxima of A take
+// k words from 'arena' (NULL uses the heap); if they cannot be had the
+// result is UINT64_MAX, which only costs speed.
+uint64_t matrix_product_bound(const Matrix *A, const Matrix *B, MatrixArena *arena);
+
+// The path matrix_gemm_checked() takes for A * B
+MatrixAcc matrix_acc_select(const Matrix *A, const Matrix *B, MatrixArena *arena);
+
+// C = A * B, exact. Narrowed operands for the int16 path come from 'arena'
+// (NULL uses the heap). Returns 0 on success, -1 on a shape mismatch,
+// allocation failure, or when an entry of the true product does not fit in
+// int; C is then unspecified.
+int matrix_gemm_checked(Matrix *C, const Matrix *A, const Matrix *B, MatrixArena *arena);
+
+// Checked alternative to matrix_multiplication() for the 2x2 board demo.
+// Returns 0, or -1 if an entry of the product does not fit in int.
+int matrix_multiplication_checked(int *result, int *matrixA, int *matrixB);
+
+#endif // MATRIX_CHECKED_H
@@ -0,0 +1,300 @@
+#include <stdint.h>
+#include "matrix_expr.h"
+
+// One flattened term: coeff * op(node), node being a leaf or a product
+typedef struct
+{
+    int coeff;
+    int trans;
+    const MatrixExpr *node;
+} ExprTerm;
+
+static MatrixExpr *expr_node(MatrixArena *arena, MatrixExprOp op, int rows, int cols)
+{
+    MatrixExpr *e = (MatrixExpr *)matrix_arena_alloc(arena, sizeof(MatrixExpr));
+
+    if (e == NULL)
+        return NULL;
+    e->op = op;
+    e->rows = rows;
+    e->cols = cols;
+    e->scalar = 1;
+    e->leaf = NULL;
+    e->lhs = NULL;
+    e->rhs = NULL;
+    return e;
+}
+
+const MatrixExpr *matrix_expr_leaf(MatrixArena *arena, const Matrix *m)
+{
+    MatrixExpr *e;
+
+    if (m == NULL || (e = expr_node(arena, MATRIX_EXPR_LEAF, m->rows, m->cols)) == NULL)
+        return NULL;
+    e->leaf = m;
+    return e;
+}
+
+const MatrixExpr *matrix_expr_add(MatrixArena *arena, const MatrixExpr *a, const MatrixExpr *b)
+{
+    MatrixExpr *e;
+
+    if (a == NULL || b == NULL || a->rows != b->rows || a->cols != b->cols ||
+        (e = expr_node(arena, MATRIX_EXPR_ADD, a->rows, a->cols)) == NULL)
+        return NULL;
+    e->lhs = a;
+    e->rhs = b;
+    return e;
+}
+
+const MatrixExpr *matrix_expr_sub(MatrixArena *arena, const MatrixExpr *a, const MatrixExpr *b)
+{
+    return matrix_expr_add(arena, a, matrix_expr_scale(arena, -1, b));
+}
+
+const MatrixExpr *matrix_expr_scale(MatrixArena *arena, int alpha, const MatrixExpr *a)
+{
+    MatrixExpr *e;
+
+    if (a == NULL || (e = expr_node(arena, MATRIX_EXPR_SCALE, a->rows, a->cols)) == NULL)
+        return NULL;
+    e->scalar = alpha;
+    e->lhs = a;
+    return e;
+}
+
+const MatrixExpr *matrix_expr_transpose(MatrixArena *arena, const MatrixExpr *a)
+{
+    MatrixExpr *e;
+
+    if (a == NULL || (e = expr_node(arena, MATRIX_EXPR_TRANSPOSE, a->cols, a->rows)) == NULL)
+        return NULL;
+    e->lhs = a;
+    return e;
+}
+
+const MatrixExpr *matrix_expr_mul(MatrixArena *arena, const MatrixExpr *a, const MatrixExpr *b)
+{
+    MatrixExpr *e;
+
+    if (a == NULL || b == NULL || a->cols != b->rows ||
+        (e = expr_node(arena, MATRIX_EXPR_MUL, a->rows, b->cols)) == NULL)
+        return NULL;
+    e->lhs = a;
+    e->rhs = b;
+    return e;
+}
+
+// Appends the terms of coeff * op(e) to terms[]
+static int flatten(const MatrixExpr *e, int coeff, int trans, ExprTerm *terms, int *count)
+{
+    switch (e->op)
+    {
+    case MATRIX_EXPR_ADD:
+        if (flatten(e->lhs, coeff, trans, terms, count) != 0)
+            return -1;
+        return flatten(e->rhs, coeff, trans, terms, count);
+    case MATRIX_EXPR_SCALE:
+        return flatten(e->lhs, coeff * e->scalar, trans, terms, count);
+    case MATRIX_EXPR_TRANSPOSE:
+        return flatten(e->lhs, coeff, !trans, terms, count);
+    default:
+        if (coeff == 0)
+            return 0;
+        if (*count == MATRIX_EXPR_MAX_TERMS)
+            return -1;
+        terms[*count].coeff = coeff;
+        terms[*count].trans = trans;
+        terms[*count].node = e;
+        (*count)++;
+        return 0;
+    }
+}
+
+static int overlaps(const Matrix *a, const Matrix *b)
+{
+    uintptr_t a0 = (uintptr_t)a->data, a1 = (uintptr_t)(a->data + (a->rows - 1) * a->stride + a->cols);
+    uintptr_t b0 = (uintptr_t)b->data, b1 = (uintptr_t)(b->data + (b->rows - 1) * b->stride + b->cols);
+    return a0 < b1 && b0 < a1;
+}
+
+// Resolves one factor of a product to stored data: coeff * op(m). A scaled or
+// transposed leaf is used in place; anything else is evaluated into the arena.
+static int expr_operand(const MatrixExpr *e, const Matrix *out, MatrixArena *arena,
+                        Matrix *tmp, const Matrix **m, int *trans, int *coeff)
+{
+    ExprTerm terms[MATRIX_EXPR_MAX_TERMS];
+    int count = 0;
+
+    if (flatten(e, 1, 0, terms, &count) != 0)
+        return -1;
+    if (count == 1 && terms[0].node->op == MATRIX_EXPR_LEAF && !overlaps(terms[0].node->leaf, out))
+    {
+        *m = terms[0].node->leaf;
+        *trans = terms[0].trans;
+        *coeff = terms[0].coeff;
+        return 0;
+    }
+    if (matrix_arena_matrix(arena, tmp, e->rows, e->cols) != 0 || matrix_expr_eval(tmp, e, arena) != 0)
+        return -1;
+    *m = tmp;
+    *trans = 0;
+    *coeff = 1;
+    return 0;
+}
+
+// Product factors of one term, resolved before out is written
+typedef struct
+{
+    const Matrix *a;
+    const Matrix *b;
+    Matrix a_tmp;
+    Matrix b_tmp;
+    int trans_a;
+    int trans_b;
+    int alpha;
+} ExprProduct;
+
+static int expr_eval(Matrix *out, const MatrixExpr *e, MatrixArena *arena)
+{
+    ExprTerm terms[MATRIX_EXPR_MAX_TERMS];
+    ExprProduct products[MATRIX_EXPR_MAX_TERMS];
+    int count = 0, nprod = 0, written = 0, first_leaf = 1, t, i, j;
+
+    if (flatten(e, 1, 0, terms, &count) != 0)
+        return -1;
+
+    // Resolve every product's factors first: one that overlaps out must be
+    // copied before out is overwritten
+    for (t = 0; t < count; t++)
+    {
+        const MatrixExpr *node = terms[t].node;
+        ExprProduct *p = &products[nprod];
+        int ca, cb;
+
+        if (node->op != MATRIX_EXPR_MUL)
+            continue;
+        if (expr_operand(node->lhs, out, arena, &p->a_tmp, &p->a, &p->trans_a, &ca) != 0 ||
+            expr_operand(node->rhs, out, arena, &p->b_tmp, &p->b, &p->trans_b, &cb) != 0)
+            return -1;
+        p->alpha = terms[t].coeff * ca * cb;
+        if (terms[t].trans)
+        {
+            // (op(X) op(Y))^T = op(Y)^T op(X)^T
+            const Matrix *m = p->a;
+            int tr = p->trans_a;
+            p->a = p->b;
+            p->trans_a = !p->trans_b;
+            p->b = m;
+            p->trans_b = !tr;
+        }
+        nprod++;
+    }
+
+    // All leaf terms in one pass, row by row so each output row is combined
+    // while it is in cache. A leaf that overlaps out would read entries this
+    // pass already wrote, so it is staged in the arena. The one exception is
+    // out itself as the first leaf term: each entry is read just before it is
+    // written.
+    for (t = 0; t < count; t++)
+    {
+        const Matrix *leaf = terms[t].node->leaf;
+        if (terms[t].node->op != MATRIX_EXPR_LEAF)
+            continue;
+        if (first_leaf && !terms[t].trans && leaf->data == out->data && leaf->stride == out->stride)
+        {
+            first_leaf = 0;
+            continue;
+        }
+        first_leaf = 0;
+        if (overlaps(leaf, out))
+        {
+            Matrix *copy = (Matrix *)matrix_arena_alloc(arena, sizeof(Matrix));
+            if (copy == NULL || matrix_arena_matrix(arena, copy, leaf->rows, leaf->cols) != 0)
+                return -1;
+            matrix_copy(copy, leaf);
+            terms[t].node = matrix_expr_leaf(arena, copy);
+            if (terms[t].node == NULL)
+                return -1;
+        }
+    }
+    for (i = 0; i < out->rows; i++)
+    {
+        int *o = out->data + i * out->stride;
+        int first = 1;
+        for (t = 0; t < count; t++)
+        {
+            const Matrix *leaf = terms[t].node->leaf;
+            int c = terms[t].coeff;
+            if (terms[t].node->op != MATRIX_EXPR_LEAF)
+                continue;
+            if (terms[t].trans)
+            {
+                const int *l = leaf->data + i;
+                for (j = 0; j < out->cols; j++)
+                    o[j] = (first ? 0 : o[j]) + c * l[j * leaf->stride];
+            }
+            else
+            {
+                const int *l = leaf->data + i * leaf->stride;
+                if (first)
+                    for (j = 0; j < out->cols; j++)
+                        o[j] = c * l[j];
+                else
+                    for (j = 0; j < out->cols; j++)
+                        o[j] += c * l[j];
+            }
+            first = 0;
+            written = 1;
+        }
+    }
+
+    // Products accumulate into what the leaf pass left
+    for (t = 0; t < nprod; t++)
+    {
+        ExprProduct *p = &products[t];
+        if (matrix_gemm_ex(out, p->alpha, p->a, p->trans_a, p->b, p->trans_b, written) != 0)
+            return -1;
+        written = 1;
+    }
+    if (!written)
+        matrix_zero(out);
+    return 0;
+}
+
+// Upper bound on the arena space expr_eval() can use: every inner node
+// materialized, every leaf staged once
+static size_t expr_scratch(const MatrixExpr *e)
+{
+    size_t bytes = matrix_arena_footprint((size_t)e->rows * e->cols * sizeof(int)) +
+                   matrix_arena_footprint(sizeof(Matrix)) + matrix_arena_footprint(sizeof(MatrixExpr));
+
+    if (e->lhs != NULL)
+        bytes += expr_scratch(e->lhs);
+    if (e->rhs != NULL)
+        bytes += expr_scratch(e->rhs);
+    return bytes;
+}
+
+int matrix_expr_eval(Matrix *out, const MatrixExpr *e, MatrixArena *arena)
+{
+    MatrixArena local;
+    size_t mark;
+    int status;
+
+    if (e == NULL || out->rows != e->rows || out->cols != e->cols)
+        return -1;
+    if (arena == NULL)
+    {
+        if (matrix_arena_init(&local, expr_scratch(e)) != 0)
+            return -1;
+        arena = &local;
+    }
+    mark = matrix_arena_mark(arena);
+    status = expr_eval(out, e, arena);
+    if (arena == &local)
+        matrix_arena_destroy(&local);
+    else
+        matrix_arena_release(arena, mark);
+    return status;
+}
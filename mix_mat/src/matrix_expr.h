@@ -0,0 +1,55 @@
+#ifndef MATRIX_EXPR_H
+#define MATRIX_EXPR_H
+
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Most leaf and product terms one expression may flatten to
+#define MATRIX_EXPR_MAX_TERMS 16
+
+typedef enum
+{
+    MATRIX_EXPR_LEAF,
+    MATRIX_EXPR_ADD,
+    MATRIX_EXPR_SCALE,
+    MATRIX_EXPR_TRANSPOSE,
+    MATRIX_EXPR_MUL
+} MatrixExprOp;
+
+// Node of a lazily built int matrix expression. Nothing is computed until
+// matrix_expr_eval().
+typedef struct MatrixExpr
+{
+    MatrixExprOp op;
+    int rows; // shape of the node's value
+    int cols;
+    int scalar;         // MATRIX_EXPR_SCALE
+    const Matrix *leaf; // MATRIX_EXPR_LEAF
+    const struct MatrixExpr *lhs;
+    const struct MatrixExpr *rhs;
+} MatrixExpr;
+
+// Node builders. Nodes live in 'arena' until it is released or reset. They
+// return NULL on a shape mismatch, a full arena or a NULL operand, so a whole
+// expression can be built first and checked once.
+const MatrixExpr *matrix_expr_leaf(MatrixArena *arena, const Matrix *m);
+const MatrixExpr *matrix_expr_add(MatrixArena *arena, const MatrixExpr *a, const MatrixExpr *b);
+const MatrixExpr *matrix_expr_sub(MatrixArena *arena, const MatrixExpr *a, const MatrixExpr *b);
+const MatrixExpr *matrix_expr_scale(MatrixArena *arena, int alpha, const MatrixExpr *a);
+const MatrixExpr *matrix_expr_transpose(MatrixArena *arena, const MatrixExpr *a);
+const MatrixExpr *matrix_expr_mul(MatrixArena *arena, const MatrixExpr *a, const MatrixExpr *b);
+
+// Evaluates e into out. The tree is first flattened into a sum of scaled
+// leaves and products: transposes become swapped strides (pushed through
+// products as (XY)^T = Y^T X^T), scale factors multiply into the term
+// coefficients. All leaf terms are then combined in one pass over out and
+// each product accumulates into it through matrix_gemm_ex() with its
+// coefficient folded in, so alpha * A * B + beta * C or (A * B)^T need no
+// temporaries. Only product operands that are themselves sums or products,
+// and leaves or product operands that overlap out (other than out itself as
+// the first leaf), are copied into 'arena' (NULL sizes a temporary one for
+// the worst case), so out may alias any operand. Returns 0 on success, -1 on
+// a NULL expression, a shape mismatch, too many terms or allocation failure.
+int matrix_expr_eval(Matrix *out, const MatrixExpr *e, MatrixArena *arena);
+
+#endif // MATRIX_EXPR_H
@@ -0,0 +1,259 @@
+#define _FILE_OFFSET_BITS 64
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrix_file.h"
+
+static uint64_t data_offset(void)
+{
+    return (sizeof(MatrixFileHeader) + MATRIX_FILE_ALIGN - 1) / MATRIX_FILE_ALIGN * MATRIX_FILE_ALIGN;
+}
+
+// Derives the tile geometry; -1 if one tile would not fit the address space
+static int set_geometry(MatrixFile *f, int rows, int cols, int tile, uint64_t offset)
+{
+    uint64_t tile_bytes = (uint64_t)tile * tile * sizeof(int32_t);
+
+    if (tile_bytes > (uint64_t)SIZE_MAX)
+        return -1;
+    f->rows = rows;
+    f->cols = cols;
+    f->tile = tile;
+    f->tile_rows = (rows + tile - 1) / tile;
+    f->tile_cols = (cols + tile - 1) / tile;
+    f->tile_bytes = (size_t)tile_bytes;
+    f->data_offset = offset;
+    f->size = offset + (uint64_t)f->tile_rows * f->tile_cols * tile_bytes;
+    return 0;
+}
+
+int matrix_file_create(MatrixFile *f, const char *path, int rows, int cols, int tile)
+{
+    MatrixFileHeader h;
+    uint64_t offset = data_offset();
+
+    if (rows <= 0 || cols <= 0 || tile <= 0 || tile % MATRIX_FILE_TILE_UNIT != 0)
+        return -1;
+    if (set_geometry(f, rows, cols, tile, offset) != 0)
+        return -1;
+    f->writable = 1;
+    f->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (f->fd < 0)
+        return -1;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MATRIX_FILE_MAGIC, sizeof(h.magic));
+    h.version = MATRIX_FILE_VERSION;
+    h.elem_size = sizeof(int32_t);
+    h.rows = rows;
+    h.cols = cols;
+    h.tile = tile;
+    h.data_offset = offset;
+    if (ftruncate(f->fd, (off_t)f->size) != 0 || pwrite(f->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h))
+    {
+        close(f->fd);
+        return -1;
+    }
+    return 0;
+}
+
+int matrix_file_open(MatrixFile *f, const char *path, int writable)
+{
+    MatrixFileHeader h;
+    struct stat st;
+
+    f->writable = writable;
+    f->fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (f->fd < 0)
+        return -1;
+    if (fstat(f->fd, &st) != 0 || pread(f->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h))
+        goto fail;
+    if (memcmp(h.magic, MATRIX_FILE_MAGIC, sizeof(h.magic)) != 0 || h.version != MATRIX_FILE_VERSION ||
+        h.elem_size != sizeof(int32_t) || h.rows == 0 || h.cols == 0 || h.rows > INT32_MAX ||
+        h.cols > INT32_MAX || h.tile == 0 || h.tile > INT32_MAX || h.tile % MATRIX_FILE_TILE_UNIT != 0 ||
+        h.data_offset < sizeof(h) || h.data_offset % MATRIX_FILE_ALIGN != 0)
+        goto fail;
+    if (set_geometry(f, (int)h.rows, (int)h.cols, (int)h.tile, h.data_offset) != 0 ||
+        (uint64_t)st.st_size < f->size)
+        goto fail;
+    return 0;
+
+fail:
+    close(f->fd);
+    return -1;
+}
+
+int matrix_file_close(MatrixFile *f)
+{
+    int status = 0;
+
+    if (f->writable && fsync(f->fd) != 0)
+        status = -1;
+    if (close(f->fd) != 0)
+        status = -1;
+    f->fd = -1;
+    return status;
+}
+
+uint64_t matrix_file_tile_offset(const MatrixFile *f, int ti, int tj)
+{
+    return f->data_offset + ((uint64_t)ti * f->tile_cols + tj) * f->tile_bytes;
+}
+
+int matrix_file_map(const MatrixFile *f, MatrixFileSpan *s, int ti, int tj, int count)
+{
+    int prot = f->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    uint64_t first = (uint64_t)ti * f->tile_cols + tj, bytes = (uint64_t)count * f->tile_bytes;
+    void *map;
+
+    if (ti < 0 || tj < 0 || count <= 0 || first + count > (uint64_t)f->tile_rows * f->tile_cols ||
+        bytes > (uint64_t)SIZE_MAX)
+        return -1;
+    // Tiles are whole pages, so the offset is page aligned
+    map = mmap(NULL, (size_t)bytes, prot, MAP_SHARED, f->fd, (off_t)matrix_file_tile_offset(f, ti, tj));
+    if (map == MAP_FAILED)
+        return -1;
+    s->map = (unsigned char *)map;
+    s->size = (size_t)bytes;
+    s->tile = f->tile;
+    s->tile_bytes = f->tile_bytes;
+
+    // Tiles are fetched explicitly, so keep the kernel from reading ahead
+    // across tile boundaries on its own. This is only advice: a kernel that
+    // refuses it still serves the mapping.
+    (void)madvise(s->map, s->size, MADV_RANDOM);
+    return 0;
+}
+
+int matrix_file_unmap(MatrixFileSpan *s)
+{
+    int status = munmap(s->map, s->size);
+
+    s->map = NULL;
+    s->size = 0;
+    return status;
+}
+
+void matrix_file_span_tile(const MatrixFileSpan *s, Matrix *t, int index)
+{
+    matrix_view(t, (int *)(s->map + (size_t)index * s->tile_bytes), s->tile, s->tile, s->tile);
+}
+
+// Starts reading tiles into the page cache ahead of their mapping. Advice
+// only: if it fails the tiles are read on first touch instead.
+static void prefetch(const MatrixFile *f, int ti, int tj, int count)
+{
+    off_t at = (off_t)matrix_file_tile_offset(f, ti, tj), len = (off_t)count * f->tile_bytes;
+
+    (void)posix_fadvise(f->fd, at, len, POSIX_FADV_WILLNEED);
+}
+
+int matrix_file_store(MatrixFile *f, const Matrix *m)
+{
+    MatrixFileSpan s;
+    int i, j, t = f->tile;
+
+    if (!f->writable || m->rows != f->rows || m->cols != f->cols)
+        return -1;
+    for (i = 0; i < m->rows; i++)
+    {
+        if (i % t == 0 && matrix_file_map(f, &s, i / t, 0, f->tile_cols) != 0)
+            return -1;
+        // One tile-wide run of row i per tile column
+        for (j = 0; j < m->cols; j += t)
+        {
+            int *dst = (int *)(s.map + (size_t)(j / t) * s.tile_bytes) + (i % t) * t;
+            int run = m->cols - j < t ? m->cols - j : t;
+            memcpy(dst, m->data + i * m->stride + j, sizeof(int) * run);
+        }
+        if ((i % t == t - 1 || i == m->rows - 1) && matrix_file_unmap(&s) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+int matrix_file_load(Matrix *m, const MatrixFile *f)
+{
+    MatrixFileSpan s;
+    int i, j, t = f->tile;
+
+    if (m->rows != f->rows || m->cols != f->cols)
+        return -1;
+    for (i = 0; i < m->rows; i++)
+    {
+        if (i % t == 0 && matrix_file_map(f, &s, i / t, 0, f->tile_cols) != 0)
+            return -1;
+        for (j = 0; j < m->cols; j += t)
+        {
+            const int *src = (const int *)(s.map + (size_t)(j / t) * s.tile_bytes) + (i % t) * t;
+            int run = m->cols - j < t ? m->cols - j : t;
+            memcpy(m->data + i * m->stride + j, src, sizeof(int) * run);
+        }
+        if ((i % t == t - 1 || i == m->rows - 1) && matrix_file_unmap(&s) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+int matrix_file_gemm(MatrixFile *C, const MatrixFile *A, const MatrixFile *B)
+{
+    int ti, tj, k, nk = A->tile_cols, status = 0;
+    MatrixFileSpan arow, bs, cs;
+    Matrix a, b, c;
+
+    if (!C->writable || A->cols != B->rows || C->rows != A->rows || C->cols != B->cols ||
+        A->tile != B->tile || C->tile != A->tile)
+        return -1;
+
+    prefetch(A, 0, 0, nk);
+    prefetch(B, 0, 0, 1);
+    for (ti = 0; ti < C->tile_rows && status == 0; ti++)
+    {
+        if (matrix_file_map(A, &arow, ti, 0, nk) != 0)
+            return -1;
+        for (tj = 0; tj < C->tile_cols && status == 0; tj++)
+        {
+            if (matrix_file_map(C, &cs, ti, tj, 1) != 0)
+            {
+                status = -1;
+                break;
+            }
+            matrix_file_span_tile(&cs, &c, 0);
+            for (k = 0; k < nk && status == 0; k++)
+            {
+                // Start the reads of the next step before computing this one
+                if (k + 1 < nk)
+                    prefetch(B, k + 1, tj, 1);
+                else if (tj + 1 < C->tile_cols)
+                    prefetch(B, 0, tj + 1, 1);
+                else if (ti + 1 < C->tile_rows)
+                {
+                    prefetch(A, ti + 1, 0, nk);
+                    prefetch(B, 0, 0, 1);
+                }
+                if (matrix_file_map(B, &bs, k, tj, 1) != 0)
+                {
+                    status = -1;
+                    break;
+                }
+
+                matrix_file_span_tile(&arow, &a, k);
+                matrix_file_span_tile(&bs, &b, 0);
+                status = matrix_gemm_ex(&c, 1, &a, 0, &b, 0, k > 0);
+                status |= matrix_file_unmap(&bs);
+            }
+
+            // Dirty pages of a shared mapping survive munmap() in the page
+            // cache, so the tile can leave the address space once queued
+            if (status == 0 && msync(cs.map, cs.size, MS_ASYNC) != 0)
+                status = -1;
+            status |= matrix_file_unmap(&cs);
+        }
+        status |= matrix_file_unmap(&arow);
+    }
+    return status == 0 ? 0 : -1;
+}
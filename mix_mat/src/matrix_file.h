@@ -0,0 +1,106 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix.h"
+
+#define MATRIX_FILE_MAGIC "MATTILE1"
+#define MATRIX_FILE_VERSION 1
+
+// Tile data starts on a page boundary, and a tile edge must be a multiple of
+// MATRIX_FILE_TILE_UNIT so every tile (edge^2 int32 entries) is whole pages
+#define MATRIX_FILE_ALIGN 4096
+#define MATRIX_FILE_TILE_UNIT 32
+
+// Default tile edge: a 256 KB tile, the KC x NC panel the packed GEMM works in
+#define MATRIX_FILE_TILE 256
+
+// On-disk header, 64 bytes in host (little-endian) byte order. The data that
+// follows is ceil(rows / tile) x ceil(cols / tile) tiles in row-major tile
+// order. Each tile is a row-major tile x tile block of int32 padded with zeros
+// past the matrix edge, so any tile is one contiguous, page-aligned read.
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t elem_size; // bytes per entry, 4
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t tile;      // tile edge in entries
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint8_t pad[24];
+} MatrixFileHeader;
+
+// An open tiled matrix file. Nothing is mapped while it is open: tiles are
+// mapped a span at a time (matrix_file_map()), so a file may be far larger
+// than the address space of the 32-bit HPS.
+typedef struct
+{
+    int fd;
+    int writable;
+    int rows;
+    int cols;
+    int tile;
+    int tile_rows; // tiles down
+    int tile_cols; // tiles across
+    size_t tile_bytes;
+    uint64_t data_offset; // file offset of the first tile
+    uint64_t size;        // file bytes
+} MatrixFile;
+
+// Consecutive tiles of one file mapped together, e.g. a whole tile row
+typedef struct
+{
+    unsigned char *map;
+    size_t size;
+    int tile;
+    size_t tile_bytes;
+} MatrixFileSpan;
+
+// Creates (or truncates) 'path' as a zero rows x cols matrix with the given
+// tile edge, open read-write. The file starts sparse, so creating a huge
+// result costs no disk until tiles are written. Returns 0 on success, -1 on
+// bad arguments or an I/O error.
+int matrix_file_create(MatrixFile *f, const char *path, int rows, int cols, int tile);
+
+// Opens an existing file after checking its header; read-only unless 'writable'
+int matrix_file_open(MatrixFile *f, const char *path, int writable);
+
+// Flushes a writable file to disk and closes it
+int matrix_file_close(MatrixFile *f);
+
+// File offset of tile (ti, tj)
+uint64_t matrix_file_tile_offset(const MatrixFile *f, int ti, int tj);
+
+// Maps 'count' tiles starting at (ti, tj) in row-major tile order (read-write
+// if the file is writable) with MADV_RANDOM, since tiles are fetched
+// explicitly. The advice is best effort. Returns 0 on success, -1 if the run
+// leaves the file or mmap() fails.
+int matrix_file_map(const MatrixFile *f, MatrixFileSpan *s, int ti, int tj, int count);
+
+// Unmaps a span; written pages stay in the page cache until writeback
+int matrix_file_unmap(MatrixFileSpan *s);
+
+// Tile 'index' of a span as a tile x tile Matrix view, padding included
+void matrix_file_span_tile(const MatrixFileSpan *s, Matrix *t, int index);
+
+// Copies between a file and an in-memory matrix of the same shape, one tile
+// row mapping at a time
+int matrix_file_store(MatrixFile *f, const Matrix *m);
+int matrix_file_load(Matrix *m, const MatrixFile *f);
+
+// Out-of-core C = A * B over tiled files with a common tile edge. C tiles are
+// computed in row-major order with the row of A tiles for one row of C mapped
+// as a span, while B and C are mapped a tile at a time. The next step's tiles
+// are prefetched with posix_fadvise(POSIX_FADV_WILLNEED) so the disk reads
+// overlap the tile product, and unmapped once used, so the address space and
+// resident set stay at one A tile row plus two tiles however big the files
+// are; a refused prefetch only costs the overlap. Finished C tiles are queued
+// for writeback with msync(MS_ASYNC). Returns 0 on success, -1 on a shape or
+// tile mismatch, a read-only C, a failed mapping or writeback call, or a
+// failed product.
+int matrix_file_gemm(MatrixFile *C, const MatrixFile *A, const MatrixFile *B);
+
+#endif // MATRIX_FILE_H
@@ -0,0 +1,29 @@
+#ifndef MATRIX_FIXED_H
+#define MATRIX_FIXED_H
+
+#include <stddef.h>
+#include "matrix.h"
+
+// Fully unrolled int kernels for the product shapes we use most. The kernels
+// and the lookup switch live in matrix_fixed_gen.c, which the Makefile
+// generates from scripts/gen_fixed_kernels.py; edit the SHAPES list there to
+// add a shape.
+
+// c (m x n) = a (m x k) * b (k x n); ld* are row strides in elements
+typedef void (*MatrixFixedKernel)(int *c, int ldc, const int *a, int lda, const int *b, int ldb);
+
+typedef struct
+{
+    int m;
+    int k;
+    int n;
+    MatrixFixedKernel fn;
+} MatrixFixedShape;
+
+extern const MatrixFixedShape matrix_fixed_shapes[];
+extern const int matrix_fixed_shape_count;
+
+// Returns the specialized kernel for an m x k times k x n product, or NULL
+MatrixFixedKernel matrix_fixed_lookup(int m, int k, int n);
+
+#endif // MATRIX_FIXED_H
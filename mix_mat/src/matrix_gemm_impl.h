@@ -0,0 +1,229 @@
+// Packed, cache-blocked GEMM driver shared by the element types in matrix.c.
+// This file is included once per type after defining:
+//   GEMM_NAME(x)  - suffixes the generated function names, e.g. x##_i32
+//   GEMM_IN       - operand element type
+//   GEMM_OUT      - result element type
+//   GEMM_A_TYPE   - operand matrix struct
+//   GEMM_C_TYPE   - result matrix struct
+//   GEMM_KERNEL   - member of MatrixKernels holding the micro-kernel
+// and a matrix_pack_buffer() returning the calling thread's packing buffer.
+// It defines GEMM_NAME(gemm)(C, a, b, K, acc) computing C (+)= A * B on the
+// calling thread and GEMM_NAME(gemm_parallel)(C, A, trans_a, B, trans_b,
+// alpha, acc) which splits large products into panels of C for the worker pool.
+
+// Operand as seen by the driver: element (i, k) is data[i * rs + k * cs]. A
+// transposed operand is the same storage with rs and cs swapped; the packing
+// routines absorb the difference, so the micro-kernels never see it. A scale
+// factor on A is applied while packing it.
+typedef struct
+{
+    const GEMM_IN *data;
+    int rs;
+    int cs;
+    GEMM_IN alpha;
+} GEMM_NAME(GemmOperand);
+
+static GEMM_NAME(GemmOperand) GEMM_NAME(operand)(const GEMM_A_TYPE *m, int trans)
+{
+    GEMM_NAME(GemmOperand) op;
+    op.data = m->data;
+    op.rs = trans ? 1 : m->stride;
+    op.cs = trans ? m->stride : 1;
+    op.alpha = 1;
+    return op;
+}
+
+// Plain i-k-j loop for products too small to repay packing
+static void GEMM_NAME(gemm_small)(GEMM_C_TYPE *C, GEMM_NAME(GemmOperand) a, GEMM_NAME(GemmOperand) b, int K,
+                                  int accumulate)
+{
+    int i, j, k;
+    for (i = 0; i < C->rows; i++)
+    {
+        GEMM_OUT *c = C->data + i * C->stride;
+        if (!accumulate)
+            for (j = 0; j < C->cols; j++)
+                c[j] = 0;
+        for (k = 0; k < K; k++)
+        {
+            GEMM_OUT av = (GEMM_OUT)(a.alpha * a.data[i * a.rs + k * a.cs]);
+            const GEMM_IN *brow = b.data + k * b.rs;
+            if (b.cs == 1)
+            {
+                for (j = 0; j < C->cols; j++)
+                    c[j] += av * brow[j];
+            }
+            else
+            {
+                for (j = 0; j < C->cols; j++)
+                    c[j] += av * brow[j * b.cs];
+            }
+        }
+    }
+}
+
+// Copies an mc x kc block of A into MR-row slivers laid out column by column, so
+// the micro-kernel reads A sequentially. Short slivers are zero padded.
+static void GEMM_NAME(pack_a)(GEMM_IN *dst, const GEMM_IN *a, int rs, int cs, GEMM_IN alpha, int mc, int kc)
+{
+    int i, k, r;
+    for (i = 0; i < mc; i += MATRIX_MR)
+    {
+        int rows = mc - i < MATRIX_MR ? mc - i : MATRIX_MR;
+        for (k = 0; k < kc; k++)
+        {
+            for (r = 0; r < rows; r++)
+                *dst++ = alpha * a[(i + r) * rs + k * cs];
+            for (; r < MATRIX_MR; r++)
+                *dst++ = 0;
+        }
+    }
+}
+
+// Copies a kc x nc panel of B into NR-column slivers laid out row by row.
+// Short slivers are zero padded.
+static void GEMM_NAME(pack_b)(GEMM_IN *dst, const GEMM_IN *b, int rs, int cs, int kc, int nc)
+{
+    int j, k, c;
+    for (j = 0; j < nc; j += MATRIX_NR)
+    {
+        int cols = nc - j < MATRIX_NR ? nc - j : MATRIX_NR;
+        for (k = 0; k < kc; k++)
+        {
+            const GEMM_IN *row = b + k * rs + j * cs;
+            for (c = 0; c < cols; c++)
+                *dst++ = row[c * cs];
+            for (; c < MATRIX_NR; c++)
+                *dst++ = 0;
+        }
+    }
+}
+
+// Blocked GEMM in the GotoBLAS loop order: NC panels of B, KC slices of the
+// shared dimension, MC blocks of A, then MR x NR register tiles.
+static int GEMM_NAME(gemm)(GEMM_C_TYPE *C, GEMM_NAME(GemmOperand) a, GEMM_NAME(GemmOperand) b, int K,
+                           int accumulate)
+{
+    int M = C->rows, N = C->cols;
+    int jc, pc, ic, jr, ir;
+    GEMM_IN *packed_a, *packed_b;
+    const MatrixKernels *kernels;
+
+    if ((long long)M * N * K <= MATRIX_SMALL_WORK)
+    {
+        GEMM_NAME(gemm_small)(C, a, b, K, accumulate);
+        return 0;
+    }
+
+    packed_a = (GEMM_IN *)matrix_pack_buffer();
+    if (packed_a == NULL)
+        return -1;
+    packed_b = packed_a + MATRIX_MC * MATRIX_KC;
+    kernels = matrix_kernels();
+
+    for (jc = 0; jc < N; jc += MATRIX_NC)
+    {
+        int nc = N - jc < MATRIX_NC ? N - jc : MATRIX_NC;
+        for (pc = 0; pc < K; pc += MATRIX_KC)
+        {
+            int kc = K - pc < MATRIX_KC ? K - pc : MATRIX_KC;
+            GEMM_NAME(pack_b)(packed_b, b.data + pc * b.rs + jc * b.cs, b.rs, b.cs, kc, nc);
+
+            for (ic = 0; ic < M; ic += MATRIX_MC)
+            {
+                int mc = M - ic < MATRIX_MC ? M - ic : MATRIX_MC;
+                GEMM_NAME(pack_a)(packed_a, a.data + ic * a.rs + pc * a.cs, a.rs, a.cs, a.alpha, mc, kc);
+
+                for (jr = 0; jr < nc; jr += MATRIX_NR)
+                {
+                    int n = nc - jr < MATRIX_NR ? nc - jr : MATRIX_NR;
+                    for (ir = 0; ir < mc; ir += MATRIX_MR)
+                    {
+                        int m = mc - ir < MATRIX_MR ? mc - ir : MATRIX_MR;
+                        kernels->GEMM_KERNEL(kc, packed_a + ir * kc, packed_b + jr * kc,
+                                             C->data + (ic + ir) * C->stride + jc + jr, C->stride,
+                                             m, n, accumulate || pc > 0);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Arguments shared by the panel tasks of one parallel product
+typedef struct
+{
+    GEMM_C_TYPE *C;
+    GEMM_NAME(GemmOperand) a;
+    GEMM_NAME(GemmOperand) b;
+    int K;
+    int accumulate;
+    int split_rows; // tasks own row panels of C (and A) if set, else column panels (and B)
+    int panel;      // rows or columns per task
+    int status;
+} GEMM_NAME(GemmJob);
+
+static void GEMM_NAME(gemm_task)(void *arg, int index)
+{
+    GEMM_NAME(GemmJob) *job = (GEMM_NAME(GemmJob) *)arg;
+    GEMM_C_TYPE c = *job->C;
+    GEMM_NAME(GemmOperand) a = job->a;
+    GEMM_NAME(GemmOperand) b = job->b;
+    int begin = index * job->panel;
+
+    if (job->split_rows)
+    {
+        c.rows = c.rows - begin < job->panel ? c.rows - begin : job->panel;
+        c.data += begin * c.stride;
+        a.data += begin * a.rs;
+    }
+    else
+    {
+        c.cols = c.cols - begin < job->panel ? c.cols - begin : job->panel;
+        c.data += begin;
+        b.data += begin * b.cs;
+    }
+    if (GEMM_NAME(gemm)(&c, a, b, job->K, job->accumulate) != 0)
+        job->status = -1;
+}
+
+// C = alpha * op(A) * op(B), plus the old C if 'accumulate' is set, where op
+// transposes when trans_a / trans_b is set. Splits C along its longer side
+// into a few panels per worker, each a whole number of register tiles, so
+// idle workers have something left to steal.
+static int GEMM_NAME(gemm_parallel)(GEMM_C_TYPE *C, const GEMM_A_TYPE *A, int trans_a,
+                                    const GEMM_A_TYPE *B, int trans_b, GEMM_IN alpha, int accumulate)
+{
+    GEMM_NAME(GemmJob) job;
+    int M = trans_a ? A->cols : A->rows;
+    int K = trans_a ? A->rows : A->cols;
+    int N = trans_b ? B->rows : B->cols;
+    int extent, unit, tasks, threads;
+
+    if ((trans_b ? B->cols : B->rows) != K || C->rows != M || C->cols != N)
+        return -1;
+
+    job.C = C;
+    job.a = GEMM_NAME(operand)(A, trans_a);
+    job.b = GEMM_NAME(operand)(B, trans_b);
+    job.a.alpha = alpha;
+    job.K = K;
+    job.accumulate = accumulate;
+    if ((long long)M * N * K < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+        return GEMM_NAME(gemm)(C, job.a, job.b, K, accumulate);
+
+    job.split_rows = M >= N;
+    job.status = 0;
+    extent = job.split_rows ? M : N;
+    unit = job.split_rows ? MATRIX_MR : MATRIX_NR;
+
+    tasks = threads * 4;
+    job.panel = (extent + tasks - 1) / tasks;
+    job.panel = (job.panel + unit - 1) / unit * unit;
+    tasks = (extent + job.panel - 1) / job.panel;
+
+    matrix_pool_run(GEMM_NAME(gemm_task), &job, tasks);
+    return job.status;
+}
@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <sys/auxv.h>
+#endif
+#include "matrix_kernels.h"
+
+#ifndef HWCAP_ARM_NEON
+#define HWCAP_ARM_NEON (1 << 12)
+#endif
+
+void matrix_tile_store_i32(const int *tile, int *c, int ldc, int m, int n, int accumulate)
+{
+    int i, j;
+    for (i = 0; i < m; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            if (accumulate)
+                c[i * ldc + j] += tile[i * MATRIX_NR + j];
+            else
+                c[i * ldc + j] = tile[i * MATRIX_NR + j];
+        }
+    }
+}
+
+void matrix_tile_store_f32(const float *tile, float *c, int ldc, int m, int n, int accumulate)
+{
+    int i, j;
+    for (i = 0; i < m; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            if (accumulate)
+                c[i * ldc + j] += tile[i * MATRIX_NR + j];
+            else
+                c[i * ldc + j] = tile[i * MATRIX_NR + j];
+        }
+    }
+}
+
+// Portable kernels: the MR x NR accumulator array is small enough for the
+// compiler to keep in registers and auto-vectorize where it can.
+static void scalar_i32(int kc, const int *a, const int *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    int acc[MATRIX_MR * MATRIX_NR];
+    int i, j, k;
+
+    memset(acc, 0, sizeof(acc));
+    for (k = 0; k < kc; k++)
+    {
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            int ai = a[i];
+            for (j = 0; j < MATRIX_NR; j++)
+                acc[i * MATRIX_NR + j] += ai * b[j];
+        }
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+    matrix_tile_store_i32(acc, c, ldc, m, n, accumulate);
+}
+
+static void scalar_s16(int kc, const int16_t *a, const int16_t *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    int acc[MATRIX_MR * MATRIX_NR];
+    int i, j, k;
+
+    memset(acc, 0, sizeof(acc));
+    for (k = 0; k < kc; k++)
+    {
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            int ai = a[i];
+            for (j = 0; j < MATRIX_NR; j++)
+                acc[i * MATRIX_NR + j] += ai * b[j];
+        }
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+    matrix_tile_store_i32(acc, c, ldc, m, n, accumulate);
+}
+
+static void scalar_f32(int kc, const float *a, const float *b, float *c, int ldc, int m, int n, int accumulate)
+{
+    float acc[MATRIX_MR * MATRIX_NR];
+    int i, j, k;
+
+    for (i = 0; i < MATRIX_MR * MATRIX_NR; i++)
+        acc[i] = 0.0f;
+    for (k = 0; k < kc; k++)
+    {
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            float ai = a[i];
+            for (j = 0; j < MATRIX_NR; j++)
+                acc[i * MATRIX_NR + j] += ai * b[j];
+        }
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+    matrix_tile_store_f32(acc, c, ldc, m, n, accumulate);
+}
+
+const MatrixKernels matrix_kernels_scalar = {"scalar", scalar_i32, scalar_s16, scalar_f32};
+
+static const MatrixKernels *selected_kernels = NULL;
+
+// Picks the widest kernel set the running CPU supports
+static const MatrixKernels *detect_kernels(void)
+{
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (getauxval(AT_HWCAP) & HWCAP_ARM_NEON)
+        return &matrix_kernels_neon;
+#endif
+#if defined(__SSE2__)
+    if (matrix_kernels_avx2_supported())
+        return &matrix_kernels_avx2;
+    return &matrix_kernels_sse2;
+#endif
+    return &matrix_kernels_scalar;
+}
+
+int matrix_kernels_select(const char *name)
+{
+    if (strcmp(name, "scalar") == 0)
+    {
+        selected_kernels = &matrix_kernels_scalar;
+        return 0;
+    }
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (strcmp(name, "neon") == 0 && (getauxval(AT_HWCAP) & HWCAP_ARM_NEON))
+    {
+        selected_kernels = &matrix_kernels_neon;
+        return 0;
+    }
+#endif
+#if defined(__SSE2__)
+    if (strcmp(name, "sse2") == 0)
+    {
+        selected_kernels = &matrix_kernels_sse2;
+        return 0;
+    }
+    if (strcmp(name, "avx2") == 0 && matrix_kernels_avx2_supported())
+    {
+        selected_kernels = &matrix_kernels_avx2;
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+// The selection is idempotent, so concurrent first calls may both run it safely
+const MatrixKernels *matrix_kernels(void)
+{
+    if (selected_kernels == NULL)
+    {
+        const char *name = getenv("MATRIX_KERNELS");
+        if (name == NULL || matrix_kernels_select(name) != 0)
+            selected_kernels = detect_kernels();
+    }
+    return selected_kernels;
+}
@@ -0,0 +1,48 @@
+#ifndef MATRIX_KERNELS_H
+#define MATRIX_KERNELS_H
+
+#include <stdint.h>
+#include "matrix.h"
+
+// Register-blocked micro-kernels used by the packed GEMM drivers in matrix.c.
+// Each call computes one MATRIX_MR x MATRIX_NR tile of C from kc columns of a
+// packed A sliver (MR values per k) and kc rows of a packed B sliver (NR values
+// per k). Only the top-left m x n corner of the tile is written back; it
+// overwrites C when 'accumulate' is 0 and is added to C otherwise.
+typedef void (*MatrixKernelI32)(int kc, const int *a, const int *b, int *c, int ldc, int m, int n, int accumulate);
+typedef void (*MatrixKernelS16)(int kc, const int16_t *a, const int16_t *b, int *c, int ldc, int m, int n, int accumulate);
+typedef void (*MatrixKernelF32)(int kc, const float *a, const float *b, float *c, int ldc, int m, int n, int accumulate);
+
+// One instruction-set flavour of the micro-kernels
+typedef struct
+{
+    const char *name;
+    MatrixKernelI32 i32;
+    MatrixKernelS16 s16;
+    MatrixKernelF32 f32;
+} MatrixKernels;
+
+extern const MatrixKernels matrix_kernels_scalar;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+extern const MatrixKernels matrix_kernels_neon;
+#endif
+#if defined(__SSE2__)
+extern const MatrixKernels matrix_kernels_sse2;
+extern const MatrixKernels matrix_kernels_avx2;
+int matrix_kernels_avx2_supported(void);
+#endif
+
+// Returns the kernel set in use. The first call picks the widest set the CPU
+// supports (NEON on the HPS, AVX2 or SSE2 on an x86 host, scalar otherwise);
+// setting MATRIX_KERNELS=scalar|neon|sse2|avx2 in the environment overrides it.
+const MatrixKernels *matrix_kernels(void);
+
+// Forces a kernel set by name. Returns -1 if it is unknown or not supported here.
+int matrix_kernels_select(const char *name);
+
+// Writes back the valid m x n corner of a full MR x NR tile held in 'tile'.
+// Used by the vector kernels for edge tiles.
+void matrix_tile_store_i32(const int *tile, int *c, int ldc, int m, int n, int accumulate);
+void matrix_tile_store_f32(const float *tile, float *c, int ldc, int m, int n, int accumulate);
+
+#endif // MATRIX_KERNELS_H
@@ -0,0 +1,151 @@
+// NEON micro-kernels for the Cortex-A9 (build with -mfpu=neon). Each keeps the
+// 4 x 8 tile of C in eight q registers and broadcasts one packed A value per row
+// with the by-lane multiply-accumulate forms.
+#include "matrix_kernels.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+static void neon_i32(int kc, const int *a, const int *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    int32x4_t c00 = vdupq_n_s32(0), c01 = vdupq_n_s32(0);
+    int32x4_t c10 = vdupq_n_s32(0), c11 = vdupq_n_s32(0);
+    int32x4_t c20 = vdupq_n_s32(0), c21 = vdupq_n_s32(0);
+    int32x4_t c30 = vdupq_n_s32(0), c31 = vdupq_n_s32(0);
+    int k;
+
+    for (k = 0; k < kc; k++)
+    {
+        int32x4_t av = vld1q_s32(a);
+        int32x2_t alo = vget_low_s32(av), ahi = vget_high_s32(av);
+        int32x4_t b0 = vld1q_s32(b), b1 = vld1q_s32(b + 4);
+
+        c00 = vmlaq_lane_s32(c00, b0, alo, 0);
+        c01 = vmlaq_lane_s32(c01, b1, alo, 0);
+        c10 = vmlaq_lane_s32(c10, b0, alo, 1);
+        c11 = vmlaq_lane_s32(c11, b1, alo, 1);
+        c20 = vmlaq_lane_s32(c20, b0, ahi, 0);
+        c21 = vmlaq_lane_s32(c21, b1, ahi, 0);
+        c30 = vmlaq_lane_s32(c30, b0, ahi, 1);
+        c31 = vmlaq_lane_s32(c31, b1, ahi, 1);
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    if (m == MATRIX_MR && n == MATRIX_NR)
+    {
+        if (accumulate)
+        {
+            c00 = vaddq_s32(c00, vld1q_s32(c));
+            c01 = vaddq_s32(c01, vld1q_s32(c + 4));
+            c10 = vaddq_s32(c10, vld1q_s32(c + ldc));
+            c11 = vaddq_s32(c11, vld1q_s32(c + ldc + 4));
+            c20 = vaddq_s32(c20, vld1q_s32(c + 2 * ldc));
+            c21 = vaddq_s32(c21, vld1q_s32(c + 2 * ldc + 4));
+            c30 = vaddq_s32(c30, vld1q_s32(c + 3 * ldc));
+            c31 = vaddq_s32(c31, vld1q_s32(c + 3 * ldc + 4));
+        }
+        vst1q_s32(c, c00);
+        vst1q_s32(c + 4, c01);
+        vst1q_s32(c + ldc, c10);
+        vst1q_s32(c + ldc + 4, c11);
+        vst1q_s32(c + 2 * ldc, c20);
+        vst1q_s32(c + 2 * ldc + 4, c21);
+        vst1q_s32(c + 3 * ldc, c30);
+        vst1q_s32(c + 3 * ldc + 4, c31);
+    }
+    else
+    {
+        int tile[MATRIX_MR * MATRIX_NR];
+        vst1q_s32(tile, c00);
+        vst1q_s32(tile + 4, c01);
+        vst1q_s32(tile + 8, c10);
+        vst1q_s32(tile + 12, c11);
+        vst1q_s32(tile + 16, c20);
+        vst1q_s32(tile + 20, c21);
+        vst1q_s32(tile + 24, c30);
+        vst1q_s32(tile + 28, c31);
+        matrix_tile_store_i32(tile, c, ldc, m, n, accumulate);
+    }
+}
+
+// int16 operands widen into int32 accumulators with vmlal_lane_s16
+static void neon_s16(int kc, const int16_t *a, const int16_t *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    int32x4_t c00 = vdupq_n_s32(0), c01 = vdupq_n_s32(0);
+    int32x4_t c10 = vdupq_n_s32(0), c11 = vdupq_n_s32(0);
+    int32x4_t c20 = vdupq_n_s32(0), c21 = vdupq_n_s32(0);
+    int32x4_t c30 = vdupq_n_s32(0), c31 = vdupq_n_s32(0);
+    int tile[MATRIX_MR * MATRIX_NR];
+    int k;
+
+    for (k = 0; k < kc; k++)
+    {
+        int16x4_t av = vld1_s16(a);
+        int16x8_t bv = vld1q_s16(b);
+        int16x4_t b0 = vget_low_s16(bv), b1 = vget_high_s16(bv);
+
+        c00 = vmlal_lane_s16(c00, b0, av, 0);
+        c01 = vmlal_lane_s16(c01, b1, av, 0);
+        c10 = vmlal_lane_s16(c10, b0, av, 1);
+        c11 = vmlal_lane_s16(c11, b1, av, 1);
+        c20 = vmlal_lane_s16(c20, b0, av, 2);
+        c21 = vmlal_lane_s16(c21, b1, av, 2);
+        c30 = vmlal_lane_s16(c30, b0, av, 3);
+        c31 = vmlal_lane_s16(c31, b1, av, 3);
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    vst1q_s32(tile, c00);
+    vst1q_s32(tile + 4, c01);
+    vst1q_s32(tile + 8, c10);
+    vst1q_s32(tile + 12, c11);
+    vst1q_s32(tile + 16, c20);
+    vst1q_s32(tile + 20, c21);
+    vst1q_s32(tile + 24, c30);
+    vst1q_s32(tile + 28, c31);
+    matrix_tile_store_i32(tile, c, ldc, m, n, accumulate);
+}
+
+static void neon_f32(int kc, const float *a, const float *b, float *c, int ldc, int m, int n, int accumulate)
+{
+    float32x4_t c00 = vdupq_n_f32(0.0f), c01 = vdupq_n_f32(0.0f);
+    float32x4_t c10 = vdupq_n_f32(0.0f), c11 = vdupq_n_f32(0.0f);
+    float32x4_t c20 = vdupq_n_f32(0.0f), c21 = vdupq_n_f32(0.0f);
+    float32x4_t c30 = vdupq_n_f32(0.0f), c31 = vdupq_n_f32(0.0f);
+    float tile[MATRIX_MR * MATRIX_NR];
+    int k;
+
+    for (k = 0; k < kc; k++)
+    {
+        float32x4_t av = vld1q_f32(a);
+        float32x2_t alo = vget_low_f32(av), ahi = vget_high_f32(av);
+        float32x4_t b0 = vld1q_f32(b), b1 = vld1q_f32(b + 4);
+
+        c00 = vmlaq_lane_f32(c00, b0, alo, 0);
+        c01 = vmlaq_lane_f32(c01, b1, alo, 0);
+        c10 = vmlaq_lane_f32(c10, b0, alo, 1);
+        c11 = vmlaq_lane_f32(c11, b1, alo, 1);
+        c20 = vmlaq_lane_f32(c20, b0, ahi, 0);
+        c21 = vmlaq_lane_f32(c21, b1, ahi, 0);
+        c30 = vmlaq_lane_f32(c30, b0, ahi, 1);
+        c31 = vmlaq_lane_f32(c31, b1, ahi, 1);
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    vst1q_f32(tile, c00);
+    vst1q_f32(tile + 4, c01);
+    vst1q_f32(tile + 8, c10);
+    vst1q_f32(tile + 12, c11);
+    vst1q_f32(tile + 16, c20);
+    vst1q_f32(tile + 20, c21);
+    vst1q_f32(tile + 24, c30);
+    vst1q_f32(tile + 28, c31);
+    matrix_tile_store_f32(tile, c, ldc, m, n, accumulate);
+}
+
+const MatrixKernels matrix_kernels_neon = {"neon", neon_i32, neon_s16, neon_f32};
+
+#endif // __ARM_NEON
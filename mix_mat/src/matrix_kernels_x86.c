@@ -0,0 +1,250 @@
+// SSE2 and AVX2 micro-kernels for x86 host builds. SSE2 is part of the x86-64
+// baseline; the AVX2 kernels are compiled with a per-function target attribute
+// so the rest of the build needs no extra flags, and are only selected when
+// the CPU reports AVX2 and FMA.
+#include "matrix_kernels.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+
+// SSE2 has no 32-bit low multiply; build it from two 32x32->64 multiplies
+static inline __m128i mullo_epi32_sse2(__m128i x, __m128i y)
+{
+    __m128i even = _mm_mul_epu32(x, y);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static void sse2_i32(int kc, const int *a, const int *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    __m128i acc[MATRIX_MR][2];
+    int tile[MATRIX_MR * MATRIX_NR];
+    int i, k;
+
+    for (i = 0; i < MATRIX_MR; i++)
+        acc[i][0] = acc[i][1] = _mm_setzero_si128();
+
+    for (k = 0; k < kc; k++)
+    {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)b);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(b + 4));
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            __m128i ai = _mm_set1_epi32(a[i]);
+            acc[i][0] = _mm_add_epi32(acc[i][0], mullo_epi32_sse2(b0, ai));
+            acc[i][1] = _mm_add_epi32(acc[i][1], mullo_epi32_sse2(b1, ai));
+        }
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    for (i = 0; i < MATRIX_MR; i++)
+    {
+        _mm_storeu_si128((__m128i *)(tile + i * MATRIX_NR), acc[i][0]);
+        _mm_storeu_si128((__m128i *)(tile + i * MATRIX_NR + 4), acc[i][1]);
+    }
+    matrix_tile_store_i32(tile, c, ldc, m, n, accumulate);
+}
+
+// int16 kernel: consecutive k rows of B are interleaved so _mm_madd_epi16 does
+// two multiply-accumulates per 32-bit lane against a broadcast (a[k], a[k+1]) pair.
+static void sse2_s16(int kc, const int16_t *a, const int16_t *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    __m128i acc[MATRIX_MR][2];
+    int tile[MATRIX_MR * MATRIX_NR];
+    int i, k;
+
+    for (i = 0; i < MATRIX_MR; i++)
+        acc[i][0] = acc[i][1] = _mm_setzero_si128();
+
+    for (k = 0; k < kc; k += 2)
+    {
+        __m128i bk = _mm_loadu_si128((const __m128i *)b);
+        __m128i bk1 = _mm_setzero_si128();
+        __m128i ak = _mm_loadl_epi64((const __m128i *)a);
+        __m128i ak1 = _mm_setzero_si128();
+        __m128i apairs, blo, bhi;
+
+        if (k + 1 < kc)
+        {
+            bk1 = _mm_loadu_si128((const __m128i *)(b + MATRIX_NR));
+            ak1 = _mm_loadl_epi64((const __m128i *)(a + MATRIX_MR));
+        }
+        blo = _mm_unpacklo_epi16(bk, bk1);
+        bhi = _mm_unpackhi_epi16(bk, bk1);
+        apairs = _mm_unpacklo_epi16(ak, ak1);
+
+        acc[0][0] = _mm_add_epi32(acc[0][0], _mm_madd_epi16(blo, _mm_shuffle_epi32(apairs, 0x00)));
+        acc[0][1] = _mm_add_epi32(acc[0][1], _mm_madd_epi16(bhi, _mm_shuffle_epi32(apairs, 0x00)));
+        acc[1][0] = _mm_add_epi32(acc[1][0], _mm_madd_epi16(blo, _mm_shuffle_epi32(apairs, 0x55)));
+        acc[1][1] = _mm_add_epi32(acc[1][1], _mm_madd_epi16(bhi, _mm_shuffle_epi32(apairs, 0x55)));
+        acc[2][0] = _mm_add_epi32(acc[2][0], _mm_madd_epi16(blo, _mm_shuffle_epi32(apairs, 0xAA)));
+        acc[2][1] = _mm_add_epi32(acc[2][1], _mm_madd_epi16(bhi, _mm_shuffle_epi32(apairs, 0xAA)));
+        acc[3][0] = _mm_add_epi32(acc[3][0], _mm_madd_epi16(blo, _mm_shuffle_epi32(apairs, 0xFF)));
+        acc[3][1] = _mm_add_epi32(acc[3][1], _mm_madd_epi16(bhi, _mm_shuffle_epi32(apairs, 0xFF)));
+        a += 2 * MATRIX_MR;
+        b += 2 * MATRIX_NR;
+    }
+
+    for (i = 0; i < MATRIX_MR; i++)
+    {
+        _mm_storeu_si128((__m128i *)(tile + i * MATRIX_NR), acc[i][0]);
+        _mm_storeu_si128((__m128i *)(tile + i * MATRIX_NR + 4), acc[i][1]);
+    }
+    matrix_tile_store_i32(tile, c, ldc, m, n, accumulate);
+}
+
+static void sse2_f32(int kc, const float *a, const float *b, float *c, int ldc, int m, int n, int accumulate)
+{
+    __m128 acc[MATRIX_MR][2];
+    float tile[MATRIX_MR * MATRIX_NR];
+    int i, k;
+
+    for (i = 0; i < MATRIX_MR; i++)
+        acc[i][0] = acc[i][1] = _mm_setzero_ps();
+
+    for (k = 0; k < kc; k++)
+    {
+        __m128 b0 = _mm_loadu_ps(b);
+        __m128 b1 = _mm_loadu_ps(b + 4);
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            __m128 ai = _mm_set1_ps(a[i]);
+            acc[i][0] = _mm_add_ps(acc[i][0], _mm_mul_ps(b0, ai));
+            acc[i][1] = _mm_add_ps(acc[i][1], _mm_mul_ps(b1, ai));
+        }
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    for (i = 0; i < MATRIX_MR; i++)
+    {
+        _mm_storeu_ps(tile + i * MATRIX_NR, acc[i][0]);
+        _mm_storeu_ps(tile + i * MATRIX_NR + 4, acc[i][1]);
+    }
+    matrix_tile_store_f32(tile, c, ldc, m, n, accumulate);
+}
+
+const MatrixKernels matrix_kernels_sse2 = {"sse2", sse2_i32, sse2_s16, sse2_f32};
+
+__attribute__((target("avx2")))
+static void avx2_i32(int kc, const int *a, const int *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    __m256i acc[MATRIX_MR];
+    int tile[MATRIX_MR * MATRIX_NR];
+    int i, k;
+
+    for (i = 0; i < MATRIX_MR; i++)
+        acc[i] = _mm256_setzero_si256();
+
+    for (k = 0; k < kc; k++)
+    {
+        __m256i bv = _mm256_loadu_si256((const __m256i *)b);
+        for (i = 0; i < MATRIX_MR; i++)
+            acc[i] = _mm256_add_epi32(acc[i], _mm256_mullo_epi32(bv, _mm256_set1_epi32(a[i])));
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    if (m == MATRIX_MR && n == MATRIX_NR)
+    {
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            __m256i *ci = (__m256i *)(c + i * ldc);
+            if (accumulate)
+                acc[i] = _mm256_add_epi32(acc[i], _mm256_loadu_si256(ci));
+            _mm256_storeu_si256(ci, acc[i]);
+        }
+        return;
+    }
+    for (i = 0; i < MATRIX_MR; i++)
+        _mm256_storeu_si256((__m256i *)(tile + i * MATRIX_NR), acc[i]);
+    matrix_tile_store_i32(tile, c, ldc, m, n, accumulate);
+}
+
+__attribute__((target("avx2")))
+static void avx2_s16(int kc, const int16_t *a, const int16_t *b, int *c, int ldc, int m, int n, int accumulate)
+{
+    __m256i acc[MATRIX_MR];
+    int tile[MATRIX_MR * MATRIX_NR];
+    int i, k;
+
+    for (i = 0; i < MATRIX_MR; i++)
+        acc[i] = _mm256_setzero_si256();
+
+    for (k = 0; k < kc; k += 2)
+    {
+        __m128i bk = _mm_loadu_si128((const __m128i *)b);
+        __m128i bk1 = _mm_setzero_si128();
+        __m128i ak = _mm_loadl_epi64((const __m128i *)a);
+        __m128i ak1 = _mm_setzero_si128();
+        __m128i apairs;
+        __m256i bv;
+
+        if (k + 1 < kc)
+        {
+            bk1 = _mm_loadu_si128((const __m128i *)(b + MATRIX_NR));
+            ak1 = _mm_loadl_epi64((const __m128i *)(a + MATRIX_MR));
+        }
+        bv = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(bk, bk1)),
+                                     _mm_unpackhi_epi16(bk, bk1), 1);
+        apairs = _mm_unpacklo_epi16(ak, ak1);
+
+        acc[0] = _mm256_add_epi32(acc[0], _mm256_madd_epi16(bv, _mm256_set1_epi32(_mm_cvtsi128_si32(apairs))));
+        acc[1] = _mm256_add_epi32(acc[1], _mm256_madd_epi16(bv, _mm256_set1_epi32(_mm_extract_epi32(apairs, 1))));
+        acc[2] = _mm256_add_epi32(acc[2], _mm256_madd_epi16(bv, _mm256_set1_epi32(_mm_extract_epi32(apairs, 2))));
+        acc[3] = _mm256_add_epi32(acc[3], _mm256_madd_epi16(bv, _mm256_set1_epi32(_mm_extract_epi32(apairs, 3))));
+        a += 2 * MATRIX_MR;
+        b += 2 * MATRIX_NR;
+    }
+
+    for (i = 0; i < MATRIX_MR; i++)
+        _mm256_storeu_si256((__m256i *)(tile + i * MATRIX_NR), acc[i]);
+    matrix_tile_store_i32(tile, c, ldc, m, n, accumulate);
+}
+
+__attribute__((target("avx2,fma")))
+static void avx2_f32(int kc, const float *a, const float *b, float *c, int ldc, int m, int n, int accumulate)
+{
+    __m256 acc[MATRIX_MR];
+    float tile[MATRIX_MR * MATRIX_NR];
+    int i, k;
+
+    for (i = 0; i < MATRIX_MR; i++)
+        acc[i] = _mm256_setzero_ps();
+
+    for (k = 0; k < kc; k++)
+    {
+        __m256 bv = _mm256_loadu_ps(b);
+        for (i = 0; i < MATRIX_MR; i++)
+            acc[i] = _mm256_fmadd_ps(bv, _mm256_set1_ps(a[i]), acc[i]);
+        a += MATRIX_MR;
+        b += MATRIX_NR;
+    }
+
+    if (m == MATRIX_MR && n == MATRIX_NR)
+    {
+        for (i = 0; i < MATRIX_MR; i++)
+        {
+            float *ci = c + i * ldc;
+            if (accumulate)
+                acc[i] = _mm256_add_ps(acc[i], _mm256_loadu_ps(ci));
+            _mm256_storeu_ps(ci, acc[i]);
+        }
+        return;
+    }
+    for (i = 0; i < MATRIX_MR; i++)
+        _mm256_storeu_ps(tile + i * MATRIX_NR, acc[i]);
+    matrix_tile_store_f32(tile, c, ldc, m, n, accumulate);
+}
+
+const MatrixKernels matrix_kernels_avx2 = {"avx2", avx2_i32, avx2_s16, avx2_f32};
+
+int matrix_kernels_avx2_supported(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#endif // __SSE2__
@@ -0,0 +1,354 @@
+#include <math.h>
+#include <string.h>
+#include "matrix_linalg.h"
+
+static void view_f32(MatrixF *sub, const MatrixF *m, int row, int col, int rows, int cols)
+{
+    sub->rows = rows;
+    sub->cols = cols;
+    sub->stride = m->stride;
+    sub->data = m->data + row * m->stride + col;
+}
+
+static void swap_rows(MatrixF *A, int r0, int r1)
+{
+    float *a = A->data + r0 * A->stride, *b = A->data + r1 * A->stride, t;
+    int j;
+
+    for (j = 0; j < A->cols; j++)
+    {
+        t = a[j];
+        a[j] = b[j];
+        b[j] = t;
+    }
+}
+
+// A[r.., c..] -= X * Y, one MATRIX_LA_BLOCK column panel at a time through
+// 'scratch' (X->rows x MATRIX_LA_BLOCK). With 'lower' only entries on or
+// below the diagonal of A[r.., c..] are computed and updated.
+static void trailing_update(MatrixF *A, int r, int c, const MatrixF *X, const MatrixF *Y, float *scratch, int lower)
+{
+    MatrixF T, Yp;
+    int jb, i, j;
+
+    for (jb = 0; jb < Y->cols; jb += MATRIX_LA_BLOCK)
+    {
+        int bs = Y->cols - jb < MATRIX_LA_BLOCK ? Y->cols - jb : MATRIX_LA_BLOCK;
+        int first = lower ? jb : 0;
+        MatrixF Xp;
+
+        view_f32(&Xp, X, first, 0, X->rows - first, X->cols);
+        view_f32(&Yp, Y, 0, jb, Y->rows, bs);
+        T.rows = Xp.rows;
+        T.cols = bs;
+        T.stride = bs;
+        T.data = scratch;
+        matrix_gemm_f32(&T, &Xp, &Yp);
+        for (i = 0; i < T.rows; i++)
+        {
+            float *a = A->data + (r + first + i) * A->stride + c + jb;
+            int width = lower && i + 1 < bs ? i + 1 : bs;
+            for (j = 0; j < width; j++)
+                a[j] -= MAT_AT(&T, i, j);
+        }
+    }
+}
+
+// LU of a square A with an n x MATRIX_LA_BLOCK workspace
+static int lu_factor(MatrixF *A, int *piv, float *scratch)
+{
+    int n = A->rows, k0, kb, j, i, c, singular = 0;
+
+    for (k0 = 0; k0 < n; k0 += MATRIX_LA_BLOCK)
+    {
+        kb = n - k0 < MATRIX_LA_BLOCK ? n - k0 : MATRIX_LA_BLOCK;
+
+        // Unblocked LU of the n - k0 x kb panel; swaps move whole rows so the
+        // columns left and right of the panel follow
+        for (j = k0; j < k0 + kb; j++)
+        {
+            int p = j;
+            float pivot;
+            for (i = j + 1; i < n; i++)
+                if (fabsf(MAT_AT(A, i, j)) > fabsf(MAT_AT(A, p, j)))
+                    p = i;
+            piv[j] = p;
+            if (p != j)
+                swap_rows(A, p, j);
+            pivot = MAT_AT(A, j, j);
+            if (pivot == 0.0f)
+            {
+                singular = 1;
+                continue;
+            }
+            for (i = j + 1; i < n; i++)
+            {
+                float l = MAT_AT(A, i, j) /= pivot;
+                for (c = j + 1; c < k0 + kb; c++)
+                    MAT_AT(A, i, c) -= l * MAT_AT(A, j, c);
+            }
+        }
+
+        if (k0 + kb < n)
+        {
+            MatrixF L11, A12, L21;
+            view_f32(&L11, A, k0, k0, kb, kb);
+            view_f32(&A12, A, k0, k0 + kb, kb, n - k0 - kb);
+            view_f32(&L21, A, k0 + kb, k0, n - k0 - kb, kb);
+
+            // U12 = L11^-1 * A12, then A22 -= L21 * U12
+            matrix_trsm_lower(&L11, &A12, 1);
+            trailing_update(A, k0 + kb, k0 + kb, &L21, &A12, scratch, 0);
+        }
+    }
+    return singular;
+}
+
+int matrix_lu(MatrixF *A, int *piv, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    float *work;
+    int status = -1;
+
+    if (A->cols != A->rows)
+        return -1;
+    work = (float *)matrix_scratch_begin(&scratch, arena, sizeof(float) * A->rows * MATRIX_LA_BLOCK);
+    if (work != NULL)
+        status = lu_factor(A, piv, work);
+    matrix_scratch_end(&scratch);
+    return status;
+}
+
+// Cholesky of a square A with a 2n x MATRIX_LA_BLOCK workspace
+static int cholesky_factor(MatrixF *A, float *scratch)
+{
+    int n = A->rows, k0, kb, j, i, c;
+    float *a21t = scratch + n * MATRIX_LA_BLOCK;
+
+    for (k0 = 0; k0 < n; k0 += MATRIX_LA_BLOCK)
+    {
+        int rest;
+        kb = n - k0 < MATRIX_LA_BLOCK ? n - k0 : MATRIX_LA_BLOCK;
+        rest = n - k0 - kb;
+
+        // Unblocked Cholesky of the kb x kb diagonal block
+        for (j = k0; j < k0 + kb; j++)
+        {
+            float d = MAT_AT(A, j, j);
+            for (c = k0; c < j; c++)
+                d -= MAT_AT(A, j, c) * MAT_AT(A, j, c);
+            if (!(d > 0.0f))
+                return 1;
+            d = sqrtf(d);
+            MAT_AT(A, j, j) = d;
+            for (i = j + 1; i < k0 + kb; i++)
+            {
+                float s = MAT_AT(A, i, j);
+                for (c = k0; c < j; c++)
+                    s -= MAT_AT(A, i, c) * MAT_AT(A, j, c);
+                MAT_AT(A, i, j) = s / d;
+            }
+        }
+
+        if (rest > 0)
+        {
+            MatrixF L21, L21t;
+
+            // L21 = A21 * L11^-T: each row is a forward substitution
+            for (i = k0 + kb; i < n; i++)
+            {
+                for (j = k0; j < k0 + kb; j++)
+                {
+                    float s = MAT_AT(A, i, j);
+                    for (c = k0; c < j; c++)
+                        s -= MAT_AT(A, i, c) * MAT_AT(A, j, c);
+                    MAT_AT(A, i, j) = s / MAT_AT(A, j, j);
+                }
+            }
+
+            // A22 -= L21 * L21^T on and below the diagonal
+            view_f32(&L21, A, k0 + kb, k0, rest, kb);
+            L21t.rows = kb;
+            L21t.cols = rest;
+            L21t.stride = rest;
+            L21t.data = a21t;
+            for (i = 0; i < rest; i++)
+                for (j = 0; j < kb; j++)
+                    MAT_AT(&L21t, j, i) = MAT_AT(&L21, i, j);
+            trailing_update(A, k0 + kb, k0 + kb, &L21, &L21t, scratch, 1);
+        }
+    }
+    return 0;
+}
+
+int matrix_cholesky(MatrixF *A, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    float *work;
+    int status = -1;
+
+    if (A->cols != A->rows)
+        return -1;
+    work = (float *)matrix_scratch_begin(&scratch, arena, sizeof(float) * A->rows * MATRIX_LA_BLOCK * 2);
+    if (work != NULL)
+        status = cholesky_factor(A, work);
+    matrix_scratch_end(&scratch);
+    return status;
+}
+
+// B[i, :] -= sum over the solved rows; the row updates are contiguous axpys
+int matrix_trsm_lower(const MatrixF *L, MatrixF *B, int unit_diag)
+{
+    int n = L->rows, i, k, j;
+
+    if (L->cols != n || B->rows != n)
+        return -1;
+    for (i = 0; i < n; i++)
+    {
+        float *b = B->data + i * B->stride;
+        for (k = 0; k < i; k++)
+        {
+            float l = MAT_AT(L, i, k);
+            const float *x = B->data + k * B->stride;
+            if (l != 0.0f)
+                for (j = 0; j < B->cols; j++)
+                    b[j] -= l * x[j];
+        }
+        if (!unit_diag)
+            for (j = 0; j < B->cols; j++)
+                b[j] /= MAT_AT(L, i, i);
+    }
+    return 0;
+}
+
+int matrix_trsm_upper(const MatrixF *U, MatrixF *B)
+{
+    int n = U->rows, i, k, j;
+
+    if (U->cols != n || B->rows != n)
+        return -1;
+    for (i = n - 1; i >= 0; i--)
+    {
+        float *b = B->data + i * B->stride;
+        float d = MAT_AT(U, i, i);
+        for (k = i + 1; k < n; k++)
+        {
+            float u = MAT_AT(U, i, k);
+            const float *x = B->data + k * B->stride;
+            if (u != 0.0f)
+                for (j = 0; j < B->cols; j++)
+                    b[j] -= u * x[j];
+        }
+        for (j = 0; j < B->cols; j++)
+            b[j] /= d;
+    }
+    return 0;
+}
+
+int matrix_trsm_lower_t(const MatrixF *L, MatrixF *B)
+{
+    int n = L->rows, i, k, j;
+
+    if (L->cols != n || B->rows != n)
+        return -1;
+    for (i = n - 1; i >= 0; i--)
+    {
+        float *b = B->data + i * B->stride;
+        for (k = i + 1; k < n; k++)
+        {
+            float l = MAT_AT(L, k, i);
+            const float *x = B->data + k * B->stride;
+            if (l != 0.0f)
+                for (j = 0; j < B->cols; j++)
+                    b[j] -= l * x[j];
+        }
+        for (j = 0; j < B->cols; j++)
+            b[j] /= MAT_AT(L, i, i);
+    }
+    return 0;
+}
+
+int matrix_lu_solve(const MatrixF *LU, const int *piv, MatrixF *B)
+{
+    int i;
+
+    if (LU->rows != LU->cols || B->rows != LU->rows)
+        return -1;
+    for (i = 0; i < B->rows; i++)
+        if (piv[i] != i)
+            swap_rows(B, i, piv[i]);
+    matrix_trsm_lower(LU, B, 1);
+    return matrix_trsm_upper(LU, B);
+}
+
+int matrix_cholesky_solve(const MatrixF *L, MatrixF *B)
+{
+    if (matrix_trsm_lower(L, B, 0) != 0)
+        return -1;
+    return matrix_trsm_lower_t(L, B);
+}
+
+// LU of a copy of A, with the copy, the pivots and the factorization
+// workspace carved from one scratch block. Returns matrix_lu()'s status.
+static int lu_copy(const MatrixF *A, MatrixScratch *scratch, MatrixArena *arena, MatrixF *LU, int **piv)
+{
+    int n = A->rows, i;
+    size_t lu_bytes = matrix_arena_footprint(sizeof(float) * n * n);
+    size_t piv_bytes = matrix_arena_footprint(sizeof(int) * n);
+    unsigned char *buf;
+
+    buf = (unsigned char *)matrix_scratch_begin(scratch, arena,
+                                                lu_bytes + piv_bytes + sizeof(float) * n * MATRIX_LA_BLOCK);
+    if (buf == NULL)
+        return -1;
+    LU->rows = LU->cols = LU->stride = n;
+    LU->data = (float *)buf;
+    *piv = (int *)(buf + lu_bytes);
+    for (i = 0; i < n; i++)
+        memcpy(LU->data + i * LU->stride, A->data + i * A->stride, sizeof(float) * n);
+    return lu_factor(LU, *piv, (float *)(buf + lu_bytes + piv_bytes));
+}
+
+int matrix_det(const MatrixF *A, double *det, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    MatrixF LU;
+    int *piv, i, status;
+    double d = 1.0;
+
+    if (A->rows != A->cols)
+        return -1;
+    status = lu_copy(A, &scratch, arena, &LU, &piv);
+    if (status >= 0)
+    {
+        for (i = 0; i < A->rows; i++)
+            d *= piv[i] != i ? -MAT_AT(&LU, i, i) : MAT_AT(&LU, i, i);
+        *det = status == 1 ? 0.0 : d;
+        status = 0;
+    }
+    matrix_scratch_end(&scratch);
+    return status;
+}
+
+int matrix_inverse(MatrixF *inv, const MatrixF *A, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    MatrixF LU;
+    int *piv, i, n = A->rows, status;
+
+    if (A->cols != n || inv->rows != n || inv->cols != n)
+        return -1;
+    status = lu_copy(A, &scratch, arena, &LU, &piv);
+    if (status == 0)
+    {
+        // Solve against the identity
+        for (i = 0; i < n; i++)
+        {
+            memset(inv->data + i * inv->stride, 0, sizeof(float) * n);
+            MAT_AT(inv, i, i) = 1.0f;
+        }
+        status = matrix_lu_solve(&LU, piv, inv);
+    }
+    matrix_scratch_end(&scratch);
+    return status;
+}
@@ -0,0 +1,45 @@
+#ifndef MATRIX_LINALG_H
+#define MATRIX_LINALG_H
+
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Columns factored per panel. The trailing update of each step is a
+// (n - k) x MATRIX_LA_BLOCK times MATRIX_LA_BLOCK x MATRIX_LA_BLOCK product
+// per column panel, large enough for the packed matrix_gemm_f32() to pay off.
+#define MATRIX_LA_BLOCK 32
+
+// Workspaces of the factorizations, det and inverse come from the 'arena'
+// argument; NULL uses a temporary heap arena.
+
+// Right-looking blocked LU with partial pivoting, in place: A = P * L * U with
+// unit-diagonal L below the diagonal and U on and above it. piv[i] is the row
+// swapped with row i at step i. Returns 0 on success, 1 if a pivot is exactly
+// zero (A is singular; the factors are still complete), -1 on a non-square A
+// or allocation failure.
+int matrix_lu(MatrixF *A, int *piv, MatrixArena *arena);
+
+// Right-looking blocked Cholesky, in place: A = L * L^T with L written to the
+// lower triangle (the upper triangle is left untouched). Returns 0 on success,
+// 1 if A is not positive definite, -1 on a non-square A or allocation failure.
+int matrix_cholesky(MatrixF *A, MatrixArena *arena);
+
+// Triangular solves with multiple right-hand sides, B overwritten with X:
+// lower solves L * X = B (unit_diag ignores the stored diagonal), upper solves
+// U * X = B, and lower_t solves L^T * X = B using the lower triangle only.
+int matrix_trsm_lower(const MatrixF *L, MatrixF *B, int unit_diag);
+int matrix_trsm_upper(const MatrixF *U, MatrixF *B);
+int matrix_trsm_lower_t(const MatrixF *L, MatrixF *B);
+
+// Solve A * X = B from the factors of matrix_lu() or matrix_cholesky()
+int matrix_lu_solve(const MatrixF *LU, const int *piv, MatrixF *B);
+int matrix_cholesky_solve(const MatrixF *L, MatrixF *B);
+
+// det(A) through an LU of a copy; 0 for a singular A. Returns -1 on a
+// non-square A or allocation failure.
+int matrix_det(const MatrixF *A, double *det, MatrixArena *arena);
+
+// inv = A^-1 through LU. inv may be A. Returns 1 if A is singular.
+int matrix_inverse(MatrixF *inv, const MatrixF *A, MatrixArena *arena);
+
+#endif // MATRIX_LINALG_H
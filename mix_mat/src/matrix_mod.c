@@ -0,0 +1,140 @@
+#include "matrix_mod.h"
+#include "matrix_pool.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+int matrix_modulus_init(MatrixModulus *mod, uint32_t p)
+{
+    uint64_t bound, limit;
+
+    if (p < 2 || p > INT32_MAX)
+        return -1;
+    bound = (uint64_t)(p - 1) * (p - 1);
+    limit = UINT64_MAX / bound;
+    mod->p = p;
+    mod->barrett = UINT64_MAX / p;
+    mod->batch = limit > INT32_MAX ? INT32_MAX : (int)limit;
+    return 0;
+}
+
+void matrix_mod_canonical(Matrix *m, const MatrixModulus *mod)
+{
+    int64_t p = mod->p;
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = (int)(((int64_t)MAT_AT(m, i, j) % p + p) % p);
+}
+
+// acc[j] += a * b[j] for j < n, all products widened to 64 bits. NEON uses
+// vmlal_n_u32 on two lanes at a time; SSE2 zero-extends B into 64-bit lanes
+// for _mm_mul_epu32.
+static void mac_row(uint64_t *acc, uint32_t a, const int *b, int n)
+{
+    int j = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; j + 4 <= n; j += 4)
+    {
+        uint32x4_t bv = vld1q_u32((const uint32_t *)b + j);
+        vst1q_u64(acc + j, vmlal_n_u32(vld1q_u64(acc + j), vget_low_u32(bv), a));
+        vst1q_u64(acc + j + 2, vmlal_n_u32(vld1q_u64(acc + j + 2), vget_high_u32(bv), a));
+    }
+#elif defined(__SSE2__)
+    __m128i av = _mm_set1_epi32((int)a);
+    __m128i zero = _mm_setzero_si128();
+    for (; j + 4 <= n; j += 4)
+    {
+        __m128i bv = _mm_loadu_si128((const __m128i *)(b + j));
+        __m128i lo = _mm_mul_epu32(av, _mm_unpacklo_epi32(bv, zero));
+        __m128i hi = _mm_mul_epu32(av, _mm_unpackhi_epi32(bv, zero));
+        _mm_storeu_si128((__m128i *)(acc + j), _mm_add_epi64(_mm_loadu_si128((const __m128i *)(acc + j)), lo));
+        _mm_storeu_si128((__m128i *)(acc + j + 2), _mm_add_epi64(_mm_loadu_si128((const __m128i *)(acc + j + 2)), hi));
+    }
+#endif
+    for (; j < n; j++)
+        acc[j] += (uint64_t)a * (uint32_t)b[j];
+}
+
+typedef struct
+{
+    const MatrixModulus *mod;
+    int rows_per_task;
+    Matrix *C;
+    const Matrix *A;
+    const Matrix *B;
+} ModJob;
+
+static void mod_rows(const ModJob *job, int row_begin, int row_end)
+{
+    uint64_t acc[MATRIX_MOD_BLOCK_COLS];
+    const MatrixModulus *mod = job->mod;
+    Matrix *C = job->C;
+    const Matrix *A = job->A, *B = job->B;
+    int i, j, jb, k;
+
+    for (jb = 0; jb < C->cols; jb += MATRIX_MOD_BLOCK_COLS)
+    {
+        int width = C->cols - jb < MATRIX_MOD_BLOCK_COLS ? C->cols - jb : MATRIX_MOD_BLOCK_COLS;
+        for (i = row_begin; i < row_end; i++)
+        {
+            const int *a = A->data + i * A->stride;
+            int pending = 0;
+
+            for (j = 0; j < width; j++)
+                acc[j] = 0;
+            for (k = 0; k < A->cols; k++)
+            {
+                if (a[k] == 0)
+                    continue;
+                if (pending == mod->batch)
+                {
+                    for (j = 0; j < width; j++)
+                        acc[j] = matrix_mod_reduce(mod, acc[j]);
+                    pending = 1; // the reduced value counts as one term
+                }
+                mac_row(acc, (uint32_t)a[k], B->data + k * B->stride + jb, width);
+                pending++;
+            }
+            for (j = 0; j < width; j++)
+                MAT_AT(C, i, jb + j) = (int)matrix_mod_reduce(mod, acc[j]);
+        }
+    }
+}
+
+static void mod_task(void *arg, int index)
+{
+    const ModJob *job = (const ModJob *)arg;
+    int begin = index * job->rows_per_task;
+    int end = begin + job->rows_per_task < job->C->rows ? begin + job->rows_per_task : job->C->rows;
+    mod_rows(job, begin, end);
+}
+
+int matrix_gemm_mod(Matrix *C, const Matrix *A, const Matrix *B, const MatrixModulus *mod)
+{
+    int M = A->rows, N = B->cols, K = A->cols;
+    int threads, tasks;
+    ModJob job;
+
+    if (B->rows != K || C->rows != M || C->cols != N)
+        return -1;
+
+    job.mod = mod;
+    job.C = C;
+    job.A = A;
+    job.B = B;
+    if ((long long)M * N * K < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+    {
+        mod_rows(&job, 0, M);
+        return 0;
+    }
+    tasks = threads * 4;
+    job.rows_per_task = (M + tasks - 1) / tasks;
+    tasks = (M + job.rows_per_task - 1) / job.rows_per_task;
+    matrix_pool_run(mod_task, &job, tasks);
+    return 0;
+}
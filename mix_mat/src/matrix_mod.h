@@ -0,0 +1,57 @@
+#ifndef MATRIX_MOD_H
+#define MATRIX_MOD_H
+
+#include <stdint.h>
+#include "matrix.h"
+
+// Columns of C accumulated together per row of A
+#define MATRIX_MOD_BLOCK_COLS 64
+
+// Precomputed constants for arithmetic modulo p
+typedef struct
+{
+    uint32_t p;
+    uint64_t barrett; // floor((2^64 - 1) / p)
+    int batch;        // products of canonical values a 64-bit sum can absorb
+} MatrixModulus;
+
+// Prepares the constants for 2 <= p < 2^31. Returns -1 for any other p.
+int matrix_modulus_init(MatrixModulus *mod, uint32_t p);
+
+// High 64 bits of a 64 x 64-bit product, from 32-bit halves where the
+// compiler has no 128-bit type (32-bit ARM)
+static inline uint64_t matrix_mulhi64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((unsigned __int128)a * b) >> 64);
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t cross = ((a_lo * b_lo) >> 32) + (uint32_t)hi_lo + a_lo * b_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+#endif
+}
+
+// x mod p by Barrett reduction: one high multiply and at most two
+// corrections instead of a 64-bit division (a library call on the A9)
+static inline uint32_t matrix_mod_reduce(const MatrixModulus *mod, uint64_t x)
+{
+    uint64_t r = x - matrix_mulhi64(x, mod->barrett) * mod->p;
+    if (r >= mod->p)
+        r -= mod->p;
+    if (r >= mod->p)
+        r -= mod->p;
+    return (uint32_t)r;
+}
+
+// Maps every entry of m into [0, p), the form matrix_gemm_mod() expects
+void matrix_mod_canonical(Matrix *m, const MatrixModulus *mod);
+
+// C = A * B mod p for operands already in [0, p). Dot products accumulate
+// lazily in 64 bits and are reduced once, or once per mod->batch terms when p
+// is so large that K products could overflow (p above 2^26 with K over 4096).
+// Returns 0 on success, -1 on a shape mismatch.
+int matrix_gemm_mod(Matrix *C, const Matrix *A, const Matrix *B, const MatrixModulus *mod);
+
+#endif // MATRIX_MOD_H
@@ -0,0 +1,293 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "matrix.h"
+#include "matrix_pool.h"
+
+#define MATRIX_POOL_MAX_THREADS 64
+
+// Task indices owned by one worker. The owner pops from 'tail', thieves take
+// from 'head'; a short critical section is enough since a task is a whole
+// GEMM panel.
+typedef struct
+{
+    pthread_mutex_t lock;
+    int *tasks;
+    int capacity;
+    int head;
+    int tail;
+} TaskDeque;
+
+typedef struct
+{
+    int threads;
+    int cpus; // online when the pool started
+    pthread_t handles[MATRIX_POOL_MAX_THREADS];
+    TaskDeque deques[MATRIX_POOL_MAX_THREADS];
+
+    pthread_mutex_t job_lock; // held by the thread submitting a job
+    pthread_mutex_t lock;     // protects the fields below
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    unsigned generation;
+    int active;
+    int stop;
+
+    MatrixTaskFn fn;
+    void *arg;
+} MatrixPool;
+
+static MatrixPool pool = {
+    .job_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static int pop_task(TaskDeque *d, int *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head)
+    {
+        *task = d->tasks[--d->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+static int steal_task(TaskDeque *d, int *task)
+{
+    int found = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head)
+    {
+        *task = d->tasks[d->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// Drains worker 'self's deque, then steals from the others until all are empty
+static void run_tasks(int self)
+{
+    int task = 0, victim;
+    for (;;)
+    {
+        if (pop_task(&pool.deques[self], &task))
+        {
+            pool.fn(pool.arg, task);
+            continue;
+        }
+        for (victim = 1; victim < pool.threads; victim++)
+        {
+            if (steal_task(&pool.deques[(self + victim) % pool.threads], &task))
+                break;
+        }
+        if (victim == pool.threads)
+            return;
+        pool.fn(pool.arg, task);
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    int self = (int)(long)arg;
+    unsigned seen = 0;
+    cpu_set_t set;
+
+    // Pin to a core of our own; CPU 0 is the caller's while a job runs, so
+    // workers beyond the core count wrap around CPUs 1 .. cpus - 1
+    if (pool.cpus > 1)
+    {
+        CPU_ZERO(&set);
+        CPU_SET(1 + (self - 1) % (pool.cpus - 1), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool.lock);
+        while (pool.generation == seen && !pool.stop)
+            pthread_cond_wait(&pool.work_cond, &pool.lock);
+        if (pool.stop)
+        {
+            pthread_mutex_unlock(&pool.lock);
+            break;
+        }
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        run_tasks(self);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.active == 0)
+            pthread_cond_signal(&pool.done_cond);
+        pthread_mutex_unlock(&pool.lock);
+    }
+    matrix_release_thread_buffers();
+    return NULL;
+}
+
+int matrix_pool_init(int threads)
+{
+    int i;
+    int status = 0;
+
+    pthread_mutex_lock(&pool.job_lock);
+    if (pool.threads > 0)
+    {
+        pthread_mutex_unlock(&pool.job_lock);
+        return 0;
+    }
+
+    if (threads <= 0)
+    {
+        const char *env = getenv("MATRIX_THREADS");
+        threads = env ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads < 1)
+        threads = 1;
+    if (threads > MATRIX_POOL_MAX_THREADS)
+        threads = MATRIX_POOL_MAX_THREADS;
+
+    for (i = 0; i < threads; i++)
+    {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.deques[i].tasks = NULL;
+        pool.deques[i].capacity = 0;
+        pool.deques[i].head = pool.deques[i].tail = 0;
+    }
+
+    pool.stop = 0;
+    pool.generation = 0;
+    pool.cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    pool.threads = 1;
+    for (i = 1; i < threads; i++)
+    {
+        if (pthread_create(&pool.handles[i], NULL, worker_main, (void *)(long)i) != 0)
+        {
+            status = -1;
+            break;
+        }
+        pool.threads++;
+    }
+    pthread_mutex_unlock(&pool.job_lock);
+    return status;
+}
+
+void matrix_pool_shutdown(void)
+{
+    int i;
+
+    pthread_mutex_lock(&pool.job_lock);
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.work_cond);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (i = 1; i < pool.threads; i++)
+        pthread_join(pool.handles[i], NULL);
+    for (i = 0; i < pool.threads; i++)
+    {
+        free(pool.deques[i].tasks);
+        pool.deques[i].tasks = NULL;
+        pool.deques[i].capacity = 0;
+        pthread_mutex_destroy(&pool.deques[i].lock);
+    }
+    pool.threads = 0;
+    pthread_mutex_unlock(&pool.job_lock);
+}
+
+int matrix_pool_size(void)
+{
+    if (pool.threads == 0)
+        matrix_pool_init(0);
+    return pool.threads;
+}
+
+// Pins the calling thread to CPU 0, the core no worker starts on, so it
+// does not share a core with one while it runs worker 0's tasks. Returns 1
+// with the caller's own mask in 'saved' if it was pinned; a caller kept off
+// CPU 0 (e.g. by taskset) is left where it is.
+static int pin_caller(cpu_set_t *saved)
+{
+    cpu_set_t set;
+
+    if (pool.cpus <= 1 || pthread_getaffinity_np(pthread_self(), sizeof(*saved), saved) != 0 ||
+        !CPU_ISSET(0, saved))
+        return 0;
+    CPU_ZERO(&set);
+    CPU_SET(0, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void matrix_pool_run(MatrixTaskFn fn, void *arg, int count)
+{
+    int i, w, per_worker, pinned;
+    cpu_set_t saved;
+
+    if (count <= 0)
+        return;
+    if (matrix_pool_size() == 1 || count == 1 || pthread_mutex_trylock(&pool.job_lock) != 0)
+    {
+        for (i = 0; i < count; i++)
+            fn(arg, i);
+        return;
+    }
+
+    // Deal out contiguous runs of tasks so neighbouring panels stay on one core
+    per_worker = (count + pool.threads - 1) / pool.threads;
+    for (w = 0; w < pool.threads; w++)
+    {
+        TaskDeque *d = &pool.deques[w];
+        int begin = w * per_worker;
+        int end = begin + per_worker < count ? begin + per_worker : count;
+
+        if (d->capacity < per_worker)
+        {
+            int *tasks = (int *)realloc(d->tasks, sizeof(int) * per_worker);
+            if (tasks == NULL)
+            {
+                // Out of memory: fall back to running the whole job here
+                pthread_mutex_unlock(&pool.job_lock);
+                for (i = 0; i < count; i++)
+                    fn(arg, i);
+                return;
+            }
+            d->tasks = tasks;
+            d->capacity = per_worker;
+        }
+
+        // Stored in reverse so the owner pops its run in ascending order
+        d->head = 0;
+        d->tail = 0;
+        for (i = end - 1; i >= begin; i--)
+            d->tasks[d->tail++] = i;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.active = pool.threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_cond);
+    pthread_mutex_unlock(&pool.lock);
+
+    pinned = pin_caller(&saved);
+    run_tasks(0);
+    if (pinned)
+        pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.active > 0)
+        pthread_cond_wait(&pool.done_cond, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_mutex_unlock(&pool.job_lock);
+}
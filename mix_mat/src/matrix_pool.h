@@ -0,0 +1,36 @@
+#ifndef MATRIX_POOL_H
+#define MATRIX_POOL_H
+
+// Persistent worker pool for the matrix kernels. Workers are created once,
+// pinned one per core, and sleep between jobs. A job is a parallel loop over
+// 'count' independent tasks: the task indices are dealt out to per-worker
+// deques, each worker pops from the back of its own deque and steals from the
+// front of the others when it runs dry. The calling thread takes part as
+// worker 0, so a pool of N threads starts N - 1 extra threads; worker i is
+// pinned to CPU i (wrapping around CPUs 1 and up when there are more workers
+// than cores) and the caller to CPU 0 for the length of each job, its own
+// affinity restored afterwards.
+
+// Products with M*N*K below this many multiply-accumulates run on the calling
+// thread; dispatch and per-panel packing cost more than they save.
+#define MATRIX_PARALLEL_WORK (96 * 96 * 96)
+
+typedef void (*MatrixTaskFn)(void *arg, int index);
+
+// Starts the pool with 'threads' workers including the caller; 0 uses the
+// MATRIX_THREADS environment variable, or one per online CPU. Does nothing if
+// the pool is already running. Returns 0 on success, -1 on failure.
+int matrix_pool_init(int threads);
+
+// Stops and joins the workers
+void matrix_pool_shutdown(void);
+
+// Number of workers including the caller, starting the pool if needed
+int matrix_pool_size(void);
+
+// Runs fn(arg, i) for i in [0, count) across the pool and returns when all
+// tasks have finished. If the pool is busy with another job (including a call
+// made from inside a task) the tasks run on the calling thread instead.
+void matrix_pool_run(MatrixTaskFn fn, void *arg, int count);
+
+#endif // MATRIX_POOL_H
@@ -0,0 +1,112 @@
+#include "matrix_power.h"
+#include "matrix_mod.h"
+
+size_t matrix_power_scratch(int n)
+{
+    return 2 * matrix_arena_footprint((size_t)n * n * sizeof(int));
+}
+
+static int multiply(Matrix *C, const Matrix *A, const Matrix *B, const MatrixModulus *mod)
+{
+    if (mod == NULL)
+        return matrix_gemm(C, A, B);
+    return matrix_gemm_mod(C, A, B, mod);
+}
+
+int matrix_power(Matrix *R, const Matrix *A, unsigned long long k, int modulus, MatrixArena *arena)
+{
+    MatrixArena local;
+    MatrixModulus mod, *modp = NULL;
+    Matrix buf[2], *base, *result = NULL, *spare;
+    size_t mark = 0;
+    int n = A->rows, i, j, status = 0;
+
+    if (A->cols != n || R->rows != n || R->cols != n || modulus < 0)
+        return -1;
+    if (modulus != 0)
+    {
+        if (matrix_modulus_init(&mod, (uint32_t)modulus) != 0)
+            return -1;
+        modp = &mod;
+    }
+
+    if (k == 0)
+    {
+        for (i = 0; i < n; i++)
+            for (j = 0; j < n; j++)
+                MAT_AT(R, i, j) = i == j;
+        return 0;
+    }
+
+    if (arena == NULL)
+    {
+        arena = &local;
+        if (matrix_arena_init(arena, matrix_power_scratch(n)) != 0)
+            return -1;
+    }
+    else
+    {
+        mark = matrix_arena_mark(arena);
+        // reserve() only grows an empty arena
+        if (arena->capacity - arena->used < matrix_power_scratch(n) &&
+            (arena->used != 0 || matrix_arena_reserve(arena, matrix_power_scratch(n)) != 0))
+            return -1;
+    }
+    if (matrix_arena_matrix(arena, &buf[0], n, n) != 0 || matrix_arena_matrix(arena, &buf[1], n, n) != 0)
+    {
+        if (arena == &local)
+            matrix_arena_destroy(&local);
+        else
+            matrix_arena_release(arena, mark);
+        return -1;
+    }
+
+    // base starts as A reduced into [0, modulus), the form matrix_gemm_mod() expects
+    base = &buf[0];
+    matrix_copy(base, A);
+    if (modp != NULL)
+        matrix_mod_canonical(base, modp);
+
+    // Three n x n buffers rotate: base, result (once set) and a spare that
+    // receives each new product before the roles swap
+    spare = &buf[1];
+    for (;;)
+    {
+        if (k & 1)
+        {
+            if (result == NULL)
+            {
+                // First set bit: result = base without a multiply by I
+                result = R;
+                matrix_copy(result, base);
+            }
+            else
+            {
+                Matrix *tmp;
+                status = multiply(spare, result, base, modp);
+                tmp = result;
+                result = spare;
+                spare = tmp;
+            }
+        }
+        k >>= 1;
+        if (k == 0 || status != 0)
+            break;
+        {
+            Matrix *tmp;
+            status = multiply(spare, base, base, modp);
+            tmp = base;
+            base = spare;
+            spare = tmp;
+        }
+    }
+
+    if (status == 0 && result != R)
+        matrix_copy(R, result);
+
+    if (arena == &local)
+        matrix_arena_destroy(&local);
+    else
+        matrix_arena_release(arena, mark);
+    return status;
+}
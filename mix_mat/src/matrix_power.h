@@ -0,0 +1,24 @@
+#ifndef MATRIX_POWER_H
+#define MATRIX_POWER_H
+
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// R = A^k for a square A by exponentiation by squaring: at most 2*log2(k)
+// products instead of k - 1.
+//
+// With modulus 0 the arithmetic is plain int (and wraps like
+// matrix_multiplication()). With 1 < modulus < 2^31 every entry of the result
+// is reduced into [0, modulus) after each product (matrix_gemm_mod()), so
+// arbitrarily large k stays exact - e.g. Fibonacci numbers mod p.
+//
+// The two ping-pong buffers come from 'arena' (NULL uses a temporary one),
+// which must have matrix_power_scratch(n) bytes free or be empty so it can
+// grow, and are released before returning; R provides the third. Returns 0 on success,
+// -1 on bad shapes, a bad modulus or allocation failure.
+int matrix_power(Matrix *R, const Matrix *A, unsigned long long k, int modulus, MatrixArena *arena);
+
+// Arena bytes matrix_power() needs for an n x n operand
+size_t matrix_power_scratch(int n);
+
+#endif // MATRIX_POWER_H
@@ -0,0 +1,237 @@
+#include "matrix_q.h"
+#include "matrix_pool.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+static int16_t saturate_q15(int64_t v)
+{
+    if (v > INT16_MAX)
+        return INT16_MAX;
+    if (v < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)v;
+}
+
+static int32_t saturate_q31(int64_t v)
+{
+    if (v > INT32_MAX)
+        return INT32_MAX;
+    if (v < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)v;
+}
+
+// Sum of a[p] * b[p] in Q30, exact in 64 bits. NEON widens four products at a
+// time with vmull_s16 and folds them pairwise into 64-bit lanes with vpadal.
+static int64_t dot_q15(const int16_t *a, const int16_t *b, int k)
+{
+    int64_t sum = 0;
+    int p = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    int64x2_t acc = vdupq_n_s64(0);
+    for (; p + 8 <= k; p += 8)
+    {
+        int16x8_t av = vld1q_s16(a + p);
+        int16x8_t bv = vld1q_s16(b + p);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(av), vget_low_s16(bv)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(av), vget_high_s16(bv)));
+    }
+    sum = vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+#endif
+    for (; p < k; p++)
+        sum += (int32_t)a[p] * b[p];
+    return sum;
+}
+
+// Sum of (a[p] * b[p]) >> MATRIX_Q31_ACC_SHIFT. NEON forms the Q62 products
+// with vmull_s32 and shifts them into the accumulator with vsra.
+static int64_t dot_q31(const int32_t *a, const int32_t *b, int k)
+{
+    int64_t sum = 0;
+    int p = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    int64x2_t acc = vdupq_n_s64(0);
+    for (; p + 4 <= k; p += 4)
+    {
+        int32x4_t av = vld1q_s32(a + p);
+        int32x4_t bv = vld1q_s32(b + p);
+        acc = vsraq_n_s64(acc, vmull_s32(vget_low_s32(av), vget_low_s32(bv)), MATRIX_Q31_ACC_SHIFT);
+        acc = vsraq_n_s64(acc, vmull_s32(vget_high_s32(av), vget_high_s32(bv)), MATRIX_Q31_ACC_SHIFT);
+    }
+    sum = vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+#endif
+    for (; p < k; p++)
+        sum += ((int64_t)a[p] * b[p]) >> MATRIX_Q31_ACC_SHIFT;
+    return sum;
+}
+
+// Shared state of one product. B is transposed up front so every dot product
+// reads two contiguous rows.
+typedef struct
+{
+    int q31;
+    int rows_per_task;
+    void *C;
+    const void *A;
+    const void *bt; // N x K, row stride K
+} QJob;
+
+static void q_rows(const QJob *job, int row_begin, int row_end)
+{
+    int i, j, jb;
+
+    if (job->q31)
+    {
+        MatrixQ31 *C = (MatrixQ31 *)job->C;
+        const MatrixQ31 *A = (const MatrixQ31 *)job->A;
+        const int32_t *bt = (const int32_t *)job->bt;
+        int K = A->cols;
+        for (jb = 0; jb < C->cols; jb += MATRIX_Q_BLOCK_COLS)
+        {
+            int jend = jb + MATRIX_Q_BLOCK_COLS < C->cols ? jb + MATRIX_Q_BLOCK_COLS : C->cols;
+            for (i = row_begin; i < row_end; i++)
+            {
+                const int32_t *a = A->data + i * A->stride;
+                for (j = jb; j < jend; j++)
+                    MAT_AT(C, i, j) = saturate_q31((dot_q31(a, bt + j * K, K) + (1 << 14)) >> 15);
+            }
+        }
+    }
+    else
+    {
+        MatrixQ15 *C = (MatrixQ15 *)job->C;
+        const MatrixQ15 *A = (const MatrixQ15 *)job->A;
+        const int16_t *bt = (const int16_t *)job->bt;
+        int K = A->cols;
+        for (jb = 0; jb < C->cols; jb += MATRIX_Q_BLOCK_COLS)
+        {
+            int jend = jb + MATRIX_Q_BLOCK_COLS < C->cols ? jb + MATRIX_Q_BLOCK_COLS : C->cols;
+            for (i = row_begin; i < row_end; i++)
+            {
+                const int16_t *a = A->data + i * A->stride;
+                for (j = jb; j < jend; j++)
+                    MAT_AT(C, i, j) = saturate_q15((dot_q15(a, bt + j * K, K) + (1 << 14)) >> 15);
+            }
+        }
+    }
+}
+
+static void q_task(void *arg, int index)
+{
+    const QJob *job = (const QJob *)arg;
+    int rows = job->q31 ? ((MatrixQ31 *)job->C)->rows : ((MatrixQ15 *)job->C)->rows;
+    int begin = index * job->rows_per_task;
+    int end = begin + job->rows_per_task < rows ? begin + job->rows_per_task : rows;
+    q_rows(job, begin, end);
+}
+
+// Runs the row loop on the calling thread or, for large products, in row
+// panels on the worker pool
+static void q_run(QJob *job, int M, int N, int K)
+{
+    int threads, tasks;
+
+    if ((long long)M * N * K < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+    {
+        q_rows(job, 0, M);
+        return;
+    }
+    tasks = threads * 4;
+    job->rows_per_task = (M + tasks - 1) / tasks;
+    tasks = (M + job->rows_per_task - 1) / job->rows_per_task;
+    matrix_pool_run(q_task, job, tasks);
+}
+
+int matrix_gemm_q15(MatrixQ15 *C, const MatrixQ15 *A, const MatrixQ15 *B, MatrixArena *arena)
+{
+    int M = A->rows, N = B->cols, K = A->cols;
+    int16_t *bt;
+    MatrixScratch scratch;
+    int j, p;
+    QJob job;
+
+    if (B->rows != K || C->rows != M || C->cols != N)
+        return -1;
+    bt = (int16_t *)matrix_scratch_begin(&scratch, arena, sizeof(int16_t) * N * K);
+    if (bt == NULL)
+    {
+        matrix_scratch_end(&scratch);
+        return -1;
+    }
+    for (p = 0; p < K; p++)
+        for (j = 0; j < N; j++)
+            bt[j * K + p] = MAT_AT(B, p, j);
+
+    job.q31 = 0;
+    job.C = C;
+    job.A = A;
+    job.bt = bt;
+    q_run(&job, M, N, K);
+
+    matrix_scratch_end(&scratch);
+    return 0;
+}
+
+int matrix_gemm_q31(MatrixQ31 *C, const MatrixQ31 *A, const MatrixQ31 *B, MatrixArena *arena)
+{
+    int M = A->rows, N = B->cols, K = A->cols;
+    int32_t *bt;
+    MatrixScratch scratch;
+    int j, p;
+    QJob job;
+
+    if (B->rows != K || C->rows != M || C->cols != N)
+        return -1;
+    bt = (int32_t *)matrix_scratch_begin(&scratch, arena, sizeof(int32_t) * N * K);
+    if (bt == NULL)
+    {
+        matrix_scratch_end(&scratch);
+        return -1;
+    }
+    for (p = 0; p < K; p++)
+        for (j = 0; j < N; j++)
+            bt[j * K + p] = MAT_AT(B, p, j);
+
+    job.q31 = 1;
+    job.C = C;
+    job.A = A;
+    job.bt = bt;
+    q_run(&job, M, N, K);
+
+    matrix_scratch_end(&scratch);
+    return 0;
+}
+
+void matrix_multiplication_q15(int *result, int *matrixA, int *matrixB)
+{
+    int16_t a[4], b[4], c[4];
+    MatrixQ15 A = {2, 2, 2, a}, B = {2, 2, 2, b}, C = {2, 2, 2, c};
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        a[i] = saturate_q15((int64_t)matrixA[i] << MATRIX_Q15_INPUT_SHIFT);
+        b[i] = saturate_q15((int64_t)matrixB[i] << MATRIX_Q15_INPUT_SHIFT);
+    }
+    matrix_gemm_q15(&C, &A, &B, matrix_thread_arena());
+    for (i = 0; i < 4; i++)
+        result[i] = c[i] >> (2 * MATRIX_Q15_INPUT_SHIFT - 15);
+}
+
+void matrix_multiplication_q31(int *result, int *matrixA, int *matrixB)
+{
+    int32_t a[4], b[4], c[4];
+    MatrixQ31 A = {2, 2, 2, a}, B = {2, 2, 2, b}, C = {2, 2, 2, c};
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        a[i] = saturate_q31((int64_t)matrixA[i] << MATRIX_Q31_INPUT_SHIFT);
+        b[i] = saturate_q31((int64_t)matrixB[i] << MATRIX_Q31_INPUT_SHIFT);
+    }
+    matrix_gemm_q31(&C, &A, &B, matrix_thread_arena());
+    for (i = 0; i < 4; i++)
+        result[i] = c[i] >> (2 * MATRIX_Q31_INPUT_SHIFT - 31);
+}
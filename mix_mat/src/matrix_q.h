@@ -0,0 +1,39 @@
+#ifndef MATRIX_Q_H
+#define MATRIX_Q_H
+
+#include <stdint.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Fixed-point matrices. Q15 entries are int16 with 15 fractional bits (range
+// [-1, 1)), Q31 entries are int32 with 31 fractional bits, so the existing
+// MatrixS16 and Matrix containers hold them.
+typedef MatrixS16 MatrixQ15;
+typedef Matrix MatrixQ31;
+
+// Q31 products are accumulated as (a * b) >> MATRIX_Q31_ACC_SHIFT in 64 bits,
+// which leaves 17 bits of headroom: dot products of up to 2^17 terms of
+// full-scale values cannot overflow the accumulator.
+#define MATRIX_Q31_ACC_SHIFT 16
+
+// Columns of B (transposed) kept hot per block while rows of A stream past
+#define MATRIX_Q_BLOCK_COLS 64
+
+// C = A * B. Every dot product is accumulated exactly (Q15) or with 16 guard
+// bits (Q31) in 64 bits, then rounded and saturated once to the output format.
+// The transposed copy of B comes from 'arena' (NULL uses the heap).
+// Returns 0 on success, -1 on a shape mismatch or allocation failure.
+int matrix_gemm_q15(MatrixQ15 *C, const MatrixQ15 *A, const MatrixQ15 *B, MatrixArena *arena);
+int matrix_gemm_q31(MatrixQ31 *C, const MatrixQ31 *A, const MatrixQ31 *B, MatrixArena *arena);
+
+// Drop-in alternatives to matrix_multiplication() for the 2x2 board demo. The
+// 4-bit switch values are scaled into the fixed-point format (v / 32, so every
+// sum of two products stays below 0.5), multiplied there, and scaled back.
+void matrix_multiplication_q15(int *result, int *matrixA, int *matrixB);
+void matrix_multiplication_q31(int *result, int *matrixA, int *matrixB);
+
+// Input scaling used by the drop-in functions: value << shift
+#define MATRIX_Q15_INPUT_SHIFT 10
+#define MATRIX_Q31_INPUT_SHIFT 26
+
+#endif // MATRIX_Q_H
@@ -0,0 +1,317 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_s8.h"
+#include "matrix_pool.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+int matrix_create_s8(MatrixS8 *m, int rows, int cols)
+{
+    void *data = NULL;
+    size_t bytes = (size_t)rows * (size_t)cols;
+
+    if (rows <= 0 || cols <= 0)
+        return -1;
+    if (posix_memalign(&data, 64, bytes) != 0)
+        return -1;
+    memset(data, 0, bytes);
+
+    m->rows = rows;
+    m->cols = cols;
+    m->stride = cols;
+    m->data = (int8_t *)data;
+    return 0;
+}
+
+void matrix_free_s8(MatrixS8 *m)
+{
+    free(m->data);
+    m->data = NULL;
+    m->rows = 0;
+    m->cols = 0;
+    m->stride = 0;
+}
+
+static int8_t saturate_s8(long v)
+{
+    if (v > INT8_MAX)
+        return INT8_MAX;
+    if (v < INT8_MIN)
+        return INT8_MIN;
+    return (int8_t)v;
+}
+
+int matrix_quantize_s8(MatrixS8 *q, const MatrixF *f, const MatrixQuant *qp)
+{
+    int i, j;
+
+    if (q->rows != f->rows || q->cols != f->cols)
+        return -1;
+    for (i = 0; i < f->rows; i++)
+        for (j = 0; j < f->cols; j++)
+            MAT_AT(q, i, j) = saturate_s8(lrintf(MAT_AT(f, i, j) / qp->scale) + qp->zero_point);
+    return 0;
+}
+
+int matrix_requantize_s8(MatrixS8 *out, const Matrix *acc, float acc_scale, const MatrixQuant *qp)
+{
+    float ratio = acc_scale / qp->scale;
+    int i, j;
+
+    if (out->rows != acc->rows || out->cols != acc->cols)
+        return -1;
+    for (i = 0; i < acc->rows; i++)
+        for (j = 0; j < acc->cols; j++)
+            MAT_AT(out, i, j) = saturate_s8(lrintf(MAT_AT(acc, i, j) * ratio) + qp->zero_point);
+    return 0;
+}
+
+int matrix_dequantize(MatrixF *out, const Matrix *acc, float acc_scale)
+{
+    int i, j;
+
+    if (out->rows != acc->rows || out->cols != acc->cols)
+        return -1;
+    for (i = 0; i < acc->rows; i++)
+        for (j = 0; j < acc->cols; j++)
+            MAT_AT(out, i, j) = MAT_AT(acc, i, j) * acc_scale;
+    return 0;
+}
+
+// Raw int8 dot products of one MR-row panel of A with one NR-column panel of
+// B, both packed as MATRIX_S8_KU-byte groups per row/column for each step of
+// K. NEON widens each group with vmull_s8 and folds pairs into int32 lanes
+// with vpadal; SSE2 sign-extends to int16 and uses _mm_madd_epi16.
+static void kernel_s8(int steps, const int8_t *a, const int8_t *b, int32_t *out)
+{
+    int r, c, s;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    int32x4_t acc[MATRIX_S8_MR][MATRIX_S8_NR];
+
+    for (r = 0; r < MATRIX_S8_MR; r++)
+        for (c = 0; c < MATRIX_S8_NR; c++)
+            acc[r][c] = vdupq_n_s32(0);
+    for (s = 0; s < steps; s++)
+    {
+        int8x8_t av[MATRIX_S8_MR], bv[MATRIX_S8_NR];
+        for (r = 0; r < MATRIX_S8_MR; r++)
+            av[r] = vld1_s8(a + r * MATRIX_S8_KU);
+        for (c = 0; c < MATRIX_S8_NR; c++)
+            bv[c] = vld1_s8(b + c * MATRIX_S8_KU);
+        for (r = 0; r < MATRIX_S8_MR; r++)
+            for (c = 0; c < MATRIX_S8_NR; c++)
+                acc[r][c] = vpadalq_s16(acc[r][c], vmull_s8(av[r], bv[c]));
+        a += MATRIX_S8_MR * MATRIX_S8_KU;
+        b += MATRIX_S8_NR * MATRIX_S8_KU;
+    }
+    for (r = 0; r < MATRIX_S8_MR; r++)
+    {
+        for (c = 0; c < MATRIX_S8_NR; c++)
+        {
+            int32x2_t sum = vadd_s32(vget_low_s32(acc[r][c]), vget_high_s32(acc[r][c]));
+            out[r * MATRIX_S8_NR + c] = vget_lane_s32(vpadd_s32(sum, sum), 0);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i acc[MATRIX_S8_MR][MATRIX_S8_NR];
+
+    for (r = 0; r < MATRIX_S8_MR; r++)
+        for (c = 0; c < MATRIX_S8_NR; c++)
+            acc[r][c] = _mm_setzero_si128();
+    for (s = 0; s < steps; s++)
+    {
+        __m128i av[MATRIX_S8_MR], bv[MATRIX_S8_NR];
+        for (r = 0; r < MATRIX_S8_MR; r++)
+        {
+            __m128i x = _mm_loadl_epi64((const __m128i *)(a + r * MATRIX_S8_KU));
+            av[r] = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        }
+        for (c = 0; c < MATRIX_S8_NR; c++)
+        {
+            __m128i x = _mm_loadl_epi64((const __m128i *)(b + c * MATRIX_S8_KU));
+            bv[c] = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+        }
+        for (r = 0; r < MATRIX_S8_MR; r++)
+            for (c = 0; c < MATRIX_S8_NR; c++)
+                acc[r][c] = _mm_add_epi32(acc[r][c], _mm_madd_epi16(av[r], bv[c]));
+        a += MATRIX_S8_MR * MATRIX_S8_KU;
+        b += MATRIX_S8_NR * MATRIX_S8_KU;
+    }
+    for (r = 0; r < MATRIX_S8_MR; r++)
+    {
+        for (c = 0; c < MATRIX_S8_NR; c++)
+        {
+            __m128i v = acc[r][c];
+            v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+            v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+            out[r * MATRIX_S8_NR + c] = _mm_cvtsi128_si32(v);
+        }
+    }
+#else
+    int p;
+
+    for (r = 0; r < MATRIX_S8_MR * MATRIX_S8_NR; r++)
+        out[r] = 0;
+    for (s = 0; s < steps; s++)
+    {
+        for (r = 0; r < MATRIX_S8_MR; r++)
+            for (c = 0; c < MATRIX_S8_NR; c++)
+                for (p = 0; p < MATRIX_S8_KU; p++)
+                    out[r * MATRIX_S8_NR + c] += a[r * MATRIX_S8_KU + p] * b[c * MATRIX_S8_KU + p];
+        a += MATRIX_S8_MR * MATRIX_S8_KU;
+        b += MATRIX_S8_NR * MATRIX_S8_KU;
+    }
+#endif
+}
+
+// Shared state of one product: packed panels, the per-row/column raw sums
+// used for the zero-point corrections, and the output
+typedef struct
+{
+    Matrix *C;
+    const int8_t *apack;
+    const int8_t *bpack;
+    const int32_t *row_sum; // sum over K of each row of A
+    const int32_t *col_sum; // sum over K of each column of B
+    int za, zb, K, steps;
+    int panels_per_task;
+} S8Job;
+
+static void s8_panels(const S8Job *job, int panel_begin, int panel_end)
+{
+    Matrix *C = job->C;
+    int32_t tile[MATRIX_S8_MR * MATRIX_S8_NR];
+    long long zz = (long long)job->K * job->za * job->zb;
+    int panel, i0, j0, r, c;
+
+    for (panel = panel_begin; panel < panel_end; panel++)
+    {
+        const int8_t *a = job->apack + (size_t)panel * MATRIX_S8_MR * MATRIX_S8_KU * job->steps;
+        i0 = panel * MATRIX_S8_MR;
+        for (j0 = 0; j0 < C->cols; j0 += MATRIX_S8_NR)
+        {
+            const int8_t *b = job->bpack + (size_t)(j0 / MATRIX_S8_NR) * MATRIX_S8_NR * MATRIX_S8_KU * job->steps;
+            kernel_s8(job->steps, a, b, tile);
+            for (r = 0; r < MATRIX_S8_MR && i0 + r < C->rows; r++)
+            {
+                for (c = 0; c < MATRIX_S8_NR && j0 + c < C->cols; c++)
+                {
+                    MAT_AT(C, i0 + r, j0 + c) = (int)(tile[r * MATRIX_S8_NR + c] -
+                                                      (long long)job->zb * job->row_sum[i0 + r] -
+                                                      (long long)job->za * job->col_sum[j0 + c] + zz);
+                }
+            }
+        }
+    }
+}
+
+static void s8_task(void *arg, int index)
+{
+    const S8Job *job = (const S8Job *)arg;
+    int panels = (job->C->rows + MATRIX_S8_MR - 1) / MATRIX_S8_MR;
+    int begin = index * job->panels_per_task;
+    int end = begin + job->panels_per_task < panels ? begin + job->panels_per_task : panels;
+    s8_panels(job, begin, end);
+}
+
+int matrix_gemm_s8(Matrix *C, const MatrixS8 *A, const MatrixQuant *qa,
+                   const MatrixS8 *B, const MatrixQuant *qb, MatrixArena *arena)
+{
+    int M = A->rows, N = B->cols, K = A->cols;
+    int steps = (K + MATRIX_S8_KU - 1) / MATRIX_S8_KU;
+    int mpanels = (M + MATRIX_S8_MR - 1) / MATRIX_S8_MR;
+    int npanels = (N + MATRIX_S8_NR - 1) / MATRIX_S8_NR;
+    size_t abytes = (size_t)mpanels * MATRIX_S8_MR * steps * MATRIX_S8_KU;
+    size_t bbytes = (size_t)npanels * MATRIX_S8_NR * steps * MATRIX_S8_KU;
+    int8_t *apack, *bpack;
+    int32_t *row_sum, *col_sum;
+    MatrixScratch scratch;
+    void *buf;
+    int i, j, k, threads, tasks;
+    S8Job job;
+
+    if (B->rows != K || C->rows != M || C->cols != N)
+        return -1;
+    buf = matrix_scratch_begin(&scratch, arena, abytes + bbytes + sizeof(int32_t) * (M + N));
+    if (buf == NULL)
+    {
+        matrix_scratch_end(&scratch);
+        return -1;
+    }
+    apack = (int8_t *)buf;
+    bpack = apack + abytes;
+    row_sum = (int32_t *)(bpack + bbytes); // abytes and bbytes are multiples of 16
+    col_sum = row_sum + M;
+    memset(buf, 0, abytes + bbytes + sizeof(int32_t) * (M + N));
+
+    // Group k of row i lands at panel i / MR, step k / KU, lane i % MR; the
+    // zero padding of short panels and of K adds nothing to the raw sums
+    for (i = 0; i < M; i++)
+    {
+        int8_t *dst = apack + (size_t)(i / MATRIX_S8_MR) * MATRIX_S8_MR * MATRIX_S8_KU * steps +
+                      (i % MATRIX_S8_MR) * MATRIX_S8_KU;
+        for (k = 0; k < K; k++)
+        {
+            int8_t v = MAT_AT(A, i, k);
+            dst[(k / MATRIX_S8_KU) * MATRIX_S8_MR * MATRIX_S8_KU + k % MATRIX_S8_KU] = v;
+            row_sum[i] += v;
+        }
+    }
+    for (k = 0; k < K; k++)
+    {
+        const int8_t *src = B->data + k * B->stride;
+        int8_t *step = bpack + (k / MATRIX_S8_KU) * MATRIX_S8_NR * MATRIX_S8_KU + k % MATRIX_S8_KU;
+        for (j = 0; j < N; j++)
+        {
+            step[(size_t)(j / MATRIX_S8_NR) * MATRIX_S8_NR * MATRIX_S8_KU * steps +
+                 (j % MATRIX_S8_NR) * MATRIX_S8_KU] = src[j];
+            col_sum[j] += src[j];
+        }
+    }
+
+    job.C = C;
+    job.apack = apack;
+    job.bpack = bpack;
+    job.row_sum = row_sum;
+    job.col_sum = col_sum;
+    job.za = qa->zero_point;
+    job.zb = qb->zero_point;
+    job.K = K;
+    job.steps = steps;
+    if ((long long)M * N * K < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+    {
+        s8_panels(&job, 0, mpanels);
+    }
+    else
+    {
+        tasks = threads * 4;
+        job.panels_per_task = (mpanels + tasks - 1) / tasks;
+        tasks = (mpanels + job.panels_per_task - 1) / job.panels_per_task;
+        matrix_pool_run(s8_task, &job, tasks);
+    }
+
+    matrix_scratch_end(&scratch);
+    return 0;
+}
+
+void matrix_multiplication_s8(int *result, int *matrixA, int *matrixB)
+{
+    int8_t a[4], b[4];
+    MatrixS8 A = {2, 2, 2, a}, B = {2, 2, 2, b};
+    MatrixQuant unit = {1.0f, 0};
+    Matrix C;
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        a[i] = saturate_s8(matrixA[i]);
+        b[i] = saturate_s8(matrixB[i]);
+    }
+    matrix_view(&C, result, 2, 2, 2);
+    matrix_gemm_s8(&C, &A, &unit, &B, &unit, matrix_thread_arena());
+}
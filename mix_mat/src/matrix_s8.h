@@ -0,0 +1,55 @@
+#ifndef MATRIX_S8_H
+#define MATRIX_S8_H
+
+#include <stdint.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Register tile of the int8 kernels: MATRIX_S8_MR rows of A against
+// MATRIX_S8_NR columns of B, consuming MATRIX_S8_KU values of K per step
+// (one 8-lane vmull_s8 / _mm_madd_epi16)
+#define MATRIX_S8_MR 2
+#define MATRIX_S8_NR 4
+#define MATRIX_S8_KU 8
+
+// int8 operands, a quarter of the bytes of the int layout
+typedef struct
+{
+    int rows;
+    int cols;
+    int stride;
+    int8_t *data;
+} MatrixS8;
+
+// Per-tensor affine quantization: real = scale * (q - zero_point)
+typedef struct
+{
+    float scale;
+    int zero_point; // in [-128, 127]
+} MatrixQuant;
+
+int matrix_create_s8(MatrixS8 *m, int rows, int cols);
+void matrix_free_s8(MatrixS8 *m);
+
+// q = clamp(round(f / scale) + zero_point) into int8
+int matrix_quantize_s8(MatrixS8 *q, const MatrixF *f, const MatrixQuant *qp);
+
+// C = (A - za) * (B - zb) in int32, exact for K up to 2^15. The real product
+// is qa->scale * qb->scale * C. Both operands are packed into K-interleaved
+// register-tile panels first; the zero points are applied afterwards from
+// row sums of A and column sums of B, so the kernels multiply raw int8. The
+// packed panels come from 'arena' (NULL uses the heap). Returns 0 on success,
+// -1 on a shape mismatch or allocation failure.
+int matrix_gemm_s8(Matrix *C, const MatrixS8 *A, const MatrixQuant *qa,
+                   const MatrixS8 *B, const MatrixQuant *qb, MatrixArena *arena);
+
+// Int32 accumulators with real value acc_scale * acc, requantized to 'qp' for
+// the next layer, or converted to float
+int matrix_requantize_s8(MatrixS8 *out, const Matrix *acc, float acc_scale, const MatrixQuant *qp);
+int matrix_dequantize(MatrixF *out, const Matrix *acc, float acc_scale);
+
+// Drop-in alternative to matrix_multiplication() for the 2x2 board demo: the
+// 4-bit switch values are exact int8 with scale 1 and zero point 0
+void matrix_multiplication_s8(int *result, int *matrixA, int *matrixB);
+
+#endif // MATRIX_S8_H
@@ -0,0 +1,118 @@
+#include <string.h>
+#include "matrix_semiring.h"
+#include "matrix_pool.h"
+
+static inline int sr_min(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+static inline int sr_max(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+// Clamps a sum of two entries back into [-MATRIX_SR_INF, MATRIX_SR_INF]
+static inline int sr_sat(int x)
+{
+    return sr_max(sr_min(x, MATRIX_SR_INF), -MATRIX_SR_INF);
+}
+
+// Instantiate min-plus
+#define SR_NAME(x) x##_min_plus
+#define SR_ZERO MATRIX_SR_INF
+#define SR_ADD(a, b) sr_min(a, b)
+#define SR_MUL(a, b) ((a) == SR_ZERO || (b) == SR_ZERO ? SR_ZERO : sr_sat((a) + (b)))
+#include "matrix_semiring_impl.h"
+#undef SR_NAME
+#undef SR_ZERO
+#undef SR_ADD
+#undef SR_MUL
+
+// Instantiate max-plus
+#define SR_NAME(x) x##_max_plus
+#define SR_ZERO (-MATRIX_SR_INF)
+#define SR_ADD(a, b) sr_max(a, b)
+#define SR_MUL(a, b) ((a) == SR_ZERO || (b) == SR_ZERO ? SR_ZERO : sr_sat((a) + (b)))
+#include "matrix_semiring_impl.h"
+#undef SR_NAME
+#undef SR_ZERO
+#undef SR_ADD
+#undef SR_MUL
+
+// Instantiate max-min
+#define SR_NAME(x) x##_max_min
+#define SR_ZERO (-MATRIX_SR_INF)
+#define SR_ADD(a, b) sr_max(a, b)
+#define SR_MUL(a, b) sr_min(a, b)
+#include "matrix_semiring_impl.h"
+#undef SR_NAME
+#undef SR_ZERO
+#undef SR_ADD
+#undef SR_MUL
+
+int matrix_apsp(Matrix *D, const Matrix *W, MatrixArena *arena)
+{
+    MatrixArena local;
+    Matrix spare, *cur, *next, *tmp;
+    size_t mark = 0, bytes;
+    long reach = 1;
+    int n = W->rows, i, status = 0;
+
+    if (W->cols != n || D->rows != n || D->cols != n)
+        return -1;
+    bytes = matrix_arena_footprint((size_t)n * n * sizeof(int));
+    if (arena == NULL)
+    {
+        arena = &local;
+        if (matrix_arena_init(arena, bytes) != 0)
+            return -1;
+    }
+    else
+    {
+        mark = matrix_arena_mark(arena);
+        // reserve() only grows an empty arena
+        if (arena->capacity - arena->used < bytes &&
+            (arena->used != 0 || matrix_arena_reserve(arena, bytes) != 0))
+            return -1;
+    }
+    if (matrix_arena_matrix(arena, &spare, n, n) != 0)
+    {
+        if (arena == &local)
+            matrix_arena_destroy(&local);
+        else
+            matrix_arena_release(arena, mark);
+        return -1;
+    }
+
+    // cur holds paths of at most 'reach' edges; staying put costs nothing
+    cur = D;
+    next = &spare;
+    matrix_copy(cur, W);
+    for (i = 0; i < n; i++)
+        if (MAT_AT(cur, i, i) > 0)
+            MAT_AT(cur, i, i) = 0;
+    while (reach < n - 1)
+    {
+        int changed = 0;
+        if ((status = matrix_gemm_min_plus(next, cur, cur)) != 0)
+            break;
+        for (i = 0; i < n && !changed; i++)
+            changed = memcmp(next->data + i * next->stride, cur->data + i * cur->stride, n * sizeof(int)) != 0;
+        tmp = cur;
+        cur = next;
+        next = tmp;
+        reach *= 2;
+        if (!changed)
+            break;
+    }
+
+    if (status == 0 && cur != D)
+        matrix_copy(D, cur);
+
+    if (arena == &local)
+        matrix_arena_destroy(&local);
+    else
+        matrix_arena_release(arena, mark);
+    return status;
+}
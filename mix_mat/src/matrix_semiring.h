@@ -0,0 +1,31 @@
+#ifndef MATRIX_SEMIRING_H
+#define MATRIX_SEMIRING_H
+
+#include <limits.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// "Infinity" of the semiring products: a missing edge is MATRIX_SR_INF in
+// min-plus and -MATRIX_SR_INF in max-plus and max-min. Entries must lie in
+// [-MATRIX_SR_INF, MATRIX_SR_INF]; sums saturate at the bound, so two of them
+// can never overflow an int.
+#define MATRIX_SR_INF (INT_MAX / 2)
+
+// C = A * B with the (+, x) of matrix_gemm() replaced by another semiring.
+// C must not overlap A or B. Return 0 on success, -1 on a shape mismatch.
+//   min-plus: C(i, j) = min over k of A(i, k) + B(k, j)  (shortest paths)
+//   max-plus: C(i, j) = max over k of A(i, k) + B(k, j)  (longest/critical paths)
+//   max-min:  C(i, j) = max over k of min(A(i, k), B(k, j))  (bottleneck paths)
+int matrix_gemm_min_plus(Matrix *C, const Matrix *A, const Matrix *B);
+int matrix_gemm_max_plus(Matrix *C, const Matrix *A, const Matrix *B);
+int matrix_gemm_max_min(Matrix *C, const Matrix *A, const Matrix *B);
+
+// All-pairs shortest paths: D(i, j) is the length of the shortest path from
+// i to j over edge weights W (MATRIX_SR_INF for no edge, unreachable pairs
+// stay MATRIX_SR_INF). Squares W with a zero diagonal under min-plus until
+// nothing changes, at most log2(n) products. W must not have negative cycles.
+// The spare buffer comes from 'arena' (NULL uses a temporary one), which must
+// have n * n ints free or be empty so it can grow. D may be W.
+int matrix_apsp(Matrix *D, const Matrix *W, MatrixArena *arena);
+
+#endif // MATRIX_SEMIRING_H
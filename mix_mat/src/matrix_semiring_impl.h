@@ -0,0 +1,85 @@
+// Cache-blocked product over a semiring, shared by the instantiations in
+// matrix_semiring.c. This file is included once per semiring after defining:
+//   SR_NAME(x)   - suffixes the generated function names, e.g. x##_min_plus
+//   SR_ZERO      - identity of SR_ADD and absorbing element of SR_MUL
+//   SR_ADD(a, b) - the semiring "addition", e.g. min
+//   SR_MUL(a, b) - the semiring "multiplication", e.g. saturated +; must
+//                  return SR_ZERO when either operand is SR_ZERO
+// The operations expand inline into the inner loop, which has no calls or
+// branches (the SR_ZERO tests become selects) and so vectorizes to packed
+// min/max/add. It defines the public matrix_gemm##suffix(C, A, B).
+
+// C rows [row_begin, row_end) = A * B. B is walked in KC x NC blocks so one
+// block stays in cache while every row of the panel reuses it.
+static void SR_NAME(sr_rows)(Matrix *C, const Matrix *A, const Matrix *B, int row_begin, int row_end)
+{
+    int i, j, jb, k, kb;
+
+    for (jb = 0; jb < C->cols; jb += MATRIX_NC)
+    {
+        int nc = C->cols - jb < MATRIX_NC ? C->cols - jb : MATRIX_NC;
+        for (kb = 0; kb < A->cols; kb += MATRIX_KC)
+        {
+            int kend = kb + MATRIX_KC < A->cols ? kb + MATRIX_KC : A->cols;
+            for (i = row_begin; i < row_end; i++)
+            {
+                int *c = C->data + i * C->stride + jb;
+                const int *a = A->data + i * A->stride;
+                if (kb == 0)
+                {
+                    for (j = 0; j < nc; j++)
+                        c[j] = SR_ZERO;
+                }
+                for (k = kb; k < kend; k++)
+                {
+                    const int *b = B->data + k * B->stride + jb;
+                    int av = a[k];
+                    if (av == SR_ZERO)
+                        continue; // contributes nothing, e.g. a missing edge
+                    for (j = 0; j < nc; j++)
+                        c[j] = SR_ADD(c[j], SR_MUL(av, b[j]));
+                }
+            }
+        }
+    }
+}
+
+typedef struct
+{
+    Matrix *C;
+    const Matrix *A;
+    const Matrix *B;
+    int rows_per_task;
+} SR_NAME(SemiringJob);
+
+static void SR_NAME(sr_task)(void *arg, int index)
+{
+    const SR_NAME(SemiringJob) *job = (const SR_NAME(SemiringJob) *)arg;
+    int begin = index * job->rows_per_task;
+    int end = begin + job->rows_per_task < job->C->rows ? begin + job->rows_per_task : job->C->rows;
+    SR_NAME(sr_rows)(job->C, job->A, job->B, begin, end);
+}
+
+int SR_NAME(matrix_gemm)(Matrix *C, const Matrix *A, const Matrix *B)
+{
+    SR_NAME(SemiringJob) job;
+    int M = A->rows, N = B->cols, K = A->cols;
+    int threads, tasks;
+
+    if (B->rows != K || C->rows != M || C->cols != N)
+        return -1;
+    if ((long long)M * N * K < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+    {
+        SR_NAME(sr_rows)(C, A, B, 0, M);
+        return 0;
+    }
+
+    job.C = C;
+    job.A = A;
+    job.B = B;
+    tasks = threads * 4;
+    job.rows_per_task = (M + tasks - 1) / tasks;
+    tasks = (M + job.rows_per_task - 1) / job.rows_per_task;
+    matrix_pool_run(SR_NAME(sr_task), &job, tasks);
+    return 0;
+}
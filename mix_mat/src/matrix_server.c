@@ -0,0 +1,617 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "matrix.h"
+#include "matrix_batch.h"
+#include "matrix_server.h"
+
+// Largest batch one coalesced kernel call takes
+#define MATRIX_SERVER_BATCH 256
+
+#define MAX_EVENTS 64
+
+// Operand and result entries a pooled request keeps between uses (a 64 x 64
+// product); larger buffers go back to the heap so one burst of big jobs does
+// not stay resident for the life of the server
+#define REQUEST_KEEP_ENTRIES (3 * 64 * 64)
+
+// Bytes respond() queues for a request: the length word, the 16-byte header
+// and C when the product succeeds
+#define RESPONSE_BYTES(m, n) (sizeof(uint32_t) * 5 + sizeof(int) * (size_t)(m) * (n))
+
+typedef struct Conn
+{
+    int fd;
+    int closing; // peer finished sending; close once the output drains
+    int dead;    // I/O or protocol error; close now
+    int stalled; // complete frames left in 'in' until the output drains
+    unsigned char *in;
+    size_t in_len, in_cap;
+    unsigned char *out;
+    size_t out_len, out_sent, out_cap;
+    size_t projected; // response bytes of parsed requests not yet queued
+    struct Conn *next;
+} Conn;
+
+// A parsed request waiting for its round to be served
+typedef struct Request
+{
+    MatrixJob job;
+    uint32_t id;
+    Conn *conn;
+    struct Request *next; // free list link
+} Request;
+
+typedef struct
+{
+    int epfd;
+    int listen_fd;
+    Conn *conns;
+    Request *free_requests;
+    Request *pending[MATRIX_SERVER_MAX_PENDING];
+    int npending;
+    MatrixBatch batch[MATRIX_BATCH_MAX_N + 1][3]; // A, B, C per order, created on first use
+} Server;
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static int reserve(unsigned char **buf, size_t *cap, size_t bytes)
+{
+    unsigned char *p;
+    size_t want = *cap ? *cap : 4096;
+
+    if (bytes <= *cap)
+        return 0;
+    while (want < bytes)
+        want *= 2;
+    p = (unsigned char *)realloc(*buf, want);
+    if (p == NULL)
+        return -1;
+    *buf = p;
+    *cap = want;
+    return 0;
+}
+
+static Request *request_get(Server *s)
+{
+    Request *r = s->free_requests;
+
+    if (r != NULL)
+    {
+        s->free_requests = r->next;
+        return r;
+    }
+    r = (Request *)malloc(sizeof(Request));
+    if (r != NULL)
+        matrix_job_init(&r->job);
+    return r;
+}
+
+static void request_put(Server *s, Request *r)
+{
+    if (r->job.capacity[0] + r->job.capacity[1] + r->job.capacity[2] > REQUEST_KEEP_ENTRIES)
+        matrix_job_free(&r->job);
+    r->next = s->free_requests;
+    s->free_requests = r;
+}
+
+static void watch(Server *s, Conn *c, uint32_t events, int op)
+{
+    struct epoll_event ev;
+
+    ev.events = events;
+    ev.data.ptr = c;
+    epoll_ctl(s->epfd, op, c->fd, &ev);
+}
+
+static int backlogged(const Conn *c)
+{
+    return c->out_len - c->out_sent > MATRIX_SERVER_MAX_OUTPUT;
+}
+
+// Sends what it can of the output buffer and waits for EPOLLOUT if the
+// socket is full. Reading stops while the backlog is over the cap.
+static void flush_conn(Server *s, Conn *c)
+{
+    while (c->out_sent < c->out_len)
+    {
+        ssize_t n = send(c->fd, c->out + c->out_sent, c->out_len - c->out_sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                c->dead = 1;
+            break;
+        }
+        c->out_sent += n;
+    }
+    if (c->out_sent == c->out_len)
+    {
+        c->out_len = c->out_sent = 0;
+        if (!c->dead)
+            watch(s, c, c->closing ? 0 : EPOLLIN, EPOLL_CTL_MOD);
+    }
+    else if (!c->dead)
+        watch(s, c, c->closing || c->stalled || backlogged(c) ? EPOLLOUT : EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+}
+
+static void respond(Request *r)
+{
+    Conn *c = r->conn;
+    MatrixJob *job = &r->job;
+    size_t data = job->status == 0 ? sizeof(int) * (size_t)job->m * job->n : 0;
+    uint32_t head[5];
+
+    c->projected -= RESPONSE_BYTES(job->m, job->n);
+    if (c->dead)
+        return;
+    // Drop what was sent so a client reading slowly but steadily does not
+    // grow the buffer forever
+    if (c->out_sent > 0)
+    {
+        memmove(c->out, c->out + c->out_sent, c->out_len - c->out_sent);
+        c->out_len -= c->out_sent;
+        c->out_sent = 0;
+    }
+    if (reserve(&c->out, &c->out_cap, c->out_len + sizeof(head) + data) != 0)
+    {
+        c->dead = 1;
+        return;
+    }
+    head[0] = MATRIX_SERVER_HEADER_BYTES + data;
+    head[1] = r->id;
+    head[2] = (uint32_t)job->status;
+    head[3] = job->m;
+    head[4] = job->n;
+    memcpy(c->out + c->out_len, head, sizeof(head));
+    memcpy(c->out + c->out_len + sizeof(head), job->c, data);
+    c->out_len += sizeof(head) + data;
+}
+
+// Runs 'count' same-order square requests as batched kernel calls
+static void serve_batched(Server *s, Request **reqs, int count, int n)
+{
+    MatrixBatch *b = s->batch[n];
+    int first, i, chunk;
+
+    if (b[0].data == NULL)
+    {
+        for (i = 0; i < 3; i++)
+            if (matrix_batch_create(&b[i], n, MATRIX_SERVER_BATCH) != 0)
+                break;
+        if (i < 3)
+        {
+            while (--i >= 0)
+                matrix_batch_free(&b[i]);
+            for (i = 0; i < count; i++)
+                matrix_job_run(&reqs[i]->job);
+            return;
+        }
+    }
+    for (first = 0; first < count; first += chunk)
+    {
+        chunk = count - first < MATRIX_SERVER_BATCH ? count - first : MATRIX_SERVER_BATCH;
+        for (i = 0; i < 3; i++)
+            matrix_batch_resize(&b[i], chunk);
+        for (i = 0; i < chunk; i++)
+        {
+            matrix_batch_load(&b[0], i, reqs[first + i]->job.a);
+            matrix_batch_load(&b[1], i, reqs[first + i]->job.b);
+        }
+        matrix_batch_multiply(&b[2], &b[0], &b[1]);
+        for (i = 0; i < chunk; i++)
+        {
+            matrix_batch_store(&b[2], i, reqs[first + i]->job.c);
+            reqs[first + i]->job.status = 0;
+        }
+    }
+}
+
+static int batchable(const MatrixJob *job)
+{
+    return job->m == job->k && job->k == job->n && job->n <= MATRIX_BATCH_MAX_N;
+}
+
+// Serves every pending request and queues the responses in arrival order
+static void serve_pending(Server *s)
+{
+    Request *group[MATRIX_SERVER_MAX_PENDING];
+    int i, n, count;
+
+    // Coalesce per order; a lone small request is cheaper unbatched
+    for (n = 1; n <= MATRIX_BATCH_MAX_N; n++)
+    {
+        count = 0;
+        for (i = 0; i < s->npending; i++)
+            if (batchable(&s->pending[i]->job) && s->pending[i]->job.n == n)
+                group[count++] = s->pending[i];
+        if (count > 1)
+            serve_batched(s, group, count, n);
+        else if (count == 1)
+            matrix_job_run(&group[0]->job);
+    }
+    for (i = 0; i < s->npending; i++)
+    {
+        if (!batchable(&s->pending[i]->job))
+            matrix_job_run(&s->pending[i]->job);
+        respond(s->pending[i]);
+        request_put(s, s->pending[i]);
+    }
+    s->npending = 0;
+}
+
+// Moves complete request frames of c's input to the pending list until the
+// responses they will produce, on top of the unsent output, would pass
+// MATRIX_SERVER_MAX_OUTPUT. The rest stays in 'in' with the connection
+// stalled; one response larger than the cap still goes through on its own.
+static void parse_frames(Server *s, Conn *c)
+{
+    size_t pos = 0;
+
+    c->stalled = 0;
+    while (!c->dead && c->in_len - pos >= sizeof(uint32_t) + MATRIX_SERVER_HEADER_BYTES)
+    {
+        uint32_t head[5];
+        Request *r;
+        size_t need;
+
+        memcpy(head, c->in + pos, sizeof(head));
+        need = (size_t)head[0] + sizeof(uint32_t);
+        if (head[0] > MATRIX_SERVER_MAX_FRAME)
+        {
+            c->dead = 1;
+            break;
+        }
+        if (c->in_len - pos < need)
+            break;
+        {
+            size_t queued = c->out_len - c->out_sent + c->projected;
+            if (queued > 0 && queued + RESPONSE_BYTES(head[2], head[4]) > MATRIX_SERVER_MAX_OUTPUT)
+            {
+                c->stalled = 1;
+                break;
+            }
+        }
+
+        r = request_get(s);
+        if (r == NULL || head[2] > MATRIX_STREAM_MAX_DIM || head[3] > MATRIX_STREAM_MAX_DIM ||
+            head[4] > MATRIX_STREAM_MAX_DIM ||
+            matrix_job_reserve(&r->job, (int)head[2], (int)head[3], (int)head[4]) != 0 ||
+            head[0] != MATRIX_SERVER_HEADER_BYTES +
+                           sizeof(int) * ((size_t)r->job.m * r->job.k + (size_t)r->job.k * r->job.n))
+        {
+            if (r != NULL)
+                request_put(s, r);
+            c->dead = 1;
+            break;
+        }
+        r->id = head[1];
+        r->conn = c;
+        c->projected += RESPONSE_BYTES(r->job.m, r->job.n);
+        memcpy(r->job.a, c->in + pos + sizeof(head), sizeof(int) * (size_t)r->job.m * r->job.k);
+        memcpy(r->job.b, c->in + pos + sizeof(head) + sizeof(int) * (size_t)r->job.m * r->job.k,
+               sizeof(int) * (size_t)r->job.k * r->job.n);
+        pos += need;
+
+        if (s->npending == MATRIX_SERVER_MAX_PENDING)
+            serve_pending(s);
+        s->pending[s->npending++] = r;
+    }
+    memmove(c->in, c->in + pos, c->in_len - pos);
+    c->in_len -= pos;
+}
+
+// Reads at most MATRIX_SERVER_READ_BUDGET bytes; epoll reports the rest on
+// the next pass
+static void read_conn(Server *s, Conn *c)
+{
+    size_t budget = MATRIX_SERVER_READ_BUDGET, room;
+
+    if (backlogged(c) || c->stalled)
+        return;
+    while (budget > 0)
+    {
+        ssize_t n;
+        if (reserve(&c->in, &c->in_cap, c->in_len + 4096) != 0)
+        {
+            c->dead = 1;
+            return;
+        }
+        room = c->in_cap - c->in_len < budget ? c->in_cap - c->in_len : budget;
+        n = recv(c->fd, c->in + c->in_len, room, 0);
+        if (n > 0)
+        {
+            c->in_len += n;
+            budget -= n;
+            continue;
+        }
+        if (n == 0)
+            c->closing = 1;
+        else if (errno == EINTR)
+            continue;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+            c->dead = 1;
+        break;
+    }
+    parse_frames(s, c);
+}
+
+static void accept_conns(Server *s)
+{
+    for (;;)
+    {
+        Conn *c;
+        int fd = accept4(s->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        c = (Conn *)calloc(1, sizeof(Conn));
+        if (c == NULL)
+        {
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->next = s->conns;
+        s->conns = c;
+        watch(s, c, EPOLLIN, EPOLL_CTL_ADD);
+    }
+}
+
+static void close_conn(Server *s, Conn *c)
+{
+    epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+    free(c);
+}
+
+// Frees connections that failed or finished; no request refers to one here,
+// since every round is served before the sweep
+static void sweep(Server *s)
+{
+    Conn **link = &s->conns;
+
+    while (*link != NULL)
+    {
+        Conn *c = *link;
+        if (c->dead || (c->closing && c->out_len == 0 && !c->stalled))
+        {
+            *link = c->next;
+            close_conn(s, c);
+        }
+        else
+            link = &c->next;
+    }
+}
+
+static int listen_on(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int matrix_server_run(const char *path)
+{
+    Server s;
+    struct epoll_event events[MAX_EVENTS], ev;
+    struct sigaction sa;
+    Conn *c;
+    int i, n, j, timeout;
+
+    memset(&s, 0, sizeof(s));
+    s.listen_fd = listen_on(path);
+    if (s.listen_fd < 0)
+        return -1;
+    s.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (s.epfd < 0)
+    {
+        close(s.listen_fd);
+        return -1;
+    }
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(s.epfd, EPOLL_CTL_ADD, s.listen_fd, &ev);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    stop_requested = 0;
+
+    while (!stop_requested)
+    {
+        // A stalled connection whose output has drained holds requests no
+        // event will announce, so poll instead of waiting
+        timeout = -1;
+        for (c = s.conns; c != NULL; c = c->next)
+            if (c->stalled && c->out_len == 0)
+                timeout = 0;
+        n = epoll_wait(s.epfd, events, MAX_EVENTS, timeout);
+        if (n < 0)
+            continue; // EINTR from the stop signal
+        for (i = 0; i < n; i++)
+        {
+            c = (Conn *)events[i].data.ptr;
+            if (c == NULL)
+                accept_conns(&s);
+            else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                read_conn(&s, c);
+        }
+        for (c = s.conns; c != NULL; c = c->next)
+            if (c->stalled && !c->dead && c->out_len == 0)
+                parse_frames(&s, c);
+
+        // Everything that arrived in this pass is one round
+        serve_pending(&s);
+        // Pending output, including what waited for EPOLLOUT, goes out now
+        for (c = s.conns; c != NULL; c = c->next)
+            if (c->out_len > c->out_sent || c->closing)
+                flush_conn(&s, c);
+        sweep(&s);
+    }
+
+    while (s.conns != NULL)
+    {
+        c = s.conns;
+        s.conns = c->next;
+        close_conn(&s, c);
+    }
+    while (s.free_requests != NULL)
+    {
+        Request *r = s.free_requests;
+        s.free_requests = r->next;
+        matrix_job_free(&r->job);
+        free(r);
+    }
+    for (i = 1; i <= MATRIX_BATCH_MAX_N; i++)
+        for (j = 0; j < 3; j++)
+            if (s.batch[i][j].data != NULL)
+                matrix_batch_free(&s.batch[i][j]);
+    close(s.epfd);
+    close(s.listen_fd);
+    unlink(path);
+    return 0;
+}
+
+int matrix_server_main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <socket path>\n", argv[0]);
+        return 1;
+    }
+    if (matrix_server_run(argv[1]) != 0)
+    {
+        fprintf(stderr, "Error: cannot listen on %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
+
+int matrix_client_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int send_all(int fd, const void *buf, size_t bytes)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+
+    while (bytes > 0)
+    {
+        ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+static int recv_all(int fd, void *buf, size_t bytes)
+{
+    unsigned char *p = (unsigned char *)buf;
+
+    while (bytes > 0)
+    {
+        ssize_t n = recv(fd, p, bytes, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+int matrix_client_send(int fd, uint32_t id, const MatrixJob *job)
+{
+    size_t na = (size_t)job->m * job->k, nb = (size_t)job->k * job->n;
+    uint32_t head[5];
+
+    head[0] = MATRIX_SERVER_HEADER_BYTES + sizeof(int) * (na + nb);
+    head[1] = id;
+    head[2] = job->m;
+    head[3] = job->k;
+    head[4] = job->n;
+    if (send_all(fd, head, sizeof(head)) != 0 || send_all(fd, job->a, sizeof(int) * na) != 0 ||
+        send_all(fd, job->b, sizeof(int) * nb) != 0)
+        return -1;
+    return 0;
+}
+
+int matrix_client_recv(int fd, uint32_t *id, MatrixJob *job)
+{
+    uint32_t head[5];
+    size_t data;
+
+    if (recv_all(fd, head, sizeof(head)) != 0)
+        return -1;
+    job->status = (int32_t)head[2];
+    data = job->status == 0 ? sizeof(int) * (size_t)job->m * job->n : 0;
+    if (head[0] != MATRIX_SERVER_HEADER_BYTES + data || head[3] != (uint32_t)job->m ||
+        head[4] != (uint32_t)job->n)
+        return -1;
+    *id = head[1];
+    return recv_all(fd, job->c, data);
+}
+
+int matrix_client_call(int fd, uint32_t id, MatrixJob *job)
+{
+    uint32_t got;
+
+    if (matrix_client_send(fd, id, job) != 0 || matrix_client_recv(fd, &got, job) != 0)
+        return -1;
+    return got == id ? 0 : -1;
+}
@@ -0,0 +1,58 @@
+#ifndef MATRIX_SERVER_H
+#define MATRIX_SERVER_H
+
+#include <stdint.h>
+#include "matrix_stream.h"
+
+// Local multiply service on a Unix domain stream socket. Every message is a
+// frame: uint32 length of the rest of the frame, then (host byte order)
+//   request:  uint32 id, m, k, n; m*k int32 entries of A; k*n of B
+//   response: uint32 id; int32 status; uint32 m, n; m*n entries of C when
+//             status is 0
+// A connection may pipeline any number of requests; responses come back in
+// request order with the request's id.
+#define MATRIX_SERVER_HEADER_BYTES 16
+
+// Longest frame accepted; a connection sending more is dropped
+#define MATRIX_SERVER_MAX_FRAME (64 << 20)
+
+// Requests gathered in one event loop pass before they are served anyway
+#define MATRIX_SERVER_MAX_PENDING 1024
+
+// Response bytes, unsent or owed to requests already parsed, past which a
+// connection's remaining requests are neither parsed nor read until the
+// client catches up, so a client that pipelines without reading cannot grow
+// the server's memory without bound. A single response larger than this
+// still goes out on its own.
+#define MATRIX_SERVER_MAX_OUTPUT (4 << 20)
+
+// Bytes read from one connection per event loop pass, so one fast sender
+// cannot hold up the others or queue a whole flood of work in one round
+#define MATRIX_SERVER_READ_BUDGET (1 << 20)
+
+// Serves requests on 'path' until SIGINT or SIGTERM. One epoll loop reads
+// every ready connection, then serves what arrived as one round: small
+// square requests of the same order (up to MATRIX_BATCH_MAX_N) are coalesced
+// into one matrix_batch_multiply() call, the rest go through matrix_gemm()
+// and its worker pool. Nothing waits for a batch to fill, so an idle server
+// answers a lone request at once and a busy one batches more per pass.
+// Returns 0 after a signal, -1 if the socket cannot be set up.
+int matrix_server_run(const char *path);
+
+// Command line front end: --serve <socket path>
+int matrix_server_main(int argc, char *argv[]);
+
+// Client side: a connected socket or -1
+int matrix_client_connect(const char *path);
+
+// Send a request from job's operands / read the next response into job->c
+// and job->status (job->m and job->n must match the request). A client may
+// send several requests before reading their responses. Return 0 on success,
+// -1 on an I/O or protocol error.
+int matrix_client_send(int fd, uint32_t id, const MatrixJob *job);
+int matrix_client_recv(int fd, uint32_t *id, MatrixJob *job);
+
+// One round trip: send then receive
+int matrix_client_call(int fd, uint32_t id, MatrixJob *job);
+
+#endif // MATRIX_SERVER_H
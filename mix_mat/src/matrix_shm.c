@@ -0,0 +1,340 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "matrix_shm.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__arm__) || defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+#define ALIGN64(x) (((x) + 63) & ~(uint64_t)63)
+
+// Shared (not process-private) futexes: the two sides are separate processes
+static void futex_wait(uint32_t *addr, uint32_t value)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+static void futex_wake(uint32_t *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static size_t region_size(uint32_t slots, uint32_t slot_bytes)
+{
+    return (size_t)ALIGN64(sizeof(MatrixShmHeader) + sizeof(MatrixShmJob) * slots) + (size_t)slots * slot_bytes;
+}
+
+static int map_region(MatrixShm *shm)
+{
+    void *p = mmap(NULL, shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+
+    if (p == MAP_FAILED)
+        return -1;
+    shm->header = (MatrixShmHeader *)p;
+    shm->jobs = (MatrixShmJob *)(shm->header + 1);
+    shm->data = (unsigned char *)p + (size_t)ALIGN64(sizeof(MatrixShmHeader) + sizeof(MatrixShmJob) * shm->header->slots);
+    return 0;
+}
+
+int matrix_shm_create(MatrixShm *shm, const char *name, int slots, size_t slot_bytes)
+{
+    MatrixShmHeader *h;
+
+    if (slots <= 0 || (slots & (slots - 1)) != 0 || slot_bytes == 0 || slot_bytes > UINT32_MAX - 63 ||
+        strlen(name) + 2 > sizeof(shm->name))
+        return -1;
+    snprintf(shm->name, sizeof(shm->name), "/%s", name);
+    slot_bytes = (size_t)ALIGN64(slot_bytes);
+    shm->size = region_size(slots, (uint32_t)slot_bytes);
+    shm->owner = 1;
+    shm->reaped = 0;
+
+    shm_unlink(shm->name);
+    shm->fd = shm_open(shm->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (shm->fd < 0)
+        return -1;
+    if (ftruncate(shm->fd, (off_t)shm->size) != 0)
+        goto fail;
+
+    // The fresh region reads as zeros; fill in the geometry before mapping
+    // the derived pointers, and the magic last
+    h = (MatrixShmHeader *)mmap(NULL, sizeof(*h), PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+    if (h == MAP_FAILED)
+        goto fail;
+    h->version = MATRIX_SHM_VERSION;
+    h->slots = slots;
+    h->slot_bytes = (uint32_t)slot_bytes;
+    __atomic_store_n(&h->magic, MATRIX_SHM_MAGIC, __ATOMIC_RELEASE);
+    munmap(h, sizeof(*h));
+    if (map_region(shm) != 0)
+        goto fail;
+    return 0;
+
+fail:
+    close(shm->fd);
+    shm_unlink(shm->name);
+    return -1;
+}
+
+int matrix_shm_attach(MatrixShm *shm, const char *name)
+{
+    MatrixShmHeader h;
+    struct stat st;
+
+    if (strlen(name) + 2 > sizeof(shm->name))
+        return -1;
+    snprintf(shm->name, sizeof(shm->name), "/%s", name);
+    shm->owner = 0;
+    shm->fd = shm_open(shm->name, O_RDWR, 0);
+    if (shm->fd < 0)
+        return -1;
+    if (fstat(shm->fd, &st) != 0 || pread(shm->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+        h.magic != MATRIX_SHM_MAGIC || h.version != MATRIX_SHM_VERSION || h.slots == 0 ||
+        (h.slots & (h.slots - 1)) != 0 || (uint64_t)st.st_size < region_size(h.slots, h.slot_bytes))
+    {
+        close(shm->fd);
+        return -1;
+    }
+    shm->size = region_size(h.slots, h.slot_bytes);
+    if (map_region(shm) != 0)
+    {
+        close(shm->fd);
+        return -1;
+    }
+
+    // Resume after whatever an earlier producer left behind
+    shm->reaped = __atomic_load_n(&shm->header->tail, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+void matrix_shm_detach(MatrixShm *shm)
+{
+    munmap(shm->header, shm->size);
+    close(shm->fd);
+    if (shm->owner)
+        shm_unlink(shm->name);
+    shm->header = NULL;
+    shm->fd = -1;
+}
+
+// Offsets of B and C in a slot, and the bytes the job needs (64-bit, so
+// hostile shapes cannot wrap on the 32-bit HPS)
+static uint64_t slot_layout(uint32_t m, uint32_t k, uint32_t n, size_t *b_off, size_t *c_off)
+{
+    uint64_t b = ALIGN64((uint64_t)sizeof(int) * m * k);
+    uint64_t c = b + ALIGN64((uint64_t)sizeof(int) * k * n);
+
+    *b_off = (size_t)b;
+    *c_off = (size_t)c;
+    return c + (uint64_t)sizeof(int) * m * n;
+}
+
+// Polls before sleeping; none on a single CPU, where the other side cannot
+// make progress while we spin
+static int spin_limit(void)
+{
+    static int limit = -1;
+    if (limit < 0)
+        limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? MATRIX_SHM_SPIN : 0;
+    return limit;
+}
+
+// Waits until *counter differs from 'seen': spin first, then sleep in the
+// futex after announcing it through *sleeping. The announcement and the
+// recheck are ordered by a full fence, as are the notifier's counter store and
+// its check of *sleeping, so one side always sees the other.
+static uint32_t wait_change(MatrixShm *shm, uint32_t *counter, uint32_t seen, uint32_t *sleeping,
+                            volatile sig_atomic_t *stop_flag)
+{
+    uint32_t v;
+    int i, spins = spin_limit();
+
+    for (;;)
+    {
+        for (i = 0; i < spins; i++)
+        {
+            v = __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+            if (v != seen)
+                return v;
+            cpu_relax();
+        }
+        if (__atomic_load_n(&shm->header->stop, __ATOMIC_ACQUIRE) || (stop_flag != NULL && *stop_flag))
+            return seen;
+
+        __atomic_store_n(sleeping, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        v = __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+        if (v == seen && !__atomic_load_n(&shm->header->stop, __ATOMIC_ACQUIRE))
+            futex_wait(counter, seen);
+        __atomic_store_n(sleeping, 0, __ATOMIC_RELAXED);
+        if (v != seen)
+            return v;
+    }
+}
+
+static void publish(uint32_t *counter, uint32_t value, uint32_t *sleeping)
+{
+    __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(sleeping, __ATOMIC_RELAXED))
+        futex_wake(counter);
+}
+
+int matrix_shm_acquire(MatrixShm *shm, Matrix *A, Matrix *B, int m, int k, int n)
+{
+    MatrixShmHeader *h = shm->header;
+    uint32_t head = h->head; // only the producer writes it
+    unsigned char *slot;
+    MatrixShmJob *job;
+    size_t b_off, c_off;
+
+    if (head - shm->reaped >= h->slots || m <= 0 || k <= 0 || n <= 0 ||
+        slot_layout(m, k, n, &b_off, &c_off) > h->slot_bytes)
+        return -1;
+    job = &shm->jobs[head & (h->slots - 1)];
+    slot = shm->data + (size_t)(head & (h->slots - 1)) * h->slot_bytes;
+    job->m = m;
+    job->k = k;
+    job->n = n;
+    matrix_view(A, (int *)slot, m, k, k);
+    matrix_view(B, (int *)(slot + b_off), k, n, n);
+    return 0;
+}
+
+void matrix_shm_submit(MatrixShm *shm)
+{
+    MatrixShmHeader *h = shm->header;
+    publish(&h->head, h->head + 1, &h->consumer_sleeping);
+}
+
+int matrix_shm_wait(MatrixShm *shm, Matrix *C)
+{
+    MatrixShmHeader *h = shm->header;
+    uint32_t index = shm->reaped & (h->slots - 1);
+    uint32_t tail = __atomic_load_n(&h->tail, __ATOMIC_ACQUIRE);
+    MatrixShmJob *job = &shm->jobs[index];
+    size_t b_off, c_off;
+
+    if (shm->reaped == h->head)
+        return -1; // nothing outstanding
+    while ((int32_t)(tail - shm->reaped) <= 0)
+    {
+        tail = wait_change(shm, &h->tail, tail, &h->producer_sleeping, NULL);
+        if (__atomic_load_n(&h->stop, __ATOMIC_ACQUIRE) && (int32_t)(tail - shm->reaped) <= 0)
+            return -1;
+    }
+    slot_layout(job->m, job->k, job->n, &b_off, &c_off);
+    matrix_view(C, (int *)(shm->data + (size_t)index * h->slot_bytes + c_off), job->m, job->n, job->n);
+    return job->status;
+}
+
+void matrix_shm_release(MatrixShm *shm)
+{
+    if (shm->reaped != shm->header->head)
+        shm->reaped++;
+}
+
+// Runs job 'seq' in place in its slot
+static void run_job(MatrixShm *shm, uint32_t seq)
+{
+    MatrixShmHeader *h = shm->header;
+    MatrixShmJob *job = &shm->jobs[seq & (h->slots - 1)];
+    unsigned char *slot = shm->data + (size_t)(seq & (h->slots - 1)) * h->slot_bytes;
+    uint32_t m = job->m, k = job->k, n = job->n;
+    size_t b_off, c_off;
+    Matrix A, B, C;
+
+    // The descriptor comes from another process; check it before trusting it
+    if (m == 0 || k == 0 || n == 0 || slot_layout(m, k, n, &b_off, &c_off) > h->slot_bytes)
+    {
+        job->status = -1;
+        return;
+    }
+    matrix_view(&A, (int *)slot, m, k, k);
+    matrix_view(&B, (int *)(slot + b_off), k, n, n);
+    matrix_view(&C, (int *)(slot + c_off), m, n, n);
+    job->status = matrix_gemm(&C, &A, &B);
+}
+
+void matrix_shm_serve(MatrixShm *shm, volatile sig_atomic_t *stop_flag)
+{
+    MatrixShmHeader *h = shm->header;
+    uint32_t tail = h->tail, head = __atomic_load_n(&h->head, __ATOMIC_ACQUIRE);
+
+    for (;;)
+    {
+        while (tail != head)
+        {
+            run_job(shm, tail);
+            tail++;
+            publish(&h->tail, tail, &h->producer_sleeping);
+        }
+        head = wait_change(shm, &h->head, head, &h->consumer_sleeping, stop_flag);
+        if (tail == head &&
+            (__atomic_load_n(&h->stop, __ATOMIC_ACQUIRE) || (stop_flag != NULL && *stop_flag)))
+            return;
+    }
+}
+
+void matrix_shm_stop(MatrixShm *shm)
+{
+    MatrixShmHeader *h = shm->header;
+
+    __atomic_store_n(&h->stop, 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    futex_wake(&h->head);
+    futex_wake(&h->tail);
+}
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+int matrix_shm_main(int argc, char *argv[])
+{
+    MatrixShm shm;
+    struct sigaction sa;
+    int slots = argc > 2 ? atoi(argv[2]) : 64;
+    long slot_bytes = argc > 3 ? atol(argv[3]) : 64 * 1024;
+
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "usage: %s <name> [slots] [slot bytes]\n", argv[0]);
+        return 1;
+    }
+    if (slot_bytes <= 0 || matrix_shm_create(&shm, argv[1], slots, (size_t)slot_bytes) != 0)
+    {
+        fprintf(stderr, "Error: cannot create shared memory ring /%s\n", argv[1]);
+        return 1;
+    }
+
+    // No SA_RESTART, so a signal breaks the futex wait
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    stop_requested = 0;
+
+    matrix_shm_serve(&shm, &stop_requested);
+    matrix_shm_detach(&shm);
+    return 0;
+}
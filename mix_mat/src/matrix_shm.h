@@ -0,0 +1,95 @@
+#ifndef MATRIX_SHM_H
+#define MATRIX_SHM_H
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix.h"
+
+// Zero-copy job ring in POSIX shared memory, for one client process (the
+// producer) and one compute process (the consumer). The region holds a header,
+// a ring of job descriptors and one operand area per ring slot. The client
+// builds A and B directly in a slot, publishes it by advancing 'head', and
+// finds C in the same slot once 'tail' has passed it; nothing is copied and
+// no system call is made while the other side is awake.
+//
+// Both counters only grow; slot i serves jobs i, i + slots, ... Each side
+// spins for MATRIX_SHM_SPIN polls (none on a single CPU) before sleeping in a
+// futex on the counter it waits for, and the other side only issues a wake
+// when it sees the sleeping flag set, so a busy ring never enters the kernel.
+#define MATRIX_SHM_MAGIC 0x4d53484d // "MHSM"
+#define MATRIX_SHM_VERSION 1
+#define MATRIX_SHM_SPIN 4000
+
+// Job descriptor, written by the client before it publishes the slot
+typedef struct
+{
+    uint32_t m;
+    uint32_t k;
+    uint32_t n;
+    int32_t status; // set by the consumer: 0 or -1
+} MatrixShmJob;
+
+// Start of the region. Producer-written and consumer-written words live on
+// separate cache lines so the two sides never false-share.
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;      // power of two
+    uint32_t slot_bytes; // operand area per slot, a multiple of 64
+    uint32_t stop;       // set to make the consumer return
+    uint8_t pad0[44];
+
+    uint32_t head;              // jobs published by the producer
+    uint32_t consumer_sleeping; // consumer is, or is about to be, in futex_wait(head)
+    uint8_t pad1[56];
+
+    uint32_t tail;              // jobs completed by the consumer
+    uint32_t producer_sleeping; // producer is, or is about to be, in futex_wait(tail)
+    uint8_t pad2[56];
+} MatrixShmHeader;
+
+typedef struct
+{
+    int fd;
+    int owner; // created the region, unlinks it on detach
+    size_t size;
+    MatrixShmHeader *header;
+    MatrixShmJob *jobs;
+    unsigned char *data;
+    uint32_t reaped; // producer side: oldest job whose slot is still held
+    char name[64];
+} MatrixShm;
+
+// Creates the region '/name' with 'slots' (a power of two) slots of
+// 'slot_bytes' operand space each. Returns 0 on success, -1 on failure.
+int matrix_shm_create(MatrixShm *shm, const char *name, int slots, size_t slot_bytes);
+
+// Maps an existing region
+int matrix_shm_attach(MatrixShm *shm, const char *name);
+void matrix_shm_detach(MatrixShm *shm);
+
+// Producer: claims the next slot for an m x k by k x n product and points A
+// and B at its operand space to be filled in place. Returns -1 if the ring is
+// full (wait for and release a completion first) or the shapes do not fit.
+int matrix_shm_acquire(MatrixShm *shm, Matrix *A, Matrix *B, int m, int k, int n);
+
+// Producer: publishes the slot taken by the last acquire
+void matrix_shm_submit(MatrixShm *shm);
+
+// Producer: waits for the oldest unreleased job and points C at its result.
+// Returns the job's status. C stays valid until matrix_shm_release().
+int matrix_shm_wait(MatrixShm *shm, Matrix *C);
+void matrix_shm_release(MatrixShm *shm);
+
+// Consumer: runs published jobs in place until matrix_shm_stop() is called
+// from either side; 'stop_flag' (may be NULL) is also checked whenever the
+// consumer wakes, e.g. after a signal.
+void matrix_shm_serve(MatrixShm *shm, volatile sig_atomic_t *stop_flag);
+void matrix_shm_stop(MatrixShm *shm);
+
+// Command line front end: --shm <name> [slots] [slot bytes]
+int matrix_shm_main(int argc, char *argv[]);
+
+#endif // MATRIX_SHM_H
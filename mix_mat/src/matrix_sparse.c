@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_sparse.h"
+#include "matrix_pool.h"
+
+// Bytes of one arena block holding the three arrays of a compressed matrix
+static size_t compressed_bytes(int major, int nnz)
+{
+    return matrix_arena_footprint(sizeof(int) * ((size_t)major + 1)) +
+           2 * matrix_arena_footprint(sizeof(int) * (nnz > 0 ? nnz : 1));
+}
+
+// Splits a compressed_bytes() block into the three arrays; ptr starts zeroed
+static void compressed_carve(unsigned char *buf, int major, int nnz, int **ptr, int **idx, int **val)
+{
+    size_t ptr_bytes = matrix_arena_footprint(sizeof(int) * ((size_t)major + 1));
+    size_t nnz_bytes = matrix_arena_footprint(sizeof(int) * (nnz > 0 ? nnz : 1));
+
+    *ptr = (int *)buf;
+    *idx = (int *)(buf + ptr_bytes);
+    *val = (int *)(buf + ptr_bytes + nnz_bytes);
+    memset(*ptr, 0, sizeof(int) * ((size_t)major + 1));
+}
+
+// Allocates the three arrays of a compressed matrix with 'major' pointer slots,
+// from 'arena' in one block or from the heap if it is NULL
+static int compressed_alloc(int major, int nnz, int **ptr, int **idx, int **val, MatrixArena *arena)
+{
+    if (arena != NULL)
+    {
+        unsigned char *buf = (unsigned char *)matrix_arena_alloc(arena, compressed_bytes(major, nnz));
+        if (buf == NULL)
+            return -1;
+        compressed_carve(buf, major, nnz, ptr, idx, val);
+        return 0;
+    }
+    *ptr = (int *)calloc((size_t)major + 1, sizeof(int));
+    *idx = (int *)malloc(sizeof(int) * (nnz > 0 ? nnz : 1));
+    *val = (int *)malloc(sizeof(int) * (nnz > 0 ? nnz : 1));
+    if (*ptr == NULL || *idx == NULL || *val == NULL)
+    {
+        free(*ptr);
+        free(*idx);
+        free(*val);
+        *ptr = *idx = *val = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Buckets triplets by their major index (row for CSR, column for CSC) with a
+// counting sort, keeping the input order within each bucket
+static int compress_triplets(int major, int nnz, const int *key, const int *minor, const int *v,
+                             int **ptr_out, int **idx_out, int **val_out, MatrixArena *arena)
+{
+    int *ptr, *idx, *val, *next;
+    size_t mark = 0;
+    int p;
+
+    if (compressed_alloc(major, nnz, &ptr, &idx, &val, arena) != 0)
+        return -1;
+    for (p = 0; p < nnz; p++)
+        ptr[key[p] + 1]++;
+    for (p = 0; p < major; p++)
+        ptr[p + 1] += ptr[p];
+
+    if (arena != NULL)
+    {
+        mark = matrix_arena_mark(arena);
+        next = (int *)matrix_arena_alloc(arena, sizeof(int) * (major > 0 ? major : 1));
+    }
+    else
+        next = (int *)malloc(sizeof(int) * (major > 0 ? major : 1));
+    if (next == NULL)
+    {
+        // Arena storage goes back with the caller's arena
+        if (arena == NULL)
+        {
+            free(ptr);
+            free(idx);
+            free(val);
+        }
+        return -1;
+    }
+    memcpy(next, ptr, sizeof(int) * major);
+    for (p = 0; p < nnz; p++)
+    {
+        int slot = next[key[p]]++;
+        idx[slot] = minor[p];
+        val[slot] = v[p];
+    }
+    if (arena != NULL)
+        matrix_arena_release(arena, mark);
+    else
+        free(next);
+
+    *ptr_out = ptr;
+    *idx_out = idx;
+    *val_out = val;
+    return 0;
+}
+
+static int triplets_valid(int rows, int cols, int nnz, const int *row, const int *col)
+{
+    int p;
+    if (rows <= 0 || cols <= 0 || nnz < 0)
+        return 0;
+    for (p = 0; p < nnz; p++)
+    {
+        if (row[p] < 0 || row[p] >= rows || col[p] < 0 || col[p] >= cols)
+            return 0;
+    }
+    return 1;
+}
+
+int matrix_csr_from_triplets(MatrixCSR *s, int rows, int cols, int nnz,
+                             const int *row, const int *col, const int *val, MatrixArena *arena)
+{
+    if (!triplets_valid(rows, cols, nnz, row, col))
+        return -1;
+    if (compress_triplets(rows, nnz, row, col, val, &s->ptr, &s->idx, &s->val, arena) != 0)
+        return -1;
+    s->rows = rows;
+    s->cols = cols;
+    s->nnz = nnz;
+    return 0;
+}
+
+int matrix_csc_from_triplets(MatrixCSC *s, int rows, int cols, int nnz,
+                             const int *row, const int *col, const int *val, MatrixArena *arena)
+{
+    if (!triplets_valid(rows, cols, nnz, row, col))
+        return -1;
+    if (compress_triplets(cols, nnz, col, row, val, &s->ptr, &s->idx, &s->val, arena) != 0)
+        return -1;
+    s->rows = rows;
+    s->cols = cols;
+    s->nnz = nnz;
+    return 0;
+}
+
+static int count_nonzeros(const Matrix *m)
+{
+    int i, j, nnz = 0;
+    for (i = 0; i < m->rows; i++)
+    {
+        const int *r = m->data + i * m->stride;
+        for (j = 0; j < m->cols; j++)
+            nnz += r[j] != 0;
+    }
+    return nnz;
+}
+
+// Fills allocated CSR arrays from the nnz nonzeros of m
+static void csr_fill(MatrixCSR *s, const Matrix *m, int nnz)
+{
+    int i, j, p = 0;
+
+    for (i = 0; i < m->rows; i++)
+    {
+        const int *r = m->data + i * m->stride;
+        for (j = 0; j < m->cols; j++)
+        {
+            if (r[j] != 0)
+            {
+                s->idx[p] = j;
+                s->val[p] = r[j];
+                p++;
+            }
+        }
+        s->ptr[i + 1] = p;
+    }
+    s->rows = m->rows;
+    s->cols = m->cols;
+    s->nnz = nnz;
+}
+
+static void csc_fill(MatrixCSC *s, const Matrix *m, int nnz)
+{
+    int i, j, p = 0;
+
+    for (j = 0; j < m->cols; j++)
+    {
+        for (i = 0; i < m->rows; i++)
+        {
+            int v = MAT_AT(m, i, j);
+            if (v != 0)
+            {
+                s->idx[p] = i;
+                s->val[p] = v;
+                p++;
+            }
+        }
+        s->ptr[j + 1] = p;
+    }
+    s->rows = m->rows;
+    s->cols = m->cols;
+    s->nnz = nnz;
+}
+
+int matrix_csr_from_dense(MatrixCSR *s, const Matrix *m, MatrixArena *arena)
+{
+    int nnz = count_nonzeros(m);
+
+    if (compressed_alloc(m->rows, nnz, &s->ptr, &s->idx, &s->val, arena) != 0)
+        return -1;
+    csr_fill(s, m, nnz);
+    return 0;
+}
+
+int matrix_csc_from_dense(MatrixCSC *s, const Matrix *m, MatrixArena *arena)
+{
+    int nnz = count_nonzeros(m);
+
+    if (compressed_alloc(m->cols, nnz, &s->ptr, &s->idx, &s->val, arena) != 0)
+        return -1;
+    csc_fill(s, m, nnz);
+    return 0;
+}
+
+void matrix_csr_free(MatrixCSR *s)
+{
+    free(s->ptr);
+    free(s->idx);
+    free(s->val);
+    s->ptr = s->idx = s->val = NULL;
+    s->nnz = 0;
+}
+
+void matrix_csc_free(MatrixCSC *s)
+{
+    free(s->ptr);
+    free(s->idx);
+    free(s->val);
+    s->ptr = s->idx = s->val = NULL;
+    s->nnz = 0;
+}
+
+int matrix_csr_to_dense(Matrix *m, const MatrixCSR *s)
+{
+    int i, p;
+    if (m->rows != s->rows || m->cols != s->cols)
+        return -1;
+    matrix_zero(m);
+    for (i = 0; i < s->rows; i++)
+    {
+        for (p = s->ptr[i]; p < s->ptr[i + 1]; p++)
+            MAT_AT(m, i, s->idx[p]) += s->val[p];
+    }
+    return 0;
+}
+
+int matrix_csr_spmv(int *y, const MatrixCSR *A, const int *x)
+{
+    int i, p;
+    for (i = 0; i < A->rows; i++)
+    {
+        int sum = 0;
+        for (p = A->ptr[i]; p < A->ptr[i + 1]; p++)
+            sum += A->val[p] * x[A->idx[p]];
+        y[i] = sum;
+    }
+    return 0;
+}
+
+// Column-major scatter: y += x[j] * column j
+int matrix_csc_spmv(int *y, const MatrixCSC *A, const int *x)
+{
+    int j, p;
+    memset(y, 0, sizeof(int) * A->rows);
+    for (j = 0; j < A->cols; j++)
+    {
+        int xj = x[j];
+        if (xj == 0)
+            continue;
+        for (p = A->ptr[j]; p < A->ptr[j + 1]; p++)
+            y[A->idx[p]] += A->val[p] * xj;
+    }
+    return 0;
+}
+
+// Row panels of a CSR x dense product, shared with the worker pool
+typedef struct
+{
+    Matrix *C;
+    const MatrixCSR *A;
+    const Matrix *B;
+    int rows_per_task;
+} SpmmJob;
+
+// Row i of C is a sum of scaled rows of B: contiguous axpy loops the compiler
+// vectorizes, with no work at all for the zeros of A
+static void csr_rows(const SpmmJob *job, int begin, int end)
+{
+    const MatrixCSR *A = job->A;
+    const Matrix *B = job->B;
+    Matrix *C = job->C;
+    int i, j, p;
+
+    for (i = begin; i < end; i++)
+    {
+        int *c = C->data + i * C->stride;
+        memset(c, 0, sizeof(int) * C->cols);
+        for (p = A->ptr[i]; p < A->ptr[i + 1]; p++)
+        {
+            int a = A->val[p];
+            const int *b = B->data + A->idx[p] * B->stride;
+            for (j = 0; j < C->cols; j++)
+                c[j] += a * b[j];
+        }
+    }
+}
+
+static void csr_task(void *arg, int index)
+{
+    const SpmmJob *job = (const SpmmJob *)arg;
+    int begin = index * job->rows_per_task;
+    int end = begin + job->rows_per_task < job->C->rows ? begin + job->rows_per_task : job->C->rows;
+    csr_rows(job, begin, end);
+}
+
+int matrix_csr_spmm(Matrix *C, const MatrixCSR *A, const Matrix *B)
+{
+    SpmmJob job;
+    int threads, tasks;
+
+    if (B->rows != A->cols || C->rows != A->rows || C->cols != B->cols)
+        return -1;
+
+    job.C = C;
+    job.A = A;
+    job.B = B;
+    if ((long long)A->nnz * B->cols < MATRIX_PARALLEL_WORK || (threads = matrix_pool_size()) == 1)
+    {
+        csr_rows(&job, 0, C->rows);
+        return 0;
+    }
+    tasks = threads * 4;
+    job.rows_per_task = (C->rows + tasks - 1) / tasks;
+    tasks = (C->rows + job.rows_per_task - 1) / job.rows_per_task;
+    matrix_pool_run(csr_task, &job, tasks);
+    return 0;
+}
+
+// Entry (i, j) of C gathers row i of A at the rows where column j of B is nonzero
+int matrix_csc_spmm(Matrix *C, const Matrix *A, const MatrixCSC *B)
+{
+    int i, j, p;
+
+    if (A->cols != B->rows || C->rows != A->rows || C->cols != B->cols)
+        return -1;
+    for (i = 0; i < A->rows; i++)
+    {
+        const int *a = A->data + i * A->stride;
+        int *c = C->data + i * C->stride;
+        for (j = 0; j < B->cols; j++)
+        {
+            int sum = 0;
+            for (p = B->ptr[j]; p < B->ptr[j + 1]; p++)
+                sum += a[B->idx[p]] * B->val[p];
+            c[j] = sum;
+        }
+    }
+    return 0;
+}
+
+double matrix_density(const Matrix *m)
+{
+    if (m->rows <= 0 || m->cols <= 0)
+        return 0.0;
+    return (double)count_nonzeros(m) / ((double)m->rows * m->cols);
+}
+
+int matrix_multiply_auto(Matrix *C, const Matrix *A, const Matrix *B, MatrixArena *arena)
+{
+    MatrixScratch scratch;
+    unsigned char *buf;
+    int status, nnz;
+
+    if (B->rows != A->cols || C->rows != A->rows || C->cols != B->cols)
+        return -1;
+
+    // Tiny products are cheaper to multiply than to inspect
+    if ((long long)A->rows * A->cols * B->cols > MATRIX_SMALL_WORK)
+    {
+        nnz = count_nonzeros(A);
+        if (nnz <= MATRIX_SPARSE_DENSITY * A->rows * A->cols)
+        {
+            MatrixCSR s;
+            buf = (unsigned char *)matrix_scratch_begin(&scratch, arena, compressed_bytes(A->rows, nnz));
+            if (buf != NULL)
+            {
+                compressed_carve(buf, A->rows, nnz, &s.ptr, &s.idx, &s.val);
+                csr_fill(&s, A, nnz);
+                status = matrix_csr_spmm(C, &s, B);
+                matrix_scratch_end(&scratch);
+                return status;
+            }
+            matrix_scratch_end(&scratch);
+        }
+        else if ((nnz = count_nonzeros(B)) <= MATRIX_SPARSE_DENSITY * B->rows * B->cols)
+        {
+            MatrixCSC s;
+            buf = (unsigned char *)matrix_scratch_begin(&scratch, arena, compressed_bytes(B->cols, nnz));
+            if (buf != NULL)
+            {
+                compressed_carve(buf, B->cols, nnz, &s.ptr, &s.idx, &s.val);
+                csc_fill(&s, B, nnz);
+                status = matrix_csc_spmm(C, A, &s);
+                matrix_scratch_end(&scratch);
+                return status;
+            }
+            matrix_scratch_end(&scratch);
+        }
+    }
+    return matrix_gemm(C, A, B);
+}
@@ -0,0 +1,69 @@
+#ifndef MATRIX_SPARSE_H
+#define MATRIX_SPARSE_H
+
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// Operands with at most this fraction of nonzeros are multiplied through the
+// sparse kernels by matrix_multiply_auto(). Below roughly 10% the saved
+// multiplies outweigh the indirect loads of the compressed formats.
+#define MATRIX_SPARSE_DENSITY 0.10
+
+// Compressed sparse row: the nonzeros of row i are val[ptr[i] .. ptr[i+1]-1]
+// with their column numbers in idx. Storage is O(rows + nnz).
+typedef struct
+{
+    int rows;
+    int cols;
+    int nnz;
+    int *ptr; // rows + 1 entries
+    int *idx; // column of each nonzero
+    int *val;
+} MatrixCSR;
+
+// Compressed sparse column: the nonzeros of column j are val[ptr[j] .. ptr[j+1]-1]
+// with their row numbers in idx. Storage is O(cols + nnz).
+typedef struct
+{
+    int rows;
+    int cols;
+    int nnz;
+    int *ptr; // cols + 1 entries
+    int *idx; // row of each nonzero
+    int *val;
+} MatrixCSC;
+
+// Builders return 0 on success, -1 on bad arguments or allocation failure.
+// The triplet builders never touch a dense rows x cols array; duplicate
+// (row, col) entries are kept and add up in every kernel. With a NULL 'arena'
+// the arrays come from the heap and go back with *_free(); otherwise they are
+// one block of the arena and go back with it, and *_free() must not be called.
+int matrix_csr_from_dense(MatrixCSR *s, const Matrix *m, MatrixArena *arena);
+int matrix_csr_from_triplets(MatrixCSR *s, int rows, int cols, int nnz,
+                             const int *row, const int *col, const int *val, MatrixArena *arena);
+int matrix_csc_from_dense(MatrixCSC *s, const Matrix *m, MatrixArena *arena);
+int matrix_csc_from_triplets(MatrixCSC *s, int rows, int cols, int nnz,
+                             const int *row, const int *col, const int *val, MatrixArena *arena);
+void matrix_csr_free(MatrixCSR *s);
+void matrix_csc_free(MatrixCSC *s);
+
+// Expands into a zeroed-then-filled dense matrix of the same shape
+int matrix_csr_to_dense(Matrix *m, const MatrixCSR *s);
+
+// y = A x
+int matrix_csr_spmv(int *y, const MatrixCSR *A, const int *x);
+int matrix_csc_spmv(int *y, const MatrixCSC *A, const int *x);
+
+// C = A * B with one sparse and one dense operand
+int matrix_csr_spmm(Matrix *C, const MatrixCSR *A, const Matrix *B);
+int matrix_csc_spmm(Matrix *C, const Matrix *A, const MatrixCSC *B);
+
+// Fraction of nonzero entries in m
+double matrix_density(const Matrix *m);
+
+// C = A * B, routed by operand density: a sparse A goes through CSR SpMM, a
+// sparse B through CSC SpMM, anything else through matrix_gemm(). The
+// compressed copy comes from 'arena' (NULL uses a temporary one).
+int matrix_multiply_auto(Matrix *C, const Matrix *A, const Matrix *B, MatrixArena *arena);
+
+#endif // MATRIX_SPARSE_H
@@ -0,0 +1,177 @@
+#include "matrix_strassen.h"
+
+// Z = X + Y or X - Y. Unsigned arithmetic wraps on overflow exactly like
+// the int products, and the loops are left to the vectorizer.
+static void add(Matrix *Z, const Matrix *X, const Matrix *Y)
+{
+    int i, j;
+    for (i = 0; i < Z->rows; i++)
+    {
+        const unsigned *x = (const unsigned *)X->data + (size_t)i * X->stride;
+        const unsigned *y = (const unsigned *)Y->data + (size_t)i * Y->stride;
+        int *z = Z->data + (size_t)i * Z->stride;
+        for (j = 0; j < Z->cols; j++)
+            z[j] = (int)(x[j] + y[j]);
+    }
+}
+
+static void sub(Matrix *Z, const Matrix *X, const Matrix *Y)
+{
+    int i, j;
+    for (i = 0; i < Z->rows; i++)
+    {
+        const unsigned *x = (const unsigned *)X->data + (size_t)i * X->stride;
+        const unsigned *y = (const unsigned *)Y->data + (size_t)i * Y->stride;
+        int *z = Z->data + (size_t)i * Z->stride;
+        for (j = 0; j < Z->cols; j++)
+            z[j] = (int)(x[j] - y[j]);
+    }
+}
+
+static void quadrants(const Matrix *m, int h, Matrix q[4])
+{
+    matrix_submatrix(&q[0], m, 0, 0, h, h);
+    matrix_submatrix(&q[1], m, 0, h, h, h);
+    matrix_submatrix(&q[2], m, h, 0, h, h);
+    matrix_submatrix(&q[3], m, h, h, h, h);
+}
+
+size_t matrix_strassen_scratch(int n, int crossover)
+{
+    size_t bytes = 0;
+
+    if (crossover <= 0)
+        crossover = MATRIX_STRASSEN_CROSSOVER;
+    while (n > crossover && n > 1)
+    {
+        n /= 2; // odd orders recurse on n - 1
+        bytes += 2 * matrix_arena_footprint((size_t)n * n * sizeof(int));
+    }
+    return bytes;
+}
+
+static int strassen(Matrix *C, const Matrix *A, const Matrix *B, int crossover, MatrixArena *arena);
+
+// Winograd's form with two temporaries, in the order of Boyer, Dumas, Pernet
+// and Zhou, "Memory efficient scheduling of Strassen-Winograd's matrix
+// multiplication algorithm" (ISSAC 2009). X holds the A-side sums and Y the
+// B-side sums; the four quadrants of C take the seven products and the
+// partial results:
+//   S1 = A21 + A22   S2 = S1 - A11   S3 = A11 - A21   S4 = A12 - S2
+//   T1 = B12 - B11   T2 = B22 - T1   T3 = B22 - B12   T4 = T2 - B21
+//   P1 = A11 B11  P2 = A12 B21  P3 = S4 B22  P4 = A22 T4
+//   P5 = S1 T1    P6 = S2 T2    P7 = S3 T3
+//   C11 = P1 + P2            C12 = P1 + P6 + P5 + P3
+//   C21 = P1 + P6 + P7 - P4  C22 = P1 + P6 + P7 + P5
+static int winograd(Matrix *C, const Matrix *A, const Matrix *B, int h, int crossover, MatrixArena *arena)
+{
+    Matrix a[4], b[4], c[4], X, Y;
+    size_t mark = matrix_arena_mark(arena);
+    int status = 0;
+
+    if (matrix_arena_matrix(arena, &X, h, h) != 0 || matrix_arena_matrix(arena, &Y, h, h) != 0)
+    {
+        matrix_arena_release(arena, mark);
+        return -1;
+    }
+    quadrants(A, h, a);
+    quadrants(B, h, b);
+    quadrants(C, h, c);
+
+    sub(&X, &a[0], &a[2]); // S3
+    sub(&Y, &b[3], &b[1]); // T3
+    status |= strassen(&c[2], &X, &Y, crossover, arena); // C21 = P7
+    add(&X, &a[2], &a[3]); // S1
+    sub(&Y, &b[1], &b[0]); // T1
+    status |= strassen(&c[3], &X, &Y, crossover, arena); // C22 = P5
+    sub(&X, &X, &a[0]);    // S2
+    sub(&Y, &b[3], &Y);    // T2
+    status |= strassen(&c[1], &X, &Y, crossover, arena); // C12 = P6
+    sub(&X, &a[1], &X);    // S4
+    status |= strassen(&c[0], &X, &b[3], crossover, arena); // C11 = P3
+    status |= strassen(&X, &a[0], &b[0], crossover, arena); // X = P1
+    add(&c[1], &X, &c[1]);    // C12 = P1 + P6
+    add(&c[2], &c[1], &c[2]); // C21 = P1 + P6 + P7
+    add(&c[1], &c[1], &c[3]); // C12 = P1 + P6 + P5
+    add(&c[3], &c[2], &c[3]); // C22 done
+    add(&c[1], &c[1], &c[0]); // C12 done
+    sub(&Y, &Y, &b[2]);       // T4
+    status |= strassen(&c[0], &a[3], &Y, crossover, arena); // C11 = P4
+    sub(&c[2], &c[2], &c[0]); // C21 done
+    status |= strassen(&c[0], &a[1], &b[2], crossover, arena); // C11 = P2
+    add(&c[0], &X, &c[0]);    // C11 done
+
+    matrix_arena_release(arena, mark);
+    return status ? -1 : 0;
+}
+
+static int strassen(Matrix *C, const Matrix *A, const Matrix *B, int crossover, MatrixArena *arena)
+{
+    Matrix a, b, c, a_col, b_row, c_col, a_row, b_left, c_row;
+    int n = A->rows, m;
+
+    if (n <= crossover || n < 2)
+        return matrix_gemm(C, A, B);
+    if ((n & 1) == 0)
+        return winograd(C, A, B, n / 2, crossover, arena);
+
+    // Odd order: the leading (n-1) x (n-1) block recurses, then
+    //   C[0:m, 0:m] += A[0:m, m] * B[m, 0:m]   (rank one)
+    //   C[0:n, m]    = A * B[0:n, m]            (last column)
+    //   C[m, 0:m]    = A[m, 0:n] * B[0:n, 0:m]  (last row)
+    m = n - 1;
+    matrix_submatrix(&a, A, 0, 0, m, m);
+    matrix_submatrix(&b, B, 0, 0, m, m);
+    matrix_submatrix(&c, C, 0, 0, m, m);
+    if (winograd(&c, &a, &b, m / 2, crossover, arena) != 0)
+        return -1;
+    matrix_submatrix(&a_col, A, 0, m, m, 1);
+    matrix_submatrix(&b_row, B, m, 0, 1, m);
+    matrix_submatrix(&c_col, C, 0, m, n, 1);
+    matrix_submatrix(&b, B, 0, m, n, 1);
+    matrix_submatrix(&a_row, A, m, 0, 1, n);
+    matrix_submatrix(&b_left, B, 0, 0, n, m);
+    matrix_submatrix(&c_row, C, m, 0, 1, m);
+    if (matrix_gemm_ex(&c, 1, &a_col, 0, &b_row, 0, 1) != 0 || matrix_gemm(&c_col, A, &b) != 0 ||
+        matrix_gemm(&c_row, &a_row, &b_left) != 0)
+        return -1;
+    return 0;
+}
+
+int matrix_strassen(Matrix *C, const Matrix *A, const Matrix *B, int crossover, MatrixArena *arena)
+{
+    MatrixArena local;
+    size_t mark = 0, bytes;
+    int n = A->rows, status;
+
+    if (A->cols != n || B->rows != n || B->cols != n || C->rows != n || C->cols != n)
+        return -1;
+    if (crossover <= 0)
+        crossover = MATRIX_STRASSEN_CROSSOVER;
+    if (n <= crossover)
+        return matrix_gemm(C, A, B);
+
+    // Every level carves its temporaries from the one reservation and rolls
+    // back to its own mark, so the heap is touched at most once
+    bytes = matrix_strassen_scratch(n, crossover);
+    if (arena == NULL)
+    {
+        arena = &local;
+        if (matrix_arena_init(arena, bytes) != 0)
+            return -1;
+    }
+    else
+    {
+        mark = matrix_arena_mark(arena);
+        // reserve() only grows an empty arena
+        if (arena->capacity - arena->used < bytes &&
+            (arena->used != 0 || matrix_arena_reserve(arena, bytes) != 0))
+            return -1;
+    }
+    status = strassen(C, A, B, crossover, arena);
+    if (arena == &local)
+        matrix_arena_destroy(arena);
+    else
+        matrix_arena_release(arena, mark);
+    return status;
+}
@@ -0,0 +1,31 @@
+#ifndef MATRIX_STRASSEN_H
+#define MATRIX_STRASSEN_H
+
+#include <stddef.h>
+#include "matrix.h"
+#include "matrix_arena.h"
+
+// C = A * B for square n x n operands by the Strassen-Winograd recursion:
+// seven half-size products and fifteen additions per level instead of eight
+// products, about O(n^2.81) overall. Levels stop once the order is at or
+// below 'crossover', where the packed matrix_gemm() is faster than another
+// round of additions; 0 uses MATRIX_STRASSEN_CROSSOVER. Odd orders peel the
+// last row and column off and fix them up with matrix_gemm_ex().
+//
+// Each level needs two half-size temporaries and the four quadrants of C
+// hold the rest, so the whole recursion fits in matrix_strassen_scratch()
+// bytes, taken from 'arena' in one piece (NULL uses a temporary arena). The
+// arena must have that much free or be empty so it can grow.
+// Arithmetic wraps like matrix_gemm(), so results are identical to it.
+// C must not overlap A or B. Returns 0 on success, -1 on non-square or
+// mismatched shapes or allocation failure.
+int matrix_strassen(Matrix *C, const Matrix *A, const Matrix *B, int crossover, MatrixArena *arena);
+
+// Arena bytes matrix_strassen() needs for order n and the given crossover
+size_t matrix_strassen_scratch(int n, int crossover);
+
+// Default crossover order, from bench_strassen on an x86 host; run it on the
+// HPS and pass the order it reports to tune the Cortex-A9
+#define MATRIX_STRASSEN_CROSSOVER 256
+
+#endif // MATRIX_STRASSEN_H
@@ -0,0 +1,360 @@
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix.h"
+#include "matrix_stream.h"
+
+// Jobs in circulation: enough to fill both queues with one more in each stage,
+// so the free list never runs dry while a stage is waiting on a full queue
+#define MATRIX_STREAM_JOBS (2 * MATRIX_STREAM_DEPTH + 3)
+
+void matrix_job_init(MatrixJob *job)
+{
+    memset(job, 0, sizeof(*job));
+}
+
+void matrix_job_free(MatrixJob *job)
+{
+    free(job->a);
+    free(job->b);
+    free(job->c);
+    matrix_job_init(job);
+}
+
+static int grow(int **buf, size_t *capacity, size_t entries)
+{
+    int *p;
+
+    if (entries <= *capacity)
+        return 0;
+    p = (int *)realloc(*buf, sizeof(int) * entries);
+    if (p == NULL)
+        return -1;
+    *buf = p;
+    *capacity = entries;
+    return 0;
+}
+
+int matrix_job_reserve(MatrixJob *job, int m, int k, int n)
+{
+    if (m <= 0 || k <= 0 || n <= 0 || m > MATRIX_STREAM_MAX_DIM || k > MATRIX_STREAM_MAX_DIM ||
+        n > MATRIX_STREAM_MAX_DIM || (long)m * k > MATRIX_STREAM_MAX_ELEMS ||
+        (long)k * n > MATRIX_STREAM_MAX_ELEMS || (long)m * n > MATRIX_STREAM_MAX_ELEMS)
+        return -1;
+    if (grow(&job->a, &job->capacity[0], (size_t)m * k) != 0 ||
+        grow(&job->b, &job->capacity[1], (size_t)k * n) != 0 ||
+        grow(&job->c, &job->capacity[2], (size_t)m * n) != 0)
+        return -1;
+    job->m = m;
+    job->k = k;
+    job->n = n;
+    return 0;
+}
+
+void matrix_job_run(MatrixJob *job)
+{
+    Matrix A, B, C;
+
+    matrix_view(&A, job->a, job->m, job->k, job->k);
+    matrix_view(&B, job->b, job->k, job->n, job->n);
+    matrix_view(&C, job->c, job->m, job->n, job->n);
+    job->status = matrix_gemm(&C, &A, &B);
+}
+
+int matrix_job_read_binary(FILE *in, MatrixJob *job)
+{
+    uint32_t dims[3];
+    size_t got = fread(dims, sizeof(uint32_t), 3, in);
+
+    if (got == 0 && feof(in))
+        return 0;
+    if (got != 3 || dims[0] > MATRIX_STREAM_MAX_DIM || dims[1] > MATRIX_STREAM_MAX_DIM ||
+        dims[2] > MATRIX_STREAM_MAX_DIM)
+        return -1;
+    if (matrix_job_reserve(job, (int)dims[0], (int)dims[1], (int)dims[2]) != 0)
+        return -1;
+    if (fread(job->a, sizeof(int), (size_t)job->m * job->k, in) != (size_t)job->m * job->k ||
+        fread(job->b, sizeof(int), (size_t)job->k * job->n, in) != (size_t)job->k * job->n)
+        return -1;
+    return 1;
+}
+
+// Next integer after whitespace and comments: 1, 0 at end of input, -1 on junk
+static int read_int(FILE *in, int *value)
+{
+    int ch;
+
+    for (;;)
+    {
+        ch = getc(in);
+        if (ch == '#')
+            while ((ch = getc(in)) != '\n' && ch != EOF)
+                ;
+        if (ch == EOF)
+            return 0;
+        if (!isspace(ch))
+            break;
+    }
+    ungetc(ch, in);
+    return fscanf(in, "%d", value) == 1 ? 1 : -1;
+}
+
+int matrix_job_read_text(FILE *in, MatrixJob *job)
+{
+    int m, k, n, status;
+    size_t i, count;
+
+    status = read_int(in, &m);
+    if (status <= 0)
+        return status;
+    if (read_int(in, &k) != 1 || read_int(in, &n) != 1 || matrix_job_reserve(job, m, k, n) != 0)
+        return -1;
+    count = (size_t)m * k;
+    for (i = 0; i < count; i++)
+        if (read_int(in, &job->a[i]) != 1)
+            return -1;
+    count = (size_t)k * n;
+    for (i = 0; i < count; i++)
+        if (read_int(in, &job->b[i]) != 1)
+            return -1;
+    return 1;
+}
+
+int matrix_job_write_binary(FILE *out, const MatrixJob *job)
+{
+    int32_t status = job->status;
+    uint32_t dims[2];
+
+    dims[0] = job->m;
+    dims[1] = job->n;
+    if (fwrite(&status, sizeof(status), 1, out) != 1 || fwrite(dims, sizeof(uint32_t), 2, out) != 2)
+        return -1;
+    if (job->status == 0 &&
+        fwrite(job->c, sizeof(int), (size_t)job->m * job->n, out) != (size_t)job->m * job->n)
+        return -1;
+    return 0;
+}
+
+int matrix_job_write_text(FILE *out, const MatrixJob *job)
+{
+    int i, j;
+
+    if (job->status != 0)
+        return fputs("error\n", out) == EOF ? -1 : 0;
+    fprintf(out, "%d %d\n", job->m, job->n);
+    for (i = 0; i < job->m; i++)
+    {
+        for (j = 0; j < job->n; j++)
+            fprintf(out, j + 1 < job->n ? "%d " : "%d\n", job->c[i * job->n + j]);
+    }
+    return ferror(out) ? -1 : 0;
+}
+
+// Bounded FIFO of jobs between two pipeline stages. A NULL job marks the end
+// of the stream.
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    MatrixJob *slots[MATRIX_STREAM_JOBS];
+    int capacity;
+    int head;
+    int count;
+} JobQueue;
+
+static void queue_init(JobQueue *q, int capacity)
+{
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    q->capacity = capacity;
+    q->head = 0;
+    q->count = 0;
+}
+
+static void queue_destroy(JobQueue *q)
+{
+    pthread_mutex_destroy(&q->lock);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+}
+
+static void queue_push(JobQueue *q, MatrixJob *job)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->capacity)
+        pthread_cond_wait(&q->not_full, &q->lock);
+    q->slots[(q->head + q->count++) % q->capacity] = job;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static MatrixJob *queue_pop(JobQueue *q)
+{
+    MatrixJob *job;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0)
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    job = q->slots[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+static int queue_empty(JobQueue *q)
+{
+    int empty;
+    pthread_mutex_lock(&q->lock);
+    empty = q->count == 0;
+    pthread_mutex_unlock(&q->lock);
+    return empty;
+}
+
+typedef struct
+{
+    FILE *out;
+    int binary;
+    JobQueue parsed;   // reader -> compute
+    JobQueue computed; // compute -> writer
+    JobQueue idle;     // writer -> reader
+    int write_failed;  // set by the writer, polled by the reader (__atomic)
+} Stream;
+
+static void *compute_main(void *arg)
+{
+    Stream *s = (Stream *)arg;
+    MatrixJob *job;
+
+    do
+    {
+        job = queue_pop(&s->parsed);
+        if (job != NULL)
+            matrix_job_run(job);
+        queue_push(&s->computed, job);
+    } while (job != NULL);
+    matrix_release_thread_buffers();
+    return NULL;
+}
+
+static void *writer_main(void *arg)
+{
+    Stream *s = (Stream *)arg;
+    MatrixJob *job;
+
+    while ((job = queue_pop(&s->computed)) != NULL)
+    {
+        if (!__atomic_load_n(&s->write_failed, __ATOMIC_RELAXED) &&
+            (s->binary ? matrix_job_write_binary(s->out, job) : matrix_job_write_text(s->out, job)) != 0)
+            __atomic_store_n(&s->write_failed, 1, __ATOMIC_RELAXED);
+        queue_push(&s->idle, job);
+
+        // Flush once nothing else is about to follow, so an interactive peer
+        // on a pipe sees each answer without a write per job under load
+        if (queue_empty(&s->computed))
+            fflush(s->out);
+    }
+    fflush(s->out);
+    return NULL;
+}
+
+int matrix_stream_run(FILE *in, FILE *out)
+{
+    Stream s;
+    MatrixJob jobs[MATRIX_STREAM_JOBS];
+    pthread_t compute, writer;
+    char magic[4];
+    int i, ch, status = 0, got;
+
+    // Text input starts with a digit, whitespace or a comment, never 'M'
+    ch = getc(in);
+    if (ch == EOF)
+        return 0;
+    ungetc(ch, in);
+    s.binary = ch == MATRIX_STREAM_MAGIC[0];
+    if (s.binary)
+    {
+        if (fread(magic, 1, 4, in) != 4 || memcmp(magic, MATRIX_STREAM_MAGIC, 4) != 0)
+            return -1;
+        if (fwrite(MATRIX_STREAM_RESULT_MAGIC, 1, 4, out) != 4)
+            return -1;
+    }
+
+    s.out = out;
+    s.write_failed = 0;
+    queue_init(&s.parsed, MATRIX_STREAM_DEPTH);
+    queue_init(&s.computed, MATRIX_STREAM_DEPTH);
+    queue_init(&s.idle, MATRIX_STREAM_JOBS);
+    for (i = 0; i < MATRIX_STREAM_JOBS; i++)
+    {
+        matrix_job_init(&jobs[i]);
+        queue_push(&s.idle, &jobs[i]);
+    }
+    if (pthread_create(&compute, NULL, compute_main, &s) != 0)
+        return -1;
+    if (pthread_create(&writer, NULL, writer_main, &s) != 0)
+    {
+        queue_push(&s.parsed, NULL);
+        pthread_join(compute, NULL);
+        return -1;
+    }
+
+    while (!__atomic_load_n(&s.write_failed, __ATOMIC_RELAXED))
+    {
+        MatrixJob *job = queue_pop(&s.idle);
+        got = s.binary ? matrix_job_read_binary(in, job) : matrix_job_read_text(in, job);
+        if (got <= 0)
+        {
+            queue_push(&s.idle, job);
+            status = got;
+            break;
+        }
+        queue_push(&s.parsed, job);
+    }
+
+    // Drain: the end marker passes through both stages behind the last job
+    queue_push(&s.parsed, NULL);
+    pthread_join(compute, NULL);
+    pthread_join(writer, NULL);
+    if (s.write_failed)
+        status = -1;
+
+    for (i = 0; i < MATRIX_STREAM_JOBS; i++)
+        matrix_job_free(&jobs[i]);
+    queue_destroy(&s.parsed);
+    queue_destroy(&s.computed);
+    queue_destroy(&s.idle);
+    return status;
+}
+
+int matrix_stream_main(int argc, char *argv[])
+{
+    FILE *in = stdin;
+    int status;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [file|-]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 2 && strcmp(argv[1], "-") != 0)
+    {
+        in = fopen(argv[1], "rb");
+        if (in == NULL)
+        {
+            fprintf(stderr, "Error: cannot open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    status = matrix_stream_run(in, stdout);
+    if (status != 0)
+        fprintf(stderr, "Error: malformed job stream or write failure\n");
+    if (in != stdin)
+        fclose(in);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#ifndef MATRIX_STREAM_H
+#define MATRIX_STREAM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Headless job stream: a sequence of products C = A * B read from a file or
+// pipe and answered in order, with no board I/O.
+//
+// Binary format (host byte order, int32 entries), detected by its magic:
+//   "MJOB", then per job: uint32 m, k, n; m*k entries of A; k*n entries of B
+//   answered by "MRES", then per job: int32 status, uint32 m, n; m*n entries
+//   of C when status is 0
+// Text fallback, whitespace separated with '#' comments to end of line:
+//   per job: m k n, then the entries of A and of B in row-major order
+//   answered per job by a line "m n" and m lines of C, or a line "error"
+#define MATRIX_STREAM_MAGIC "MJOB"
+#define MATRIX_STREAM_RESULT_MAGIC "MRES"
+
+// Largest accepted dimension and operand, so a corrupt header cannot demand
+// an unbounded allocation
+#define MATRIX_STREAM_MAX_DIM 4096
+#define MATRIX_STREAM_MAX_ELEMS (1 << 24)
+
+// Jobs each queue between the pipeline stages holds
+#define MATRIX_STREAM_DEPTH 8
+
+// One product with its own operand and result storage. Buffers only grow, so
+// a recycled job stops allocating once it has seen the largest shape.
+typedef struct
+{
+    int m;
+    int k;
+    int n;
+    int *a;
+    int *b;
+    int *c;
+    size_t capacity[3]; // entries allocated for a, b and c
+    int status;         // 0 or -1 from the product
+} MatrixJob;
+
+void matrix_job_init(MatrixJob *job);
+void matrix_job_free(MatrixJob *job);
+
+// Sizes the buffers for an m x k by k x n product; -1 on bad shapes or no memory
+int matrix_job_reserve(MatrixJob *job, int m, int k, int n);
+
+// Fills job->c and job->status
+void matrix_job_run(MatrixJob *job);
+
+// Read one job: 1 on success, 0 at a clean end of input, -1 on malformed or
+// truncated input. The binary reader expects the stream magic already consumed.
+int matrix_job_read_binary(FILE *in, MatrixJob *job);
+int matrix_job_read_text(FILE *in, MatrixJob *job);
+
+// Write one result; -1 on an output error
+int matrix_job_write_binary(FILE *out, const MatrixJob *job);
+int matrix_job_write_text(FILE *out, const MatrixJob *job);
+
+// Answers every job of 'in' on 'out' in input order, in the format of the
+// input. Parsing runs on the calling thread, products and output on two more,
+// with MATRIX_STREAM_DEPTH-job queues between them so a slow stage stalls the
+// ones feeding it instead of buffering without bound. Returns 0 when the
+// input ended cleanly, -1 on malformed input or an I/O error.
+int matrix_stream_run(FILE *in, FILE *out);
+
+// Command line front end: [file] with '-' or no argument for stdin
+int matrix_stream_main(int argc, char *argv[]);
+
+#endif // MATRIX_STREAM_H
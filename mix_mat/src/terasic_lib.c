@@ -1,4 +1,4 @@
-#include "terasic_os_includes.h"
+#include <time.h>
 #include "terasic_lib.h"
 
 
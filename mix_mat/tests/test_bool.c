@@ -0,0 +1,141 @@
+// Boolean products on both sides of the Four-Russians threshold and the
+// transitive closure, against a triple loop and Floyd-Warshall.
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrix_bool.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static void fill(MatrixBool *m, int percent)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            matrix_bool_set(m, i, j, rand() % 100 < percent);
+}
+
+static void test_multiply(int M, int K, int N, int percent)
+{
+    MatrixBool A, B, C;
+    MatrixArena arena;
+    int i, j, k, bad = 0, tail = 0;
+
+    matrix_bool_create(&A, M, K);
+    matrix_bool_create(&B, K, N);
+    matrix_bool_create(&C, M, N);
+    fill(&A, percent);
+    fill(&B, percent);
+    matrix_arena_init(&arena, 0);
+    CHECK(matrix_bool_multiply(&C, &A, &B, &arena) == 0);
+    CHECK(arena.used == 0);
+    for (i = 0; i < M; i++)
+    {
+        for (j = 0; j < N; j++)
+        {
+            int want = 0;
+            for (k = 0; k < K && !want; k++)
+                want = matrix_bool_get(&A, i, k) && matrix_bool_get(&B, k, j);
+            bad += matrix_bool_get(&C, i, j) != want;
+        }
+        // Bits past 'cols' must stay clear
+        if (N % 64)
+            tail |= (MATRIX_BOOL_ROW(&C, i)[C.words - 1] >> (N % 64)) != 0;
+    }
+    if (bad || tail)
+    {
+        fprintf(stderr, "%dx%dx%d at %d%%: %d wrong, tail %d\n", M, K, N, percent, bad, tail);
+        CHECK(0);
+    }
+    matrix_arena_destroy(&arena);
+    matrix_bool_free(&A);
+    matrix_bool_free(&B);
+    matrix_bool_free(&C);
+}
+
+static void test_closure(int n, int percent, int reflexive)
+{
+    MatrixBool A, R;
+    char *reach = (char *)malloc((size_t)n * n);
+    int i, j, k, bad = 0;
+
+    matrix_bool_create(&A, n, n);
+    matrix_bool_create(&R, n, n);
+    fill(&A, percent);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            reach[i * n + j] = (char)matrix_bool_get(&A, i, j);
+    for (k = 0; k < n; k++)
+        for (i = 0; i < n; i++)
+            if (reach[i * n + k])
+                for (j = 0; j < n; j++)
+                    reach[i * n + j] |= reach[k * n + j];
+    if (reflexive)
+        for (i = 0; i < n; i++)
+            reach[i * n + i] = 1;
+
+    CHECK(matrix_bool_closure(&R, &A, reflexive, NULL) == 0);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            bad += matrix_bool_get(&R, i, j) != reach[i * n + j];
+    // In place
+    CHECK(matrix_bool_closure(&A, &A, reflexive, NULL) == 0);
+    for (i = 0; i < n; i++)
+        for (j = 0; j < n; j++)
+            bad += matrix_bool_get(&A, i, j) != reach[i * n + j];
+    if (bad)
+    {
+        fprintf(stderr, "closure n %d at %d%% reflexive %d: %d wrong\n", n, percent, reflexive, bad);
+        CHECK(0);
+    }
+    matrix_bool_free(&A);
+    matrix_bool_free(&R);
+    free(reach);
+}
+
+static void test_chain(void)
+{
+    // 0 -> 1 -> ... -> 99: the closure needs every squaring
+    MatrixBool A;
+    int i;
+
+    matrix_bool_create(&A, 100, 100);
+    for (i = 0; i + 1 < 100; i++)
+        matrix_bool_set(&A, i, i + 1, 1);
+    CHECK(matrix_bool_closure(&A, &A, 0, NULL) == 0);
+    CHECK(matrix_bool_count(&A) == 99 * 100 / 2);
+    CHECK(matrix_bool_get(&A, 0, 99) && !matrix_bool_get(&A, 99, 0) && !matrix_bool_get(&A, 5, 5));
+    matrix_bool_free(&A);
+}
+
+int main(void)
+{
+    srand(1);
+    test_multiply(1, 1, 1, 100);
+    test_multiply(7, 65, 63, 30);
+    test_multiply(63, 64, 130, 5);
+    test_multiply(64, 64, 64, 5);
+    test_multiply(150, 200, 77, 2);
+    test_multiply(130, 9, 300, 50);
+    test_closure(50, 3, 0);
+    test_closure(130, 1, 0);
+    test_closure(130, 1, 1);
+    test_chain();
+    if (failures)
+    {
+        fprintf(stderr, "test_bool: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_bool: ok\n");
+    return 0;
+}
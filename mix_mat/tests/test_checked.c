@@ -0,0 +1,145 @@
+// matrix_gemm_checked(): path selection at the tier boundaries and exact
+// results or overflow reports right at the edges of the int range.
+#include <limits.h>
+#include <stdio.h>
+#include "matrix_checked.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+// C = A * B for a 1 x k row and a k x 1 column; returns the status
+static int dot(int *c, int *a, int *b, int k)
+{
+    Matrix A, B, C;
+
+    matrix_view(&A, a, 1, k, k);
+    matrix_view(&B, b, k, 1, 1);
+    matrix_view(&C, c, 1, 1, 1);
+    return matrix_gemm_checked(&C, &A, &B, NULL);
+}
+
+static void test_int_min(void)
+{
+    int a[1] = {-32768}, b[1] = {65536}, c;
+
+    // |C| bound is 2^31, one past INT_MAX, so this takes the int64 path
+    CHECK(dot(&c, a, b, 1) == 0 && c == INT_MIN);
+    a[0] = 32768;
+    CHECK(dot(&c, a, b, 1) == -1);
+}
+
+static void test_46341(void)
+{
+    int a[2] = {46340, 0}, b[2] = {46340, 0}, c;
+
+    CHECK(dot(&c, a, b, 1) == 0 && c == 2147395600);
+    a[0] = b[0] = 46341;
+    CHECK(dot(&c, a, b, 1) == -1);
+    a[0] = -46341;
+    CHECK(dot(&c, a, b, 1) == -1);
+    // Each term overflows on its own but the sum is zero
+    a[1] = 46341;
+    b[1] = 46341;
+    CHECK(dot(&c, a, b, 2) == 0 && c == 0);
+}
+
+static void test_split_path(void)
+{
+    // Products near 2^62 push the bound past INT64_MAX, so the terms are
+    // summed as split high and low words
+    int a[5] = {INT_MIN, INT_MIN, INT_MIN, INT_MIN, INT_MIN};
+    int b[5] = {INT_MIN, INT_MAX, INT_MIN, INT_MAX, 2};
+    int c = 1;
+
+    CHECK(dot(&c, a, b, 5) == 0 && c == 0);
+    b[4] = 3;
+    CHECK(dot(&c, a, b, 5) == 0 && c == INT_MIN);
+    b[4] = 1;
+    CHECK(dot(&c, a, b, 5) == -1);
+}
+
+static void fill(Matrix *m, int v)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = (i + j) & 1 ? -v : v;
+}
+
+static void test_tiers(void)
+{
+    Matrix A, B, C, R;
+    int i, same = 1;
+
+    matrix_create(&A, 32, 2);
+    matrix_create(&B, 2, 32);
+    matrix_create(&C, 32, 32);
+    matrix_create(&R, 32, 32);
+
+    // 2 * 32767^2 fits int: int16 operands and both dimensions large enough
+    fill(&A, 32767);
+    fill(&B, 32767);
+    CHECK(matrix_acc_select(&A, &B, NULL) == MATRIX_ACC_S16);
+    CHECK(matrix_gemm_checked(&C, &A, &B, NULL) == 0);
+    matrix_gemm(&R, &A, &B);
+    for (i = 0; i < 32 * 32; i++)
+        same &= C.data[i] == R.data[i];
+    CHECK(same);
+
+    // Too few rows to pay for the narrowing
+    A.rows = 31;
+    CHECK(matrix_acc_select(&A, &B, NULL) == MATRIX_ACC_S32);
+    A.rows = 32;
+
+    // -32768 has no int16 magnitude
+    MAT_AT(&A, 0, 0) = -32768;
+    MAT_AT(&B, 0, 0) = 1;
+    CHECK(matrix_acc_select(&A, &B, NULL) == MATRIX_ACC_S32);
+
+    // C(1, 0) = -32767 * 40000 - 32767^2 leaves int
+    MAT_AT(&B, 0, 0) = 40000;
+    CHECK(matrix_acc_select(&A, &B, NULL) == MATRIX_ACC_S64);
+    CHECK(matrix_gemm_checked(&C, &A, &B, NULL) == -1);
+
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&C);
+    matrix_free(&R);
+}
+
+static void test_demo(void)
+{
+    int a[4] = {1, 2, 3, 4}, b[4] = {5, 6, 7, 8}, c[4];
+
+    CHECK(matrix_multiplication_checked(c, a, b) == 0);
+    CHECK(c[0] == 19 && c[1] == 22 && c[2] == 43 && c[3] == 50);
+    a[0] = 65536;
+    b[0] = 32768;
+    CHECK(matrix_multiplication_checked(c, a, b) == -1);
+}
+
+int main(void)
+{
+    test_int_min();
+    test_46341();
+    test_split_path();
+    test_tiers();
+    test_demo();
+    if (failures)
+    {
+        fprintf(stderr, "test_checked: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_checked: ok\n");
+    return 0;
+}
@@ -0,0 +1,238 @@
+// Expression evaluation against the same sums and products formed term by
+// term, including outputs that alias the operands.
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrix_expr.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static void fill(Matrix *m)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = rand() % 19 - 9;
+}
+
+static int same(const Matrix *a, const Matrix *b)
+{
+    int i, j;
+
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            if (MAT_AT(a, i, j) != MAT_AT(b, i, j))
+                return 0;
+    return 1;
+}
+
+// C = alpha * op(A) * op(B) + beta * C with a triple loop
+static void ref_gemm(Matrix *C, int alpha, const Matrix *A, int ta, const Matrix *B, int tb, int beta)
+{
+    int k_len = ta ? A->rows : A->cols, i, j, k;
+
+    for (i = 0; i < C->rows; i++)
+    {
+        for (j = 0; j < C->cols; j++)
+        {
+            int sum = 0;
+            for (k = 0; k < k_len; k++)
+                sum += (ta ? MAT_AT(A, k, i) : MAT_AT(A, i, k)) * (tb ? MAT_AT(B, j, k) : MAT_AT(B, k, j));
+            MAT_AT(C, i, j) = alpha * sum + beta * MAT_AT(C, i, j);
+        }
+    }
+}
+
+// C = alpha * op(A) + beta * C
+static void ref_axpy(Matrix *C, int alpha, const Matrix *A, int ta, int beta)
+{
+    int i, j;
+
+    for (i = 0; i < C->rows; i++)
+        for (j = 0; j < C->cols; j++)
+            MAT_AT(C, i, j) = alpha * (ta ? MAT_AT(A, j, i) : MAT_AT(A, i, j)) + beta * MAT_AT(C, i, j);
+}
+
+static void test_forms(int m, int k, int n, MatrixArena *arena)
+{
+    Matrix A, B, C, At, out, want, tmp;
+    const MatrixExpr *a, *b, *c, *e;
+    size_t mark = matrix_arena_mark(arena);
+
+    matrix_create(&A, m, k);
+    matrix_create(&B, k, n);
+    matrix_create(&C, m, n);
+    matrix_create(&At, k, m);
+    matrix_create(&out, m, n);
+    matrix_create(&want, m, n);
+    fill(&A);
+    fill(&B);
+    fill(&C);
+    fill(&At);
+    a = matrix_expr_leaf(arena, &A);
+    b = matrix_expr_leaf(arena, &B);
+    c = matrix_expr_leaf(arena, &C);
+
+    // 3 * A * B - 2 * C
+    e = matrix_expr_sub(arena, matrix_expr_scale(arena, 3, matrix_expr_mul(arena, a, b)),
+                        matrix_expr_scale(arena, 2, c));
+    matrix_copy(&want, &C);
+    ref_gemm(&want, 3, &A, 0, &B, 0, -2);
+    CHECK(matrix_expr_eval(&out, e, arena) == 0 && same(&out, &want));
+    CHECK(matrix_expr_eval(&out, e, NULL) == 0 && same(&out, &want));
+
+    // (At^T * B)^T^T + C, through the transpose of a product
+    e = matrix_expr_add(arena,
+                        matrix_expr_transpose(arena, matrix_expr_transpose(arena,
+                            matrix_expr_mul(arena, matrix_expr_transpose(arena, matrix_expr_leaf(arena, &At)), b))),
+                        c);
+    matrix_copy(&want, &C);
+    ref_gemm(&want, 1, &At, 1, &B, 0, 1);
+    CHECK(matrix_expr_eval(&out, e, arena) == 0 && same(&out, &want));
+
+    // (A * B)^T into an n x m output
+    matrix_create(&tmp, n, m);
+    e = matrix_expr_transpose(arena, matrix_expr_mul(arena, a, b));
+    CHECK(matrix_expr_eval(&tmp, e, arena) == 0);
+    matrix_zero(&want);
+    ref_gemm(&want, 1, &A, 0, &B, 0, 0);
+    {
+        int i, j, ok = 1;
+        for (i = 0; i < m; i++)
+            for (j = 0; j < n; j++)
+                ok &= MAT_AT(&tmp, j, i) == MAT_AT(&want, i, j);
+        CHECK(ok);
+    }
+    matrix_free(&tmp);
+
+    // (A + A) * (B - 2 B): sums as product operands are materialized
+    e = matrix_expr_mul(arena, matrix_expr_add(arena, a, a),
+                        matrix_expr_sub(arena, b, matrix_expr_scale(arena, 2, b)));
+    ref_gemm(&want, -2, &A, 0, &B, 0, 0);
+    CHECK(matrix_expr_eval(&out, e, arena) == 0 && same(&out, &want));
+
+    matrix_arena_release(arena, mark);
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&C);
+    matrix_free(&At);
+    matrix_free(&out);
+    matrix_free(&want);
+}
+
+// Outputs sharing storage with a leaf or a product operand
+static void test_aliasing(int n, MatrixArena *arena)
+{
+    Matrix buf, A, B, X, Xold, want;
+    const MatrixExpr *a, *b, *x, *e;
+    size_t mark = matrix_arena_mark(arena);
+
+    matrix_create(&buf, n + 2, n);
+    matrix_create(&B, n, n);
+    matrix_create(&Xold, n, n);
+    matrix_create(&want, n, n);
+    fill(&buf);
+    fill(&B);
+    matrix_submatrix(&X, &buf, 1, 0, n, n);
+    b = matrix_expr_leaf(arena, &B);
+    x = matrix_expr_leaf(arena, &X);
+
+    // X = B + X: X is a later leaf term
+    matrix_copy(&Xold, &X);
+    matrix_copy(&want, &Xold);
+    ref_axpy(&want, 1, &B, 0, 1);
+    CHECK(matrix_expr_eval(&X, matrix_expr_add(arena, b, x), arena) == 0 && same(&X, &want));
+
+    // X = 2 X - B^T: X itself first is used in place
+    matrix_copy(&Xold, &X);
+    matrix_copy(&want, &B);
+    ref_axpy(&want, 2, &Xold, 0, 0);
+    ref_axpy(&want, -1, &B, 1, 1);
+    e = matrix_expr_sub(arena, matrix_expr_scale(arena, 2, x), matrix_expr_transpose(arena, b));
+    CHECK(matrix_expr_eval(&X, e, arena) == 0 && same(&X, &want));
+
+    // X = X^T + X
+    matrix_copy(&Xold, &X);
+    matrix_copy(&want, &Xold);
+    ref_axpy(&want, 1, &Xold, 1, 1);
+    CHECK(matrix_expr_eval(&X, matrix_expr_add(arena, matrix_expr_transpose(arena, x), x), arena) == 0 &&
+          same(&X, &want));
+
+    // X = B + A with A one row above X in the same buffer, and below it
+    matrix_submatrix(&A, &buf, 0, 0, n, n);
+    matrix_copy(&want, &A);
+    ref_axpy(&want, 1, &B, 0, 1);
+    a = matrix_expr_leaf(arena, &A);
+    CHECK(matrix_expr_eval(&X, matrix_expr_add(arena, b, a), arena) == 0 && same(&X, &want));
+    matrix_submatrix(&A, &buf, 2, 0, n, n);
+    matrix_copy(&want, &A);
+    ref_axpy(&want, 1, &B, 0, 1);
+    CHECK(matrix_expr_eval(&X, matrix_expr_add(arena, b, a), arena) == 0 && same(&X, &want));
+
+    // X = X * B + X
+    matrix_copy(&Xold, &X);
+    matrix_copy(&want, &Xold);
+    ref_gemm(&want, 1, &Xold, 0, &B, 0, 1);
+    CHECK(matrix_expr_eval(&X, matrix_expr_add(arena, matrix_expr_mul(arena, x, b), x), arena) == 0 &&
+          same(&X, &want));
+
+    matrix_arena_release(arena, mark);
+    matrix_free(&buf);
+    matrix_free(&B);
+    matrix_free(&Xold);
+    matrix_free(&want);
+}
+
+static void test_errors(MatrixArena *arena)
+{
+    Matrix A, B, out;
+    const MatrixExpr *a, *b;
+
+    matrix_create(&A, 3, 4);
+    matrix_create(&B, 3, 4);
+    matrix_create(&out, 3, 4);
+    a = matrix_expr_leaf(arena, &A);
+    b = matrix_expr_leaf(arena, &B);
+    CHECK(matrix_expr_mul(arena, a, b) == NULL);
+    CHECK(matrix_expr_add(arena, a, matrix_expr_transpose(arena, b)) == NULL);
+    CHECK(matrix_expr_eval(&out, matrix_expr_mul(arena, a, b), arena) == -1);
+    CHECK(matrix_expr_eval(&out, matrix_expr_transpose(arena, a), arena) == -1);
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&out);
+}
+
+int main(void)
+{
+    static const int shapes[][3] = {{1, 1, 1}, {3, 5, 2}, {17, 9, 33}, {64, 64, 64}, {70, 130, 45}};
+    MatrixArena arena;
+    int i;
+
+    srand(1);
+    if (matrix_arena_init(&arena, 4 << 20) != 0)
+        return 1;
+    for (i = 0; i < (int)(sizeof(shapes) / sizeof(shapes[0])); i++)
+    {
+        test_forms(shapes[i][0], shapes[i][1], shapes[i][2], &arena);
+        test_aliasing(shapes[i][0], &arena);
+    }
+    test_errors(&arena);
+    matrix_arena_destroy(&arena);
+    if (failures)
+    {
+        fprintf(stderr, "test_expr: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_expr: ok\n");
+    return 0;
+}
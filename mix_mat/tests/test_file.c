@@ -0,0 +1,198 @@
+// Tiled matrix files: store/load round trips, the out-of-core product against
+// matrix_gemm() and the header and mode checks.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "matrix_file.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static char paths[3][32];
+
+static void fill(Matrix *m)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = rand() % 201 - 100;
+}
+
+static int same(const Matrix *a, const Matrix *b)
+{
+    int i, j;
+
+    for (i = 0; i < a->rows; i++)
+        for (j = 0; j < a->cols; j++)
+            if (MAT_AT(a, i, j) != MAT_AT(b, i, j))
+                return 0;
+    return 1;
+}
+
+// Writes m to a new file at 'path' and closes it
+static int save(const char *path, const Matrix *m, int tile)
+{
+    MatrixFile f;
+
+    if (matrix_file_create(&f, path, m->rows, m->cols, tile) != 0)
+        return -1;
+    if (matrix_file_store(&f, m) != 0)
+    {
+        matrix_file_close(&f);
+        return -1;
+    }
+    return matrix_file_close(&f);
+}
+
+static void test_round_trip(int rows, int cols, int tile)
+{
+    Matrix m, back;
+    MatrixFile f;
+
+    matrix_create(&m, rows, cols);
+    matrix_create(&back, rows, cols);
+    fill(&m);
+    CHECK(save(paths[0], &m, tile) == 0);
+    CHECK(matrix_file_open(&f, paths[0], 0) == 0);
+    CHECK(f.rows == rows && f.cols == cols && f.tile == tile);
+    CHECK(matrix_file_load(&back, &f) == 0 && same(&m, &back));
+    // A read-only file takes no stores
+    CHECK(matrix_file_store(&f, &m) == -1);
+    matrix_file_close(&f);
+    matrix_free(&m);
+    matrix_free(&back);
+}
+
+static void test_gemm(int m, int k, int n, int tile)
+{
+    Matrix A, B, C, want;
+    MatrixFile fa, fb, fc;
+
+    matrix_create(&A, m, k);
+    matrix_create(&B, k, n);
+    matrix_create(&C, m, n);
+    matrix_create(&want, m, n);
+    fill(&A);
+    fill(&B);
+    CHECK(matrix_gemm(&want, &A, &B) == 0);
+    CHECK(save(paths[0], &A, tile) == 0 && save(paths[1], &B, tile) == 0);
+    CHECK(matrix_file_open(&fa, paths[0], 0) == 0 && matrix_file_open(&fb, paths[1], 0) == 0);
+    CHECK(matrix_file_create(&fc, paths[2], m, n, tile) == 0);
+    CHECK(matrix_file_gemm(&fc, &fa, &fb) == 0);
+    CHECK(matrix_file_close(&fc) == 0);
+    CHECK(matrix_file_open(&fc, paths[2], 0) == 0);
+    CHECK(matrix_file_load(&C, &fc) == 0 && same(&C, &want));
+    // Read-only C and swapped operands are rejected
+    CHECK(matrix_file_gemm(&fc, &fa, &fb) == -1);
+    matrix_file_close(&fc);
+    if (m != n)
+    {
+        CHECK(matrix_file_create(&fc, paths[2], m, n, tile) == 0);
+        CHECK(matrix_file_gemm(&fc, &fb, &fa) == -1);
+        matrix_file_close(&fc);
+    }
+    matrix_file_close(&fa);
+    matrix_file_close(&fb);
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&C);
+    matrix_free(&want);
+}
+
+static void test_mismatch(void)
+{
+    Matrix A;
+    MatrixFile fa, fb, fc;
+
+    matrix_create(&A, 40, 40);
+    fill(&A);
+    CHECK(save(paths[0], &A, 32) == 0 && save(paths[1], &A, 64) == 0);
+    CHECK(matrix_file_open(&fa, paths[0], 0) == 0 && matrix_file_open(&fb, paths[1], 0) == 0);
+    CHECK(matrix_file_create(&fc, paths[2], 40, 40, 32) == 0);
+    CHECK(matrix_file_gemm(&fc, &fa, &fb) == -1);
+    matrix_file_close(&fa);
+    matrix_file_close(&fb);
+    matrix_file_close(&fc);
+    CHECK(matrix_file_create(&fc, paths[2], 40, 40, 48) == -1);
+    CHECK(matrix_file_create(&fc, paths[2], 0, 40, 32) == -1);
+    matrix_free(&A);
+}
+
+static void test_bad_header(void)
+{
+    Matrix A;
+    MatrixFile f;
+    MatrixFileHeader h;
+    FILE *fp;
+
+    matrix_create(&A, 10, 10);
+    fill(&A);
+    CHECK(save(paths[0], &A, 32) == 0);
+
+    // Wrong magic
+    fp = fopen(paths[0], "r+b");
+    CHECK(fp != NULL && fread(&h, sizeof(h), 1, fp) == 1);
+    h.magic[0] ^= 1;
+    rewind(fp);
+    CHECK(fwrite(&h, sizeof(h), 1, fp) == 1);
+    fclose(fp);
+    CHECK(matrix_file_open(&f, paths[0], 0) == -1);
+
+    // Header promising more tiles than the file holds
+    h.magic[0] ^= 1;
+    h.rows = 1000;
+    fp = fopen(paths[0], "r+b");
+    CHECK(fp != NULL && fwrite(&h, sizeof(h), 1, fp) == 1);
+    fclose(fp);
+    CHECK(matrix_file_open(&f, paths[0], 0) == -1);
+
+    // Truncated inside the header
+    CHECK(truncate(paths[0], 16) == 0);
+    CHECK(matrix_file_open(&f, paths[0], 0) == -1);
+    CHECK(matrix_file_open(&f, "/nonexistent/matrix.mat", 0) == -1);
+    matrix_free(&A);
+}
+
+int main(void)
+{
+    int i, fd;
+
+    srand(1);
+    for (i = 0; i < 3; i++)
+    {
+        strcpy(paths[i], "/tmp/test_file_XXXXXX");
+        if ((fd = mkstemp(paths[i])) < 0)
+            return 1;
+        close(fd);
+    }
+    test_round_trip(1, 1, 32);
+    test_round_trip(32, 32, 32);
+    test_round_trip(70, 100, 32);
+    test_round_trip(300, 257, MATRIX_FILE_TILE);
+    test_gemm(1, 1, 1, 32);
+    test_gemm(64, 64, 64, 32);
+    test_gemm(70, 45, 100, 32);
+    test_gemm(130, 200, 90, 64);
+    test_mismatch();
+    test_bad_header();
+    for (i = 0; i < 3; i++)
+        unlink(paths[i]);
+    if (failures)
+    {
+        fprintf(stderr, "test_file: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_file: ok\n");
+    return 0;
+}
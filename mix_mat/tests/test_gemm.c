@@ -0,0 +1,300 @@
+// The packed GEMM drivers against a triple loop: every kernel set this CPU
+// supports, edge sizes that are not multiples of MR/NR/MC/KC/NC, strided
+// views, transposes, alpha and accumulation, on the worker pool too.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix.h"
+#include "matrix_kernels.h"
+#include "matrix_pool.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+// Extra columns past every view, filled with GUARD to catch stray stores
+#define PAD 3
+#define GUARD 0x7EADBEEF
+
+static const int shapes[][3] = {
+    {1, 1, 1},     {2, 2, 2},     {3, 5, 7},      {4, 8, 8},      {5, 9, 13},
+    {63, 65, 67}, {65, 257, 259}, {130, 300, 17}, {17, 3, 300},   {200, 200, 200},
+};
+
+static const char *kernel_sets[] = {"scalar", "sse2", "avx2", "neon"};
+
+static int *alloc_view(Matrix *m, int rows, int cols)
+{
+    int i, *data = (int *)malloc(sizeof(int) * rows * (cols + PAD));
+
+    for (i = 0; i < rows * (cols + PAD); i++)
+        data[i] = GUARD;
+    matrix_view(m, data, rows, cols, cols + PAD);
+    return data;
+}
+
+static void fill(Matrix *m, int range)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = rand() % (2 * range + 1) - range;
+}
+
+static int guards_intact(const Matrix *m)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = m->cols; j < m->stride; j++)
+            if (MAT_AT(m, i, j) != GUARD)
+                return 0;
+    return 1;
+}
+
+// op(X)(i, j) for a possibly transposed operand
+static int op_at(const Matrix *X, int trans, int i, int j)
+{
+    return trans ? MAT_AT(X, j, i) : MAT_AT(X, i, j);
+}
+
+// R = alpha * op(A) * op(B) (+ R0), the reference
+static void reference(Matrix *R, const Matrix *R0, int alpha, const Matrix *A, int ta, const Matrix *B, int tb, int K)
+{
+    int i, j, k;
+
+    for (i = 0; i < R->rows; i++)
+    {
+        for (j = 0; j < R->cols; j++)
+        {
+            int sum = 0;
+            for (k = 0; k < K; k++)
+                sum += op_at(A, ta, i, k) * op_at(B, tb, k, j);
+            MAT_AT(R, i, j) = alpha * sum + (R0 != NULL ? MAT_AT(R0, i, j) : 0);
+        }
+    }
+}
+
+static int same(const Matrix *X, const Matrix *Y)
+{
+    int i, j;
+
+    for (i = 0; i < X->rows; i++)
+        for (j = 0; j < X->cols; j++)
+            if (MAT_AT(X, i, j) != MAT_AT(Y, i, j))
+                return 0;
+    return 1;
+}
+
+static void test_gemm(const char *set, int M, int K, int N)
+{
+    Matrix A, B, C, R;
+    int *a = alloc_view(&A, M, K), *b = alloc_view(&B, K, N);
+    int *c = alloc_view(&C, M, N), *r = alloc_view(&R, M, N);
+
+    fill(&A, 100);
+    fill(&B, 100);
+    reference(&R, NULL, 1, &A, 0, &B, 0, K);
+    if (matrix_gemm(&C, &A, &B) != 0 || !same(&C, &R) || !guards_intact(&C))
+    {
+        fprintf(stderr, "matrix_gemm %s %dx%dx%d\n", set, M, K, N);
+        CHECK(0);
+    }
+    free(a);
+    free(b);
+    free(c);
+    free(r);
+}
+
+static void test_gemm_ex(const char *set, int M, int K, int N)
+{
+    static const int alphas[] = {1, -3};
+    Matrix A, B, C, C0, R;
+    int *a, *b, *c = alloc_view(&C, M, N), *c0 = alloc_view(&C0, M, N), *r = alloc_view(&R, M, N);
+    int ta, tb, x, acc;
+
+    fill(&C0, 1000);
+    for (ta = 0; ta < 2; ta++)
+    {
+        for (tb = 0; tb < 2; tb++)
+        {
+            // Transposed operands are stored the other way round
+            a = ta ? alloc_view(&A, K, M) : alloc_view(&A, M, K);
+            b = tb ? alloc_view(&B, N, K) : alloc_view(&B, K, N);
+            fill(&A, 100);
+            fill(&B, 100);
+            for (x = 0; x < 2; x++)
+            {
+                for (acc = 0; acc < 2; acc++)
+                {
+                    matrix_copy(&C, &C0);
+                    reference(&R, acc ? &C0 : NULL, alphas[x], &A, ta, &B, tb, K);
+                    if (matrix_gemm_ex(&C, alphas[x], &A, ta, &B, tb, acc) != 0 || !same(&C, &R) ||
+                        !guards_intact(&C))
+                    {
+                        fprintf(stderr, "matrix_gemm_ex %s %dx%dx%d ta %d tb %d alpha %d acc %d\n", set, M, K, N,
+                                ta, tb, alphas[x], acc);
+                        CHECK(0);
+                    }
+                }
+            }
+            free(a);
+            free(b);
+        }
+    }
+    free(c);
+    free(c0);
+    free(r);
+}
+
+static void test_gemm_s16(const char *set, int M, int K, int N)
+{
+    MatrixS16 A, B;
+    Matrix C, R;
+    int16_t *a = (int16_t *)malloc(sizeof(int16_t) * M * (K + PAD));
+    int16_t *b = (int16_t *)malloc(sizeof(int16_t) * K * (N + PAD));
+    int *c = alloc_view(&C, M, N), *r = alloc_view(&R, M, N);
+    int i, j, k;
+
+    A.rows = M;
+    A.cols = K;
+    A.stride = K + PAD;
+    A.data = a;
+    B.rows = K;
+    B.cols = N;
+    B.stride = N + PAD;
+    B.data = b;
+    for (i = 0; i < M; i++)
+        for (k = 0; k < K; k++)
+            MAT_AT(&A, i, k) = (int16_t)(rand() % 2001 - 1000);
+    for (k = 0; k < K; k++)
+        for (j = 0; j < N; j++)
+            MAT_AT(&B, k, j) = (int16_t)(rand() % 2001 - 1000);
+    for (i = 0; i < M; i++)
+    {
+        for (j = 0; j < N; j++)
+        {
+            int sum = 0;
+            for (k = 0; k < K; k++)
+                sum += MAT_AT(&A, i, k) * MAT_AT(&B, k, j);
+            MAT_AT(&R, i, j) = sum;
+        }
+    }
+    if (matrix_gemm_s16(&C, &A, &B) != 0 || !same(&C, &R) || !guards_intact(&C))
+    {
+        fprintf(stderr, "matrix_gemm_s16 %s %dx%dx%d\n", set, M, K, N);
+        CHECK(0);
+    }
+    free(a);
+    free(b);
+    free(c);
+    free(r);
+}
+
+static void test_gemm_f32(const char *set, int M, int K, int N)
+{
+    MatrixF A, B, C;
+    float *a = (float *)malloc(sizeof(float) * M * (K + PAD));
+    float *b = (float *)malloc(sizeof(float) * K * (N + PAD));
+    float *c = (float *)malloc(sizeof(float) * M * (N + PAD));
+    int i, j, k, bad = 0;
+
+    A.rows = M;
+    A.cols = K;
+    A.stride = K + PAD;
+    A.data = a;
+    B.rows = K;
+    B.cols = N;
+    B.stride = N + PAD;
+    B.data = b;
+    C.rows = M;
+    C.cols = N;
+    C.stride = N + PAD;
+    C.data = c;
+    // Small integers keep every partial sum exact in float, whatever the
+    // kernel's summation order
+    for (i = 0; i < M; i++)
+        for (k = 0; k < K; k++)
+            MAT_AT(&A, i, k) = (float)(rand() % 33 - 16);
+    for (k = 0; k < K; k++)
+        for (j = 0; j < N; j++)
+            MAT_AT(&B, k, j) = (float)(rand() % 33 - 16);
+    for (i = 0; i < M * (N + PAD); i++)
+        c[i] = -1.0f;
+    if (matrix_gemm_f32(&C, &A, &B) != 0)
+        bad = 1;
+    for (i = 0; i < M && !bad; i++)
+    {
+        for (j = 0; j < N; j++)
+        {
+            float sum = 0;
+            for (k = 0; k < K; k++)
+                sum += MAT_AT(&A, i, k) * MAT_AT(&B, k, j);
+            bad |= MAT_AT(&C, i, j) != sum;
+        }
+        for (j = N; j < N + PAD; j++)
+            bad |= MAT_AT(&C, i, j) != -1.0f;
+    }
+    if (bad)
+    {
+        fprintf(stderr, "matrix_gemm_f32 %s %dx%dx%d\n", set, M, K, N);
+        CHECK(0);
+    }
+    free(a);
+    free(b);
+    free(c);
+}
+
+static void test_shapes(void)
+{
+    Matrix A, B, C;
+    int a[6], b[6], c[6];
+
+    matrix_view(&A, a, 2, 3, 3);
+    matrix_view(&B, b, 2, 3, 3);
+    matrix_view(&C, c, 2, 3, 3);
+    CHECK(matrix_gemm(&C, &A, &B) == -1);
+    CHECK(matrix_gemm_ex(&C, 1, &A, 0, &B, 1, 0) == -1);
+}
+
+int main(void)
+{
+    int s, i, sets = 0;
+
+    // More workers than this machine may have CPUs, so the pooled split of
+    // the larger shapes runs everywhere
+    matrix_pool_init(4);
+    srand(1);
+    for (s = 0; s < (int)(sizeof(kernel_sets) / sizeof(kernel_sets[0])); s++)
+    {
+        if (matrix_kernels_select(kernel_sets[s]) != 0)
+            continue;
+        sets++;
+        for (i = 0; i < (int)(sizeof(shapes) / sizeof(shapes[0])); i++)
+        {
+            test_gemm(kernel_sets[s], shapes[i][0], shapes[i][1], shapes[i][2]);
+            test_gemm_ex(kernel_sets[s], shapes[i][0], shapes[i][1], shapes[i][2]);
+            test_gemm_s16(kernel_sets[s], shapes[i][0], shapes[i][1], shapes[i][2]);
+            test_gemm_f32(kernel_sets[s], shapes[i][0], shapes[i][1], shapes[i][2]);
+        }
+    }
+    CHECK(sets > 0);
+    test_shapes();
+    matrix_pool_shutdown();
+    if (failures)
+    {
+        fprintf(stderr, "test_gemm: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_gemm: ok (%d kernel sets)\n", sets);
+    return 0;
+}
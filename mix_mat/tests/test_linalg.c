@@ -0,0 +1,201 @@
+// LU, Cholesky, triangular solves, determinant and inverse on orders around
+// the panel width, checked by residuals against known solutions.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrix_linalg.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+#define TOL 1e-3
+
+static float frand(void)
+{
+    return (float)(rand() % 2001 - 1000) / 1000.0f;
+}
+
+// Random A with its diagonal lifted so it is well conditioned; 'spd' makes
+// it M * M^T + n * I instead
+static void make_matrix(MatrixF *A, int n, int spd)
+{
+    MatrixF M;
+    int i, j, k;
+
+    matrix_create_f32(&M, n, n);
+    for (i = 0; i < n * n; i++)
+        M.data[i] = frand();
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; j < n; j++)
+        {
+            float v = MAT_AT(&M, i, j);
+            if (spd)
+                for (v = 0, k = 0; k < n; k++)
+                    v += MAT_AT(&M, i, k) * MAT_AT(&M, j, k);
+            MAT_AT(A, i, j) = v + (i == j ? n : 0);
+        }
+    }
+    matrix_free_f32(&M);
+}
+
+// Largest |A * X - B| entry relative to the largest |B|
+static double residual(const MatrixF *A, const MatrixF *X, const MatrixF *B)
+{
+    double worst = 0, scale = 1e-30;
+    int i, j, k;
+
+    for (i = 0; i < B->rows; i++)
+    {
+        for (j = 0; j < B->cols; j++)
+        {
+            double sum = 0;
+            for (k = 0; k < A->cols; k++)
+                sum += (double)MAT_AT(A, i, k) * MAT_AT(X, k, j);
+            worst = fmax(worst, fabs(sum - MAT_AT(B, i, j)));
+            scale = fmax(scale, fabs(MAT_AT(B, i, j)));
+        }
+    }
+    return worst / scale;
+}
+
+static void copy_f32(MatrixF *dst, const MatrixF *src)
+{
+    int i, j;
+
+    for (i = 0; i < src->rows; i++)
+        for (j = 0; j < src->cols; j++)
+            MAT_AT(dst, i, j) = MAT_AT(src, i, j);
+}
+
+static void test_solves(int n, int nrhs)
+{
+    MatrixF A, F, B, X;
+    MatrixArena arena;
+    int *piv = (int *)malloc(sizeof(int) * n), i;
+
+    matrix_create_f32(&A, n, n);
+    matrix_create_f32(&F, n, n);
+    matrix_create_f32(&B, n, nrhs);
+    matrix_create_f32(&X, n, nrhs);
+    for (i = 0; i < n * nrhs; i++)
+        B.data[i] = frand();
+    matrix_arena_init(&arena, 0);
+
+    make_matrix(&A, n, 0);
+    copy_f32(&F, &A);
+    CHECK(matrix_lu(&F, piv, &arena) == 0);
+    CHECK(arena.used == 0);
+    copy_f32(&X, &B);
+    CHECK(matrix_lu_solve(&F, piv, &X) == 0);
+    if (residual(&A, &X, &B) > TOL)
+    {
+        fprintf(stderr, "LU solve n %d: residual %g\n", n, residual(&A, &X, &B));
+        CHECK(0);
+    }
+
+    make_matrix(&A, n, 1);
+    copy_f32(&F, &A);
+    CHECK(matrix_cholesky(&F, &arena) == 0);
+    copy_f32(&X, &B);
+    CHECK(matrix_cholesky_solve(&F, &X) == 0);
+    if (residual(&A, &X, &B) > TOL)
+    {
+        fprintf(stderr, "Cholesky solve n %d: residual %g\n", n, residual(&A, &X, &B));
+        CHECK(0);
+    }
+
+    matrix_arena_destroy(&arena);
+    matrix_free_f32(&A);
+    matrix_free_f32(&F);
+    matrix_free_f32(&B);
+    matrix_free_f32(&X);
+    free(piv);
+}
+
+static void test_inverse(int n)
+{
+    MatrixF A, inv, I;
+    int i;
+
+    matrix_create_f32(&A, n, n);
+    matrix_create_f32(&inv, n, n);
+    matrix_create_f32(&I, n, n);
+    make_matrix(&A, n, 0);
+    for (i = 0; i < n * n; i++)
+        I.data[i] = i % (n + 1) == 0;
+    CHECK(matrix_inverse(&inv, &A, NULL) == 0);
+    CHECK(residual(&A, &inv, &I) < TOL);
+    // In place
+    CHECK(matrix_inverse(&inv, &inv, NULL) == 0);
+    for (i = 0; i < n * n; i++)
+        CHECK(fabs(inv.data[i] - A.data[i]) < TOL * n);
+    matrix_free_f32(&A);
+    matrix_free_f32(&inv);
+    matrix_free_f32(&I);
+}
+
+static void test_det(void)
+{
+    // det of a triangular matrix is its diagonal product; swapping two rows
+    // negates it
+    float t[16] = {2, 5, -1, 3, 0, -3, 4, 1, 0, 0, 0.5f, 7, 0, 0, 0, 4};
+    float s[16] = {0, 0, 0.5f, 7, 0, -3, 4, 1, 2, 5, -1, 3, 0, 0, 0, 4};
+    float z[9] = {1, 2, 3, 2, 4, 6, 1, 0, 1};
+    MatrixF T = {4, 4, 4, t}, S = {4, 4, 4, s}, Z = {3, 3, 3, z};
+    MatrixF inv;
+    double det;
+    int piv[3];
+
+    CHECK(matrix_det(&T, &det, NULL) == 0 && fabs(det - -12.0) < 1e-4);
+    CHECK(matrix_det(&S, &det, NULL) == 0 && fabs(det - 12.0) < 1e-4);
+    CHECK(matrix_det(&Z, &det, NULL) == 0 && det == 0);
+    matrix_create_f32(&inv, 3, 3);
+    CHECK(matrix_inverse(&inv, &Z, NULL) == 1);
+    CHECK(matrix_lu(&Z, piv, NULL) == 1);
+    matrix_free_f32(&inv);
+}
+
+static void test_errors(void)
+{
+    float a[6] = {4, 2, 2, 1, 0, 0};
+    MatrixF R = {2, 3, 3, a}, N = {2, 2, 2, a};
+    int piv[2];
+
+    CHECK(matrix_lu(&R, piv, NULL) == -1);
+    CHECK(matrix_cholesky(&R, NULL) == -1);
+    // [[4, 2], [2, 1]] is only semi-definite
+    CHECK(matrix_cholesky(&N, NULL) == 1);
+}
+
+int main(void)
+{
+    static const int orders[] = {1, 5, 31, 32, 33, 70, 100};
+    int i;
+
+    srand(1);
+    for (i = 0; i < (int)(sizeof(orders) / sizeof(orders[0])); i++)
+    {
+        test_solves(orders[i], 1);
+        test_solves(orders[i], 9);
+        test_inverse(orders[i]);
+    }
+    test_det();
+    test_errors();
+    if (failures)
+    {
+        fprintf(stderr, "test_linalg: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_linalg: ok\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+// matrix_gemm_mod() against a reference reduced after every term, for small
+// and near-2^31 moduli and a K long enough to need batched reduction.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "matrix_mod.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static uint32_t random_below(uint32_t p)
+{
+    return (uint32_t)((((uint64_t)rand() << 31) ^ (uint64_t)rand()) % p);
+}
+
+static void test_product(uint32_t p, int M, int K, int N)
+{
+    MatrixModulus mod;
+    Matrix A, B, C;
+    int i, j, k, bad = 0;
+
+    CHECK(matrix_modulus_init(&mod, p) == 0);
+    matrix_create(&A, M, K);
+    matrix_create(&B, K, N);
+    matrix_create(&C, M, N);
+    // Largest residues first, so the worst case sums are exercised
+    for (i = 0; i < M * K; i++)
+        A.data[i] = (int)(i < K ? p - 1 : random_below(p));
+    for (i = 0; i < K * N; i++)
+        B.data[i] = (int)(i % N == 0 ? p - 1 : random_below(p));
+
+    CHECK(matrix_gemm_mod(&C, &A, &B, &mod) == 0);
+    for (i = 0; i < M; i++)
+    {
+        for (j = 0; j < N; j++)
+        {
+            uint64_t sum = 0;
+            for (k = 0; k < K; k++)
+                sum = (sum + (uint64_t)(uint32_t)MAT_AT(&A, i, k) * (uint32_t)MAT_AT(&B, k, j) % p) % p;
+            bad += (uint64_t)(uint32_t)MAT_AT(&C, i, j) != sum;
+        }
+    }
+    if (bad)
+    {
+        fprintf(stderr, "p %u %dx%dx%d: %d wrong\n", p, M, K, N, bad);
+        CHECK(0);
+    }
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&C);
+}
+
+static void test_canonical(void)
+{
+    MatrixModulus mod;
+    int d[6] = {-1, -7, 7, 0, -2147483647 - 1, 2147483647};
+    Matrix m;
+
+    matrix_modulus_init(&mod, 7);
+    matrix_view(&m, d, 2, 3, 3);
+    matrix_mod_canonical(&m, &mod);
+    // -2^31 = -306783379 * 7 + 5 and 2^31 - 1 = 306783378 * 7 + 1
+    CHECK(d[0] == 6 && d[1] == 0 && d[2] == 0 && d[3] == 0 && d[4] == 5 && d[5] == 1);
+}
+
+static void test_moduli(void)
+{
+    MatrixModulus mod;
+
+    CHECK(matrix_modulus_init(&mod, 0) == -1);
+    CHECK(matrix_modulus_init(&mod, 1) == -1);
+    CHECK(matrix_modulus_init(&mod, 2) == 0);
+    CHECK(matrix_modulus_init(&mod, 0x7FFFFFFF) == 0);
+    CHECK(matrix_modulus_init(&mod, 0x80000000u) == -1);
+}
+
+int main(void)
+{
+    srand(1);
+    test_moduli();
+    test_canonical();
+    test_product(2, 7, 9, 11);
+    test_product(1000000007, 33, 65, 70);
+    test_product(0x7FFFFFFF, 20, 37, 130);
+    test_product((1u << 26) + 15, 3, 5000, 4);
+    test_product(0x7FFFFFFF, 2, 9000, 3);
+    if (failures)
+    {
+        fprintf(stderr, "test_mod: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_mod: ok\n");
+    return 0;
+}
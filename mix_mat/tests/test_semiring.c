@@ -0,0 +1,123 @@
+// Semiring products and APSP: "no edge" infinities in either operand must
+// absorb, also next to negative weights.
+#include <stdio.h>
+#include "matrix_semiring.h"
+
+#define INF MATRIX_SR_INF
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static void test_max_plus_square(void)
+{
+    int a[4] = {5, -INF, -INF, 5}, c[4];
+    Matrix A, C;
+
+    matrix_view(&A, a, 2, 2, 2);
+    matrix_view(&C, c, 2, 2, 2);
+    CHECK(matrix_gemm_max_plus(&C, &A, &A) == 0);
+    CHECK(c[0] == 10 && c[3] == 10);
+    CHECK(c[1] == -INF && c[2] == -INF);
+}
+
+static void test_min_plus_inf_in_b(void)
+{
+    // Row of A is finite, column of B is all missing edges
+    int a[4] = {-3, -7, 0, 2}, b[4] = {INF, 1, INF, -4}, c[4];
+    Matrix A, B, C;
+
+    matrix_view(&A, a, 2, 2, 2);
+    matrix_view(&B, b, 2, 2, 2);
+    matrix_view(&C, c, 2, 2, 2);
+    CHECK(matrix_gemm_min_plus(&C, &A, &B) == 0);
+    CHECK(c[0] == INF && c[2] == INF);
+    CHECK(c[1] == -11 && c[3] == -2);
+}
+
+static void test_max_min_inf(void)
+{
+    int a[4] = {3, -INF, -INF, 4}, b[4] = {-INF, 6, 2, -INF}, c[4];
+    Matrix A, B, C;
+
+    matrix_view(&A, a, 2, 2, 2);
+    matrix_view(&B, b, 2, 2, 2);
+    matrix_view(&C, c, 2, 2, 2);
+    CHECK(matrix_gemm_max_min(&C, &A, &B) == 0);
+    CHECK(c[0] == -INF && c[1] == 3 && c[2] == 2 && c[3] == -INF);
+}
+
+static void test_apsp_negative_edge(void)
+{
+    int w[9] = {0, -2, INF, INF, 0, INF, INF, INF, 0}, d[9];
+    Matrix W, D;
+
+    matrix_view(&W, w, 3, 3, 3);
+    matrix_view(&D, d, 3, 3, 3);
+    CHECK(matrix_apsp(&D, &W, NULL) == 0);
+    CHECK(d[1] == -2);
+    CHECK(d[2] == INF && d[3] == INF && d[5] == INF && d[6] == INF && d[7] == INF);
+}
+
+static void test_apsp_chain(void)
+{
+    // 0 -> 1 -> 2 -> 3 with a negative middle edge, nothing leads back
+    int w[16], d[16], i;
+    Matrix W, D;
+
+    for (i = 0; i < 16; i++)
+        w[i] = i % 5 == 0 ? 0 : INF;
+    w[1] = 4;
+    w[6] = -1;
+    w[11] = 2;
+    matrix_view(&W, w, 4, 4, 4);
+    matrix_view(&D, d, 4, 4, 4);
+    CHECK(matrix_apsp(&D, &W, NULL) == 0);
+    CHECK(d[2] == 3 && d[3] == 5 && d[7] == 1);
+    CHECK(d[4] == INF && d[8] == INF && d[12] == INF && d[13] == INF && d[14] == INF);
+}
+
+static void test_apsp_used_arena(void)
+{
+    int w[9] = {0, 1, INF, INF, 0, 1, INF, INF, 0}, d[9];
+    MatrixArena arena;
+    Matrix W, D;
+
+    // Capacity covers the spare matrix but the free part does not
+    matrix_arena_init(&arena, matrix_arena_footprint(9 * sizeof(int)));
+    CHECK(matrix_arena_alloc(&arena, 64) != NULL);
+    matrix_view(&W, w, 3, 3, 3);
+    matrix_view(&D, d, 3, 3, 3);
+    CHECK(matrix_apsp(&D, &W, &arena) == -1);
+
+    matrix_arena_reset(&arena);
+    CHECK(matrix_apsp(&D, &W, &arena) == 0);
+    CHECK(d[2] == 2 && d[6] == INF);
+    CHECK(arena.used == 0);
+    matrix_arena_destroy(&arena);
+}
+
+int main(void)
+{
+    test_max_plus_square();
+    test_min_plus_inf_in_b();
+    test_max_min_inf();
+    test_apsp_negative_edge();
+    test_apsp_chain();
+    test_apsp_used_arena();
+    if (failures)
+    {
+        fprintf(stderr, "test_semiring: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_semiring: ok\n");
+    return 0;
+}
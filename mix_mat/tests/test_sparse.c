@@ -0,0 +1,150 @@
+// CSR/CSC builders and kernels, and the density routing of
+// matrix_multiply_auto(), against dense products.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_sparse.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+// Roughly 'percent' nonzeros in -9..9
+static void fill_sparse(Matrix *m, int percent)
+{
+    int i, j;
+
+    for (i = 0; i < m->rows; i++)
+        for (j = 0; j < m->cols; j++)
+            MAT_AT(m, i, j) = rand() % 100 < percent ? rand() % 19 - 9 : 0;
+}
+
+static int same(const Matrix *X, const Matrix *Y)
+{
+    int i;
+
+    for (i = 0; i < X->rows; i++)
+        if (memcmp(X->data + i * X->stride, Y->data + i * Y->stride, sizeof(int) * X->cols) != 0)
+            return 0;
+    return 1;
+}
+
+static void test_kernels(int M, int K, int N, int percent)
+{
+    Matrix A, B, C, R, D;
+    MatrixCSR csr;
+    MatrixCSC csc;
+    MatrixArena arena;
+    int *x = (int *)malloc(sizeof(int) * K), *y = (int *)malloc(sizeof(int) * M);
+    int *yr = (int *)malloc(sizeof(int) * M), i, k;
+
+    matrix_create(&A, M, K);
+    matrix_create(&B, K, N);
+    matrix_create(&C, M, N);
+    matrix_create(&R, M, N);
+    matrix_create(&D, M, K);
+    fill_sparse(&A, percent);
+    fill_sparse(&B, percent);
+    matrix_gemm(&R, &A, &B);
+    for (k = 0; k < K; k++)
+        x[k] = rand() % 19 - 9;
+    for (i = 0; i < M; i++)
+    {
+        yr[i] = 0;
+        for (k = 0; k < K; k++)
+            yr[i] += MAT_AT(&A, i, k) * x[k];
+    }
+
+    CHECK(matrix_csr_from_dense(&csr, &A, NULL) == 0);
+    CHECK(matrix_csr_to_dense(&D, &csr) == 0 && same(&D, &A));
+    CHECK(matrix_csr_spmv(y, &csr, x) == 0 && memcmp(y, yr, sizeof(int) * M) == 0);
+    CHECK(matrix_csr_spmm(&C, &csr, &B) == 0 && same(&C, &R));
+    matrix_csr_free(&csr);
+
+    // CSC SpMM takes the sparse operand on the right
+    CHECK(matrix_csc_from_dense(&csc, &B, NULL) == 0);
+    CHECK(matrix_csc_spmm(&C, &A, &csc) == 0 && same(&C, &R));
+    matrix_csc_free(&csc);
+    CHECK(matrix_csc_from_dense(&csc, &A, NULL) == 0);
+    CHECK(matrix_csc_spmv(y, &csc, x) == 0 && memcmp(y, yr, sizeof(int) * M) == 0);
+    matrix_csc_free(&csc);
+
+    // Arena-backed builder, and the density router (which grows an empty
+    // arena itself)
+    matrix_arena_init(&arena, 1 << 20);
+    if (matrix_csr_from_dense(&csr, &A, &arena) != 0)
+        CHECK(0);
+    else
+        CHECK(matrix_csr_spmm(&C, &csr, &B) == 0 && same(&C, &R));
+    matrix_arena_destroy(&arena);
+    matrix_arena_init(&arena, 0);
+    memset(C.data, 0x5A, sizeof(int) * M * N);
+    CHECK(matrix_multiply_auto(&C, &A, &B, &arena) == 0 && same(&C, &R));
+    memset(C.data, 0x5A, sizeof(int) * M * N);
+    CHECK(matrix_multiply_auto(&C, &A, &B, NULL) == 0 && same(&C, &R));
+    matrix_arena_destroy(&arena);
+
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&C);
+    matrix_free(&R);
+    matrix_free(&D);
+    free(x);
+    free(y);
+    free(yr);
+}
+
+static void test_triplets(void)
+{
+    // Duplicates add up; row 1 and column 2 stay empty
+    int row[5] = {0, 2, 0, 2, 0}, col[5] = {1, 0, 1, 3, 0}, val[5] = {4, -2, 3, 7, 1};
+    int want[12] = {1, 7, 0, 0, 0, 0, 0, 0, -2, 0, 0, 7};
+    int b[8] = {1, 2, 3, 4, 5, 6, 7, 8}, c[6], r[6] = {22, 30, 0, 0, 47, 52};
+    Matrix D, B, C;
+    MatrixCSR csr;
+    MatrixCSC csc;
+    int d[12];
+
+    matrix_view(&D, d, 3, 4, 4);
+    CHECK(matrix_csr_from_triplets(&csr, 3, 4, 5, row, col, val, NULL) == 0);
+    CHECK(matrix_csr_to_dense(&D, &csr) == 0 && memcmp(d, want, sizeof(d)) == 0);
+    matrix_view(&B, b, 4, 2, 2);
+    matrix_view(&C, c, 3, 2, 2);
+    CHECK(matrix_csr_spmm(&C, &csr, &B) == 0 && memcmp(c, r, sizeof(c)) == 0);
+    matrix_csr_free(&csr);
+
+    CHECK(matrix_csc_from_triplets(&csc, 3, 4, 5, row, col, val, NULL) == 0);
+    {
+        int x[4] = {1, 1, 1, 1}, y[3];
+        CHECK(matrix_csc_spmv(y, &csc, x) == 0 && y[0] == 8 && y[1] == 0 && y[2] == 5);
+    }
+    matrix_csc_free(&csc);
+
+    row[0] = 3;
+    CHECK(matrix_csr_from_triplets(&csr, 3, 4, 5, row, col, val, NULL) == -1);
+}
+
+int main(void)
+{
+    srand(1);
+    test_kernels(1, 1, 1, 100);
+    test_kernels(37, 53, 29, 5);
+    test_kernels(64, 200, 96, 2);
+    test_kernels(40, 40, 40, 60);
+    test_triplets();
+    if (failures)
+    {
+        fprintf(stderr, "test_sparse: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_sparse: ok\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+// matrix_strassen() against matrix_gemm() on odd and even orders, strided
+// views, and the arena contract.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_strassen.h"
+
+static int failures;
+
+#define CHECK(cond)                                                       \
+    do                                                                    \
+    {                                                                     \
+        if (!(cond))                                                      \
+        {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                   \
+        }                                                                 \
+    } while (0)
+
+static int same(const Matrix *X, const Matrix *Y)
+{
+    int i;
+
+    for (i = 0; i < X->rows; i++)
+        if (memcmp(X->data + i * X->stride, Y->data + i * Y->stride, sizeof(int) * X->cols) != 0)
+            return 0;
+    return 1;
+}
+
+static void test_orders(void)
+{
+    // Views into wider buffers so every operand has stride != n
+    static int a[40 * 43], b[40 * 43], c[40 * 43], r[40 * 43];
+    Matrix A, B, C, R;
+    int n, x, i;
+
+    srand(1);
+    for (i = 0; i < 40 * 43; i++)
+    {
+        a[i] = rand() % 2001 - 1000;
+        b[i] = rand() % 2001 - 1000;
+    }
+    for (n = 1; n <= 40; n++)
+    {
+        matrix_view(&A, a, n, n, 43);
+        matrix_view(&B, b, n, n, 43);
+        matrix_view(&C, c, n, n, 43);
+        matrix_view(&R, r, n, n, 43);
+        matrix_gemm(&R, &A, &B);
+        for (x = 1; x <= 5; x++)
+        {
+            memset(c, 0x5A, sizeof(c));
+            if (matrix_strassen(&C, &A, &B, x, NULL) != 0 || !same(&C, &R))
+            {
+                fprintf(stderr, "n = %d, crossover = %d\n", n, x);
+                CHECK(0);
+            }
+        }
+    }
+}
+
+static void test_arena(void)
+{
+    int n = 37, x = 4;
+    size_t bytes = matrix_strassen_scratch(n, x);
+    MatrixArena arena;
+    Matrix A, B, C, R;
+
+    matrix_create(&A, n, n);
+    matrix_create(&B, n, n);
+    matrix_create(&C, n, n);
+    matrix_create(&R, n, n);
+    memset(A.data, 0, sizeof(int) * n * n);
+    memset(B.data, 0, sizeof(int) * n * n);
+    A.data[0] = 3;
+    B.data[0] = 5;
+    matrix_gemm(&R, &A, &B);
+
+    // The capacity covers the scratch but the free part does not, and an
+    // arena in use cannot grow
+    matrix_arena_init(&arena, bytes);
+    CHECK(matrix_arena_alloc(&arena, 64) != NULL);
+    CHECK(matrix_strassen(&C, &A, &B, x, &arena) == -1);
+    CHECK(arena.used == matrix_arena_footprint(64));
+
+    // An empty arena grows once, then is handed back as it was
+    matrix_arena_reset(&arena);
+    matrix_arena_destroy(&arena);
+    matrix_arena_init(&arena, 0);
+    CHECK(matrix_strassen(&C, &A, &B, x, &arena) == 0 && same(&C, &R));
+    CHECK(arena.used == 0 && arena.capacity >= bytes);
+
+    // Room after a live allocation is enough
+    matrix_arena_destroy(&arena);
+    matrix_arena_init(&arena, bytes + 64);
+    CHECK(matrix_arena_alloc(&arena, 64) != NULL);
+    CHECK(matrix_strassen(&C, &A, &B, x, &arena) == 0 && same(&C, &R));
+    CHECK(arena.used == matrix_arena_footprint(64));
+
+    matrix_arena_destroy(&arena);
+    matrix_free(&A);
+    matrix_free(&B);
+    matrix_free(&C);
+    matrix_free(&R);
+}
+
+int main(void)
+{
+    test_orders();
+    test_arena();
+    if (failures)
+    {
+        fprintf(stderr, "test_strassen: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_strassen: ok\n");
+    return 0;
+}